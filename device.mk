@@ -106,7 +106,6 @@ PRODUCT_PACKAGES += \
 
 # These are the OpenMAX IL configuration files
 PRODUCT_COPY_FILES += \
-    device/samsung/galaxys/sec_mm/sec_omx/sec_omx_core/secomxregistry:system/etc/secomxregistry \
     device/samsung/galaxys/media_profiles.xml:system/etc/media_profiles.xml \
     device/samsung/galaxys/media_codecs.xml:system/etc/media_codecs.xml
 
@@ -118,6 +117,7 @@ PRODUCT_PACKAGES += \
 # These are the OpenMAX IL modules
 PRODUCT_PACKAGES += \
     libSEC_OMX_Core.aries \
+    secomxregistry \
     libOMX.SEC.AVC.Decoder.aries \
     libOMX.SEC.M4V.Decoder.aries \
     libOMX.SEC.M4V.Encoder.aries \
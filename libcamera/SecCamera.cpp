@@ -34,6 +34,7 @@
 #include <sys/poll.h>
 #include "SecCamera.h"
 #include "cutils/properties.h"
+#include <cutils/atomic.h>
 
 using namespace android;
 
@@ -321,14 +322,15 @@ static int fimc_v4l2_enum_fmt(int fp, unsigned int fmt)
     return 0;
 }
 
-static int fimc_v4l2_reqbufs(int fp, enum v4l2_buf_type type, int nr_bufs)
+static int fimc_v4l2_reqbufs(int fp, enum v4l2_buf_type type, int nr_bufs,
+                             enum v4l2_memory memory = V4L2_MEMORY_MMAP)
 {
     struct v4l2_requestbuffers req;
     int ret;
 
     req.count = nr_bufs;
     req.type = type;
-    req.memory = V4L2_MEMORY_MMAP;
+    req.memory = memory;
 
     ret = ioctl(fp, VIDIOC_REQBUFS, &req);
     if (ret < 0) {
@@ -417,13 +419,33 @@ static int fimc_v4l2_qbuf(int fp, int index)
     return 0;
 }
 
-static int fimc_v4l2_dqbuf(int fp)
+static int fimc_v4l2_qbuf_userptr(int fp, int index, fimc_user_buffer *buf)
 {
     struct v4l2_buffer v4l2_buf;
     int ret;
 
     v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
-    v4l2_buf.memory = V4L2_MEMORY_MMAP;
+    v4l2_buf.memory = V4L2_MEMORY_USERPTR;
+    v4l2_buf.index = index;
+    v4l2_buf.m.userptr = (unsigned long)buf;
+    v4l2_buf.length = buf->length[0] + buf->length[1] + buf->length[2];
+
+    ret = ioctl(fp, VIDIOC_QBUF, &v4l2_buf);
+    if (ret < 0) {
+        ALOGE("ERR(%s):VIDIOC_QBUF failed\n", __func__);
+        return ret;
+    }
+
+    return 0;
+}
+
+static int fimc_v4l2_dqbuf(int fp, enum v4l2_memory memory = V4L2_MEMORY_MMAP)
+{
+    struct v4l2_buffer v4l2_buf;
+    int ret;
+
+    v4l2_buf.type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
+    v4l2_buf.memory = memory;
 
     ret = ioctl(fp, VIDIOC_DQBUF, &v4l2_buf);
     if (ret < 0) {
@@ -451,11 +473,16 @@ static int fimc_v4l2_g_ctrl(int fp, unsigned int id)
     return ctrl.value;
 }
 
+/* control ioctls issued so far, each one may end up as sensor i2c traffic */
+static volatile int32_t gDriverCalls = 0;
+
 static int fimc_v4l2_s_ctrl(int fp, unsigned int id, unsigned int value)
 {
     struct v4l2_control ctrl;
     int ret;
 
+    android_atomic_inc(&gDriverCalls);
+
     ctrl.id = id;
     ctrl.value = value;
 
@@ -483,6 +510,7 @@ static int fimc_v4l2_s_ext_ctrl(int fp, unsigned int id, void *value)
     ctrls.count = 1;
     ctrls.controls = &ctrl;
 
+    android_atomic_inc(&gDriverCalls);
     ret = ioctl(fp, VIDIOC_S_EXT_CTRLS, &ctrls);
     if (ret < 0)
         ALOGE("ERR(%s):VIDIOC_S_EXT_CTRLS failed\n", __func__);
@@ -515,6 +543,7 @@ static int fimc_v4l2_s_parm(int fp, struct v4l2_streamparm *streamparm)
 
     streamparm->type = V4L2_BUF_TYPE_VIDEO_CAPTURE;
 
+    android_atomic_inc(&gDriverCalls);
     ret = ioctl(fp, VIDIOC_S_PARM, streamparm);
     if (ret < 0) {
         ALOGE("ERR(%s):VIDIOC_S_PARM failed\n", __func__);
@@ -535,6 +564,7 @@ SecCamera::SecCamera() :
             m_preview_height     (0),
             m_preview_max_width  (MAX_BACK_CAMERA_PREVIEW_WIDTH),
             m_preview_max_height (MAX_BACK_CAMERA_PREVIEW_HEIGHT),
+            m_preview_user_count(0),
             m_snapshot_v4lformat(-1),
             m_snapshot_width      (0),
             m_snapshot_height     (0),
@@ -567,9 +597,16 @@ SecCamera::SecCamera() :
             m_jpeg_thumbnail_width (0),
             m_jpeg_thumbnail_height(0),
             m_jpeg_quality(100),
+            m_jpeg_enc(NULL),
+            m_jpeg_enc_width(-1),
+            m_jpeg_enc_height(-1),
+            m_jpeg_enc_sampling(-1),
+            m_jpeg_enc_quality(-1),
             m_capture_bufs(NULL),
             m_capture_bufs_size(0),
-            m_capture_burst(false)
+            m_capture_burst(false),
+            m_capture_direct(false),
+            m_capture_direct_buf(NULL)
 #ifdef ENABLE_ESD_PREVIEW_CHECK
             ,
             m_esd_check_count(0)
@@ -670,6 +707,15 @@ int SecCamera::initCamera(int index)
 
         setExifFixedAttribute();
 
+        /* opening the jpeg driver maps all its buffers, do it once and not per shot */
+        if (m_jpeg_enc == NULL) {
+            m_jpeg_enc = new JpegEncoder();
+            if (m_jpeg_enc->setConfig(JPEG_SET_ENCODE_IN_FORMAT, JPG_MODESEL_YCBCR) != JPG_SUCCESS)
+                ALOGE("ERR(%s):JPEG encoder is not available", __func__);
+            m_jpeg_enc_width = m_jpeg_enc_height = -1;
+            m_jpeg_enc_sampling = m_jpeg_enc_quality = -1;
+        }
+
         m_flag_init = 1;
     }
     return 0;
@@ -715,6 +761,9 @@ void SecCamera::deinitCamera()
             m_cam_fd2_temp = -1;
         }
 
+        delete m_jpeg_enc;
+        m_jpeg_enc = NULL;
+
         m_flag_init = 0;
     }
 }
@@ -809,7 +858,11 @@ int SecCamera::startPreview(void)
         ret = fimc_v4l2_s_fmt(m_cam_fd, m_preview_height, m_preview_width, m_preview_v4lformat, 0);
     CHECK(ret);
 
-    ret = fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE, MAX_BUFFERS);
+    if (m_preview_user_count > 0)
+        ret = fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE,
+                                m_preview_user_count, V4L2_MEMORY_USERPTR);
+    else
+        ret = fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE, MAX_BUFFERS);
     CHECK(ret);
 
     ALOGV("%s : m_preview_width: %d m_preview_height: %d m_angle: %d\n",
@@ -825,9 +878,18 @@ int SecCamera::startPreview(void)
     }
 
     /* start with all buffers in queue */
-    for (int i = 0; i < MAX_BUFFERS; i++) {
-        ret = fimc_v4l2_qbuf(m_cam_fd, i);
-        CHECK(ret);
+    if (m_preview_user_count > 0) {
+        for (int i = 0; i < m_preview_user_count; i++) {
+            if (!m_preview_user_queued[i])
+                continue;
+            ret = fimc_v4l2_qbuf_userptr(m_cam_fd, i, &m_preview_user_bufs[i]);
+            CHECK(ret);
+        }
+    } else {
+        for (int i = 0; i < MAX_BUFFERS; i++) {
+            ret = fimc_v4l2_qbuf(m_cam_fd, i);
+            CHECK(ret);
+        }
     }
 
     ret = startStream();
@@ -841,6 +903,17 @@ int SecCamera::startPreview(void)
     ret = fimc_v4l2_s_ctrl(m_cam_fd, V4L2_CID_CAMERA_RETURN_FOCUS, 0);
     CHECK(ret);
 
+    /* zoom, gamma and slow AE set while stopped were only stored, send them now */
+    if (m_zoom_level >= 0 &&
+        fimc_v4l2_s_ctrl(m_cam_fd, V4L2_CID_CAMERA_ZOOM, m_zoom_level) < 0)
+        ALOGE("ERR(%s):Fail on V4L2_CID_CAMERA_ZOOM", __func__);
+    if (m_video_gamma >= 0 &&
+        fimc_v4l2_s_ctrl(m_cam_fd, V4L2_CID_CAMERA_SET_GAMMA, m_video_gamma) < 0)
+        ALOGE("ERR(%s):Fail on V4L2_CID_CAMERA_SET_GAMMA", __func__);
+    if (m_slow_ae >= 0 &&
+        fimc_v4l2_s_ctrl(m_cam_fd, V4L2_CID_CAMERA_SET_SLOW_AE, m_slow_ae) < 0)
+        ALOGE("ERR(%s):Fail on V4L2_CID_CAMERA_SET_SLOW_AE", __func__);
+
     ALOGV("%s: got the first frame of the preview\n", __func__);
 
     return 0;
@@ -1033,6 +1106,17 @@ int SecCamera::getPreview()
         }
     }
 
+    if (m_preview_user_count > 0) {
+        /* the buffer goes back with releasePreviewFrame() once the client is done */
+        index = fimc_v4l2_dqbuf(m_cam_fd, V4L2_MEMORY_USERPTR);
+        if (!(0 <= index && index < m_preview_user_count)) {
+            ALOGE("ERR(%s):wrong index = %d", __func__, index);
+            return -1;
+        }
+        m_preview_user_queued[index] = false;
+        return index;
+    }
+
     index = fimc_v4l2_dqbuf(m_cam_fd);
     if (!(0 <= index && index < MAX_BUFFERS)) {
         ALOGE("ERR(%s):wrong index = %d", __func__, index);
@@ -1045,6 +1129,58 @@ int SecCamera::getPreview()
     return index;
 }
 
+/*
+ * Registers client buffers (physically contiguous, e.g. gralloc) as preview
+ * capture destinations for the next startPreview(). count 0 goes back to
+ * the driver's own mmap buffers.
+ */
+int SecCamera::setPreviewUserBuffers(const fimc_user_buffer *bufs, int count)
+{
+    if (m_flag_camera_start > 0) {
+        ALOGE("ERR(%s):Preview is running", __func__);
+        return -1;
+    }
+    if ((count < 0) || (count > MAX_BUFFERS) || ((count > 0) && (bufs == NULL))) {
+        ALOGE("ERR(%s):invalid buffer count %d", __func__, count);
+        return -1;
+    }
+
+    for (int i = 0; i < count; i++) {
+        m_preview_user_bufs[i] = bufs[i];
+        m_preview_user_queued[i] = true;
+    }
+    m_preview_user_count = count;
+
+    return 0;
+}
+
+/*
+ * Queues a preview frame taken by getPreview() back to FIMC. With client
+ * buffers, buf replaces the one the index was captured into.
+ */
+int SecCamera::releasePreviewFrame(int index, const fimc_user_buffer *buf)
+{
+    int ret;
+
+    if (m_preview_user_count == 0)
+        return 0;
+
+    CHECK_FD(m_cam_fd);
+
+    if (!(0 <= index && index < m_preview_user_count)) {
+        ALOGE("ERR(%s):wrong index = %d", __func__, index);
+        return -1;
+    }
+    if (buf != NULL)
+        m_preview_user_bufs[index] = *buf;
+
+    ret = fimc_v4l2_qbuf_userptr(m_cam_fd, index, &m_preview_user_bufs[index]);
+    CHECK(ret);
+    m_preview_user_queued[index] = true;
+
+    return 0;
+}
+
 int SecCamera::getRecordFrame()
 {
     if (m_flag_record_start == 0) {
@@ -1164,18 +1300,40 @@ int SecCamera::beginSnapshot(bool burst)
     CHECK(ret);
 
     nframes = 1;
-    ret = fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE, nframes);
-    CHECK(ret);
-
-    m_capture_bufs = (fimc_buffer *) malloc(sizeof(fimc_buffer) * nframes);
-    m_capture_bufs_size = nframes;
     m_capture_burst = burst;
-    for(int i = 0; i < m_capture_bufs_size; i++) {
-        m_capture_bufs[i].index = i;
-        ret = fimc_v4l2_querybuf(m_cam_fd, &m_capture_bufs[i], V4L2_BUF_TYPE_VIDEO_CAPTURE);
-        CHECK(ret);
-        ret = fimc_v4l2_qbuf(m_cam_fd, i);
+    m_capture_direct = false;
+
+    /* a yuv single shot goes straight into the jpeg input, no copy before encoding */
+    if (!burst && m_snapshot_v4lformat != V4L2_PIX_FMT_JPEG && m_jpeg_enc != NULL) {
+        unsigned int size = m_snapshot_width * m_snapshot_height * 2;
+        fimc_user_buffer buf;
+
+        memset(&buf, 0, sizeof(buf));
+        buf.base[0] = m_jpeg_enc->getPhyInBuf(size);
+        buf.length[0] = size;
+        m_capture_direct_buf = (unsigned char *)m_jpeg_enc->getInBuf(size);
+        if (buf.base[0] != 0 && m_capture_direct_buf != NULL &&
+                fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE, nframes,
+                                  V4L2_MEMORY_USERPTR) >= 0 &&
+                fimc_v4l2_qbuf_userptr(m_cam_fd, 0, &buf) == 0)
+            m_capture_direct = true;
+        else
+            ALOGW("WARN(%s):direct capture not possible, copying the snapshot", __func__);
+    }
+
+    if (!m_capture_direct) {
+        ret = fimc_v4l2_reqbufs(m_cam_fd, V4L2_BUF_TYPE_VIDEO_CAPTURE, nframes);
         CHECK(ret);
+
+        m_capture_bufs = (fimc_buffer *) malloc(sizeof(fimc_buffer) * nframes);
+        m_capture_bufs_size = nframes;
+        for(int i = 0; i < m_capture_bufs_size; i++) {
+            m_capture_bufs[i].index = i;
+            ret = fimc_v4l2_querybuf(m_cam_fd, &m_capture_bufs[i], V4L2_BUF_TYPE_VIDEO_CAPTURE);
+            CHECK(ret);
+            ret = fimc_v4l2_qbuf(m_cam_fd, i);
+            CHECK(ret);
+        }
     }
 
     ret = fimc_v4l2_streamon(m_cam_fd);
@@ -1213,6 +1371,8 @@ int SecCamera::endSnapshot(void)
         free(m_capture_bufs);
         m_capture_bufs = NULL;
     }
+    m_capture_direct = false;
+    m_capture_direct_buf = NULL;
     LOG_TIME_END(0)
 
     LOG_TIME_START(1)
@@ -1288,72 +1448,34 @@ int SecCamera::getJpeg(unsigned int *phyaddr, unsigned char** jpeg_buf,
     return 0;
 }
 
-int SecCamera::getExif(unsigned char *pExifDst, unsigned char *pThumbSrc)
+/*
+ * width and height override the snapshot size, for frames not taken by beginSnapshot.
+ * Leaves the stream of the last encodeJpeg alone.
+ */
+int SecCamera::getExif(unsigned char *pExifDst, int width, int height)
 {
-    JpegEncoder jpgEnc;
+    if (m_jpeg_enc == NULL)
+        return -1;
 
     ALOGV("%s : m_jpeg_thumbnail_width = %d, height = %d",
          __func__, m_jpeg_thumbnail_width, m_jpeg_thumbnail_height);
-    if ((m_jpeg_thumbnail_width > 0) && (m_jpeg_thumbnail_height > 0)) {
-        int inFormat = JPG_MODESEL_YCBCR;
-        int outFormat = JPG_422;
-        switch (m_snapshot_v4lformat) {
-        case V4L2_PIX_FMT_NV12:
-        case V4L2_PIX_FMT_NV21:
-        case V4L2_PIX_FMT_NV12T:
-        case V4L2_PIX_FMT_YUV420:
-            outFormat = JPG_420;
-            break;
-        case V4L2_PIX_FMT_YUYV:
-        case V4L2_PIX_FMT_UYVY:
-        case V4L2_PIX_FMT_YUV422P:
-            outFormat = JPG_422;
-            break;
-        }
-
-        if (jpgEnc.setConfig(JPEG_SET_ENCODE_IN_FORMAT, inFormat) != JPG_SUCCESS)
-            return -1;
-
-        if (jpgEnc.setConfig(JPEG_SET_SAMPING_MODE, outFormat) != JPG_SUCCESS)
-            return -1;
-
-        if (jpgEnc.setConfig(JPEG_SET_ENCODE_QUALITY, JPG_QUALITY_LEVEL_2) != JPG_SUCCESS)
-            return -1;
-
-        int thumbWidth, thumbHeight, thumbSrcSize;
-        getThumbnailConfig(&thumbWidth, &thumbHeight, &thumbSrcSize);
-        if (jpgEnc.setConfig(JPEG_SET_ENCODE_WIDTH, thumbWidth) != JPG_SUCCESS)
-            return -1;
-
-        if (jpgEnc.setConfig(JPEG_SET_ENCODE_HEIGHT, thumbHeight) != JPG_SUCCESS)
-            return -1;
-
-        char *pInBuf = (char *)jpgEnc.getInBuf(thumbSrcSize);
-        if (pInBuf == NULL)
-            return -1;
-        memcpy(pInBuf, pThumbSrc, thumbSrcSize);
-
-        unsigned int thumbSize;
-
-        jpgEnc.encode(&thumbSize, NULL);
-
-        ALOGV("%s : enableThumb set to true", __func__);
-        //TODO: findout why this causes memory corruption,
-        //      probably we make bad thumbnail MemoryHeapBase
-        //mExifInfo.enableThumb = true;
-    } else {
-        ALOGV("%s : enableThumb set to false", __func__);
-        mExifInfo.enableThumb = false;
-    }
+    //TODO: findout why embedding the thumbnail causes memory corruption.
+    //      It was encoded through the main buffers and dropped, so it is not
+    //      encoded at all until it can go in.
+    mExifInfo.enableThumb = false;
 
     unsigned int exifSize;
 
     setExifChangedAttribute();
+    if (width > 0 && height > 0) {
+        mExifInfo.width = width;
+        mExifInfo.height = height;
+    }
 
     ALOGV("%s: calling jpgEnc.makeExif, mExifInfo.width set to %d, height to %d\n",
          __func__, mExifInfo.width, mExifInfo.height);
 
-    jpgEnc.makeExif(pExifDst, &mExifInfo, &exifSize, true);
+    m_jpeg_enc->makeExif(pExifDst, &mExifInfo, &exifSize, true);
 
     return exifSize;
 }
@@ -1393,8 +1515,18 @@ int SecCamera::getPostViewOffset(void)
     return m_postview_offset;
 }
 
-int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
-                       unsigned int *jpeg_size)
+/*
+ * Where getSnapshot leaves the frame on its own, NULL if it has to be copied out
+ */
+unsigned char* SecCamera::getSnapshotBuf(void)
+{
+    return m_capture_direct ? m_capture_direct_buf : NULL;
+}
+
+/*
+ * Dequeue one YUV snapshot into yuv_buf, in burst mode the buffer goes straight back
+ */
+int SecCamera::getSnapshot(unsigned char *yuv_buf)
 {
     ALOGV("%s :", __func__);
 
@@ -1404,7 +1536,6 @@ int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
 
     LOG_TIME_DEFINE(0)
     LOG_TIME_DEFINE(1)
-    LOG_TIME_DEFINE(2)
 
     LOG_TIME_START(0) // capture
     if(m_camera_id == CAMERA_ID_BACK) {
@@ -1412,8 +1543,11 @@ int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
         CHECK(ret);
     }
     fimc_poll(&m_events_c);
-    index = fimc_v4l2_dqbuf(m_cam_fd);
-    if (!(0 <= index && index < m_capture_bufs_size)) {
+    if (m_capture_direct)
+        index = fimc_v4l2_dqbuf(m_cam_fd, V4L2_MEMORY_USERPTR);
+    else
+        index = fimc_v4l2_dqbuf(m_cam_fd);
+    if (!(0 <= index && index < (m_capture_direct ? 1 : m_capture_bufs_size))) {
         ALOGE("ERR(%s):wrong index = %d", __func__, index);
         return -1;
     }
@@ -1428,18 +1562,34 @@ int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
     LOG_TIME_END(0)
 
     LOG_TIME_START(1)
-    ALOGV("%s : calling memcpy from m_capture_bufs", __func__);
-    memcpy(yuv_buf, (unsigned char*)m_capture_bufs[index].start,
-            m_snapshot_width * m_snapshot_height * 2);
+    if (!m_capture_direct) {
+        ALOGV("%s : calling memcpy from m_capture_bufs", __func__);
+        memcpy(yuv_buf, (unsigned char*)m_capture_bufs[index].start,
+                m_snapshot_width * m_snapshot_height * 2);
+    } else if (yuv_buf != m_capture_direct_buf) {
+        memcpy(yuv_buf, m_capture_direct_buf, m_snapshot_width * m_snapshot_height * 2);
+    }
     LOG_TIME_END(1)
 
-    LOG_TIME_START(2)
-    /* JPEG encoding */
-    JpegEncoder jpgEnc;
-    int inFormat = JPG_MODESEL_YCBCR;
+    LOG_CAMERA("getSnapshot intervals: capture(%lu), memcpy(%lu)  us",
+                    LOG_TIME(0), LOG_TIME(1));
+
+    return 0;
+}
+
+/*
+ * Encode a YUV frame with the JPEG block, yuv_buf is left untouched.
+ * The stream stays in the encoder until copyJpeg, exif is not part of it.
+ */
+int SecCamera::encodeJpeg(unsigned char *yuv_buf, int width, int height, int v4lformat,
+                          unsigned int *jpeg_size)
+{
     int outFormat = JPG_422;
 
-    switch (m_snapshot_v4lformat) {
+    if (m_jpeg_enc == NULL)
+        return -1;
+
+    switch (v4lformat) {
     case V4L2_PIX_FMT_NV12:
     case V4L2_PIX_FMT_NV21:
     case V4L2_PIX_FMT_NV12T:
@@ -1454,12 +1604,6 @@ int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
         break;
     }
 
-    if (jpgEnc.setConfig(JPEG_SET_ENCODE_IN_FORMAT, inFormat) != JPG_SUCCESS)
-        ALOGE("[JPEG_SET_ENCODE_IN_FORMAT] Error\n");
-
-    if (jpgEnc.setConfig(JPEG_SET_SAMPING_MODE, outFormat) != JPG_SUCCESS)
-        ALOGE("[JPEG_SET_SAMPING_MODE] Error\n");
-
     image_quality_type_t jpegQuality;
     if (m_jpeg_quality >= 90)
         jpegQuality = JPG_QUALITY_LEVEL_1;
@@ -1470,39 +1614,48 @@ int SecCamera::getJpeg(unsigned char *yuv_buf, unsigned char *jpeg_buf,
     else
         jpegQuality = JPG_QUALITY_LEVEL_4;
 
-    if (jpgEnc.setConfig(JPEG_SET_ENCODE_QUALITY, jpegQuality) != JPG_SUCCESS)
-        ALOGE("[JPEG_SET_ENCODE_QUALITY] Error\n");
-    if (jpgEnc.setConfig(JPEG_SET_ENCODE_WIDTH, m_snapshot_width) != JPG_SUCCESS)
-        ALOGE("[JPEG_SET_ENCODE_WIDTH] Error\n");
-
-    if (jpgEnc.setConfig(JPEG_SET_ENCODE_HEIGHT, m_snapshot_height) != JPG_SUCCESS)
-        ALOGE("[JPEG_SET_ENCODE_HEIGHT] Error\n");
+    if (m_setJpegConfig(width, height, outFormat, jpegQuality) < 0)
+        return -1;
 
-    unsigned int snapshot_size = m_snapshot_width * m_snapshot_height * 2;
-    unsigned char *pInBuf = (unsigned char *)jpgEnc.getInBuf(snapshot_size);
+    unsigned int snapshot_size = width * height * 2;
+    unsigned char *pInBuf = (unsigned char *)m_jpeg_enc->getInBuf(snapshot_size);
 
     if (pInBuf == NULL) {
         ALOGE("JPEG input buffer is NULL!!\n");
         return -1;
     }
-    memcpy(pInBuf, yuv_buf, snapshot_size);
+    /* a direct snapshot is already there */
+    if (pInBuf != yuv_buf)
+        memcpy(pInBuf, yuv_buf, snapshot_size);
 
-    setExifChangedAttribute();
-    jpgEnc.encode(jpeg_size, &mExifInfo);
-    LOG_TIME_END(2)
+    if (m_jpeg_enc->encode(jpeg_size, NULL) != JPG_SUCCESS)
+        return -1;
+
+    return 0;
+}
 
+/*
+ * Copy the last encoded stream to jpeg_buf with exif right after SOI,
+ * jpeg_buf needs room for jpeg_size + exif_size
+ */
+int SecCamera::copyJpeg(unsigned char *jpeg_buf, const unsigned char *exif, int exif_size)
+{
     uint64_t outbuf_size;
-    unsigned char *pOutBuf = (unsigned char *)jpgEnc.getOutBuf(&outbuf_size);
+    unsigned char *pOutBuf;
+
+    if (m_jpeg_enc == NULL)
+        return -1;
 
+    pOutBuf = (unsigned char *)m_jpeg_enc->getOutBuf(&outbuf_size);
     if (pOutBuf == NULL) {
         ALOGE("JPEG output buffer is NULL!!\n");
         return -1;
     }
 
-    memcpy(jpeg_buf, pOutBuf, outbuf_size);
-
-    LOG_CAMERA("getJpeg intervals: capture(%lu), memcpy(%lu), yuv2Jpeg(%lu)  us",
-                    LOG_TIME(0), LOG_TIME(1), LOG_TIME(2));
+    memcpy(jpeg_buf, pOutBuf, 2);
+    if (exif_size > 0)
+        memcpy(jpeg_buf + 2, exif, exif_size);
+    memcpy(jpeg_buf + 2 + exif_size, pOutBuf + 2, outbuf_size - 2);
 
     return 0;
 }
@@ -3057,6 +3210,44 @@ void SecCamera::setExifChangedAttribute()
 // ======================================================================
 // Conversions
 
+/* only touches the encoder settings that differ from the previous encode */
+int SecCamera::m_setJpegConfig(int width, int height, int sampling, int quality)
+{
+    if (sampling != m_jpeg_enc_sampling) {
+        if (m_jpeg_enc->setConfig(JPEG_SET_SAMPING_MODE, sampling) != JPG_SUCCESS) {
+            ALOGE("[JPEG_SET_SAMPING_MODE] Error\n");
+            return -1;
+        }
+        m_jpeg_enc_sampling = sampling;
+    }
+
+    if (quality != m_jpeg_enc_quality) {
+        if (m_jpeg_enc->setConfig(JPEG_SET_ENCODE_QUALITY, quality) != JPG_SUCCESS) {
+            ALOGE("[JPEG_SET_ENCODE_QUALITY] Error\n");
+            return -1;
+        }
+        m_jpeg_enc_quality = quality;
+    }
+
+    if (width != m_jpeg_enc_width) {
+        if (m_jpeg_enc->setConfig(JPEG_SET_ENCODE_WIDTH, width) != JPG_SUCCESS) {
+            ALOGE("[JPEG_SET_ENCODE_WIDTH] Error\n");
+            return -1;
+        }
+        m_jpeg_enc_width = width;
+    }
+
+    if (height != m_jpeg_enc_height) {
+        if (m_jpeg_enc->setConfig(JPEG_SET_ENCODE_HEIGHT, height) != JPG_SUCCESS) {
+            ALOGE("[JPEG_SET_ENCODE_HEIGHT] Error\n");
+            return -1;
+        }
+        m_jpeg_enc_height = height;
+    }
+
+    return 0;
+}
+
 inline int SecCamera::m_frameSize(int format, int width, int height)
 {
     int size = 0;
@@ -3090,6 +3281,11 @@ inline int SecCamera::m_frameSize(int format, int width, int height)
     return size;
 }
 
+int SecCamera::getDriverCallCount(void)
+{
+    return android_atomic_acquire_load(&gDriverCalls);
+}
+
 /*
 status_t SecCamera::dump(int fd, const Vector<String16> &args)
 {
@@ -193,6 +193,13 @@ struct fimc_buffer {
 };
 typedef struct fimc_buffer fimc_buffer;
 
+/* physical planes of a buffer queued with V4L2_MEMORY_USERPTR (struct fimc_buf of the driver) */
+struct fimc_user_buffer {
+    unsigned int    base[3];
+    size_t          length[3];
+};
+typedef struct fimc_user_buffer fimc_user_buffer;
+
 class SecCamera {
 public:
 
@@ -293,6 +300,8 @@ public:
     void            getPreviewMaxSize(int *width, int *height);
     int             getPreviewPixelFormat(void);
     int             setPreviewImage(int index, unsigned char *buffer, int size);
+    int             setPreviewUserBuffers(const fimc_user_buffer *bufs, int count);
+    int             releasePreviewFrame(int index, const fimc_user_buffer *buf = NULL);
 
     int             setSnapshotSize(int width, int height);
     void            getSnapshotSize(int *width, int *height, int *frame_size);
@@ -418,9 +427,13 @@ public:
     int             setFrameRate(int frame_rate);
     int             getJpeg(unsigned int *phyaddr, unsigned char** jpeg_buf,
                             unsigned int *jpeg_size);
-    int             getJpeg(unsigned char *yuv_buf, unsigned char* jpeg_buf,
-                            unsigned int *jpeg_size);
-    int             getExif(unsigned char *pExifDst, unsigned char *pThumbSrc);
+    int             getSnapshot(unsigned char *yuv_buf);
+    int             getDriverCallCount(void);
+    unsigned char*  getSnapshotBuf(void);
+    int             encodeJpeg(unsigned char *yuv_buf, int width, int height, int v4lformat,
+                               unsigned int *jpeg_size);
+    int             copyJpeg(unsigned char *jpeg_buf, const unsigned char *exif, int exif_size);
+    int             getExif(unsigned char *pExifDst, int width = 0, int height = 0);
 
     void            getPostViewConfig(int*, int*, int*);
     void            getThumbnailConfig(int *width, int *height, int *size);
@@ -491,6 +504,11 @@ private:
     int             m_preview_max_width;
     int             m_preview_max_height;
 
+    /* preview captured into client buffers instead of driver buffers */
+    int             m_preview_user_count;
+    fimc_user_buffer m_preview_user_bufs[MAX_BUFFERS];
+    bool            m_preview_user_queued[MAX_BUFFERS];
+
     int             m_snapshot_v4lformat;
     int             m_snapshot_width;
     int             m_snapshot_height;
@@ -533,6 +551,13 @@ private:
     int             m_jpeg_thumbnail_height;
     int             m_jpeg_quality;
 
+    /* opened once in initCamera, shared by every shot and thumbnail */
+    JpegEncoder*    m_jpeg_enc;
+    int             m_jpeg_enc_width;
+    int             m_jpeg_enc_height;
+    int             m_jpeg_enc_sampling;
+    int             m_jpeg_enc_quality;
+
     int             m_postview_offset;
 
 #ifdef ENABLE_ESD_PREVIEW_CHECK
@@ -544,9 +569,13 @@ private:
     fimc_buffer*    m_capture_bufs;
     int             m_capture_bufs_size;
     bool            m_capture_burst;
+    /* single shot captured straight into the jpeg input buffer */
+    bool            m_capture_direct;
+    unsigned char*  m_capture_direct_buf;
     struct pollfd   m_events_c;
 
     inline int      m_frameSize(int format, int width, int height);
+    int             m_setJpegConfig(int width, int height, int sampling, int quality);
 
     int             startStream();
     int             stopStream();
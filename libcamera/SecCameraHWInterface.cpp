@@ -22,17 +22,40 @@
 #include <utils/Log.h>
 
 #include "SecCameraHWInterface.h"
+#include "YuvScaler.h"
 #include <utils/threads.h>
 #include <fcntl.h>
 #include <sys/mman.h>
+#include <cutils/properties.h>
 
 #include <media/hardware/MetadataBufferType.h>
 
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "hal_public.h"
+
 #define BACK_CAMERA_AUTO_FOCUS_DISTANCES_STR       "0.10,1.20,Infinity"
 #define BACK_CAMERA_MACRO_FOCUS_DISTANCES_STR      "0.10,0.20,Infinity"
 #define BACK_CAMERA_INFINITY_FOCUS_DISTANCES_STR   "0.10,1.20,Infinity"
 #define FRONT_CAMERA_FOCUS_DISTANCES_STR           "0.20,0.25,Infinity"
 
+/* same bit the hwcomposer checks, asks gralloc for physically contiguous memory */
+#define GRALLOC_USAGE_PHYS_CONTIG GRALLOC_USAGE_PRIVATE_1
+
+/* fewer window buffers than this and FIMC would starve, use the copy path */
+#define MIN_ZERO_COPY_PREVIEW_BUFFERS 3
+
+/* depth of the preview callback ring, capped at kMaxCallbackBufferCount */
+#define PREVIEW_CALLBACK_BUFFERS_PROPERTY "camera.preview.callback_buffers"
+#define DEFAULT_PREVIEW_CALLBACK_BUFFERS  4
+
+/* default zsl ring budget in KB, capped at kMaxZslBufferCount frames */
+#define DEFAULT_ZSL_BUFFER_SIZE             4096
+
 #define RELEASE_MEMORY_BUFFER(buffer)                               \
     if (buffer) {                                                   \
         buffer->release(buffer);                                    \
@@ -66,21 +89,114 @@ static const int EFFECT_SKIP_FRAME = 1;
 
 gralloc_module_t const* CameraHardwareSec::mGrallocHal = NULL;
 
+/* interleaves planar chroma into the VU order of NV21, 16 pairs per SIMD step */
+static void interleaveChromaNV21(char *dst, const char *u, const char *v, int size)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON__)
+    for (; i + 16 <= size; i += 16) {
+        uint8x16x2_t vu;
+
+        vu.val[0] = vld1q_u8((const uint8_t *)v + i);
+        vu.val[1] = vld1q_u8((const uint8_t *)u + i);
+        vst2q_u8((uint8_t *)dst + 2 * i, vu);
+    }
+#elif defined(__SSE2__)
+    for (; i + 16 <= size; i += 16) {
+        __m128i vv = _mm_loadu_si128((const __m128i *)(v + i));
+        __m128i uu = _mm_loadu_si128((const __m128i *)(u + i));
+
+        _mm_storeu_si128((__m128i *)(dst + 2 * i), _mm_unpacklo_epi8(vv, uu));
+        _mm_storeu_si128((__m128i *)(dst + 2 * i + 16), _mm_unpackhi_epi8(vv, uu));
+    }
+#endif
+    for (; i < size; i++) {
+        dst[2 * i]     = v[i];
+        dst[2 * i + 1] = u[i];
+    }
+}
+
+/* expands a planar YUV420 frame to the YUYV the JPEG block takes */
+static void convertYuv420pToYuyv(char *dst, const char *src, int width, int height)
+{
+    const char *u = src + width * height;
+    const char *v = u + width * height / 4;
+
+    for (int h = 0; h < height; h++) {
+        const char *y_row = src + width * h;
+        const char *u_row = u + (width / 2) * (h / 2);
+        const char *v_row = v + (width / 2) * (h / 2);
+
+        for (int w = 0; w < width; w += 2) {
+            *dst++ = y_row[w];
+            *dst++ = u_row[w / 2];
+            *dst++ = y_row[w + 1];
+            *dst++ = v_row[w / 2];
+        }
+    }
+}
+
+/* copies a planar 4:2:0 frame into a callback buffer, as NV21 or as planar YUV420 */
+static void copyPreviewCallbackFrame(char *dst, const char *y, const char *u, const char *v,
+                                     int width, int height, bool nv21)
+{
+    const int y_size = width * height;
+
+    memcpy(dst, y, y_size);
+    if (nv21) {
+        interleaveChromaNV21(dst + y_size, u, v, y_size / 4);
+    } else {
+        memcpy(dst + y_size, u, y_size / 4);
+        memcpy(dst + y_size + y_size / 4, v, y_size / 4);
+    }
+}
+
 CameraHardwareSec::CameraHardwareSec(int cameraId)
         :
           mCaptureMode(SNAPSHOT),
+          mZslCapture(false),
           mCaptureInProgress(false),
           mCaptureCancel(false),
           mFaceDetectStarted(false),
           mPreviewPaused(false),
+          mExitCallbackThread(false),
+          mCallbackBufferCount(0),
+          mCallbackQueueHead(0),
+          mCallbackQueued(0),
+          mCallbackHeapInUse(NULL),
+          mCallbackHeapRetired(NULL),
+          mCallbackDropped(0),
+          mZslEnabled(false),
+          mZslBudget(DEFAULT_ZSL_BUFFER_SIZE * 1024),
+          mZslHeap(NULL),
+          mZslBufferCount(0),
+          mZslWidth(0),
+          mZslHeight(0),
+          mZslFrameSize(0),
+          mZslHead(0),
+          mZslCount(0),
+          mZslFrozen(false),
+          mZslHeapFailed(false),
+          mZslShutter(0),
           mParameters(),
+          mParamsStale(~0u),
+          mParamsCalls(0),
+          mParamsApplied(0),
+          mParamsDriverCalls(0),
+          mParamsDriverCallsTotal(0),
           mPreviewMemory(0),
+          mPreviewCallbackHeap(0),
           mRawHeap(0),
           mRecordHeap(0),
           mSecCamera(NULL),
           mCameraSensorName(NULL),
           mSkipFrame(0),
           mWindow(NULL),
+          mWindowMinUndequeued(0),
+          mPreviewZeroCopy(false),
+          mPreviewZeroCopyBroken(false),
+          mPreviewBufCount(0),
           mNotifyCb(0),
           mDataCb(0),
           mDataCbTimestamp(0),
@@ -94,6 +210,9 @@ CameraHardwareSec::CameraHardwareSec(int cameraId)
     int ret;
 
     ALOGV("%s :", __func__);
+    memset(mPreviewBufHandle, 0, sizeof(mPreviewBufHandle));
+    memset(mPreviewBufStarved, 0, sizeof(mPreviewBufStarved));
+    memset(mCallbackBusy, 0, sizeof(mCallbackBusy));
     mSecCamera = SecCamera::createInstance();
     if (mSecCamera == NULL) {
         ALOGE("ERR(%s):Fail on mSecCamera object creation", __func__);
@@ -128,13 +247,17 @@ status_t CameraHardwareSec::init()
     
     mExitAutoFocusThread = false;
     mExitPreviewThread = false;
+    mExitCallbackThread = false;
     /* whether the PreviewThread is active in preview or stopped.  we
      * create the thread but it is initially in stopped state.
      */
     mPreviewRunning = false;
     mPreviewThread = new PreviewThread(this);
+    mPreviewCallbackThread = new PreviewCallbackThread(this);
     mAutoFocusThread = new AutoFocusThread(this);
     mPictureThread = new PictureThread(this);
+    mBurstEncodeThread = new BurstEncodeThread(this);
+    mBurstDeliverThread = new BurstDeliverThread(this);
     
     return NO_ERROR;
 }
@@ -324,6 +447,11 @@ void CameraHardwareSec::initDefaultParameters(int cameraId)
         p.set(SecCameraParameters::KEY_FOCAL_LENGTH, "0.9");
     }
 
+    // zero shutter lag pictures are taken at preview size
+    p.set(SecCameraParameters::KEY_ZSL_SUPPORTED, SecCameraParameters::TRUE);
+    p.set(SecCameraParameters::KEY_ZSL, SecCameraParameters::FALSE);
+    p.set(SecCameraParameters::KEY_ZSL_BUFFER_SIZE, DEFAULT_ZSL_BUFFER_SIZE);
+
     parameterString = SecCameraParameters::WHITE_BALANCE_AUTO;
     parameterString.append(",");
     parameterString.append(SecCameraParameters::WHITE_BALANCE_INCANDESCENT);
@@ -379,6 +507,7 @@ void CameraHardwareSec::initDefaultParameters(int cameraId)
      * aren't required to call setParameters themselves (only if they
      * want to change something.
      */
+    mParamsStale = ~0u;
     setParameters(p);
     mSecCamera->setISO(ISO_AUTO);
     mSecCamera->setContrast(CONTRAST_DEFAULT);
@@ -407,21 +536,24 @@ status_t CameraHardwareSec::setPreviewWindow(struct preview_stream_ops *window)
 
     Mutex::Autolock lock(mPreviewLock);
 
+    /* in zero-copy mode FIMC still owns buffers of the old window */
+    if (mPreviewRunning && !mPreviewStartDeferred && (window || mPreviewZeroCopy)) {
+        ALOGI("stop preview (window change)");
+        stopPreview_l();
+    }
+
     mWindow = window;
+    mPreviewZeroCopyBroken = false;
     if (!window) {
         ALOGE("preview window is NULL!");
         return OK;
     }
 
-    if (mPreviewRunning && !mPreviewStartDeferred) {
-        ALOGI("stop preview (window change)");
-        stopPreview_l();
-    }
-
     if (window->get_min_undequeued_buffer_count(window, &min_bufs)) {
         ALOGE("%s: could not retrieve min undequeued buffer count", __func__);
         return INVALID_OPERATION;
     }
+    mWindowMinUndequeued = min_bufs;
 
     if (min_bufs >= kBufferCount) {
         ALOGE("%s: min undequeued buffer count %d is too high (expecting at most %d)", __func__,
@@ -442,7 +574,9 @@ status_t CameraHardwareSec::setPreviewWindow(struct preview_stream_ops *window)
     const char *str_preview_format = mParameters.getPreviewFormat();
     ALOGV("%s: preview format %s", __func__, str_preview_format);
     
-    if (window->set_usage(window, GRALLOC_USAGE_SW_WRITE_OFTEN)) {
+    if (window->set_usage(window, GRALLOC_USAGE_SW_WRITE_OFTEN |
+                                  GRALLOC_USAGE_SW_READ_OFTEN |
+                                  GRALLOC_USAGE_PHYS_CONTIG)) {
         ALOGE("%s: could not set usage on gralloc buffer", __func__);
         return INVALID_OPERATION;
     }
@@ -537,6 +671,8 @@ int CameraHardwareSec::previewThreadWrapper()
                 mSecCamera->pausePreview();
             } else {
                 mSecCamera->stopPreview();
+                if (mPreviewZeroCopy)
+                    cancelPreviewBuffers_l();
             }
             /* signal that we're stopping */
             mPreviewStoppedCondition.signal();
@@ -563,6 +699,12 @@ int CameraHardwareSec::previewThread()
     struct addrs*   addrs;
     int             width, height, frame_size, offset;
 
+    /* with no window buffer left in FIMC, getPreview would never return */
+    if (mPreviewZeroCopy && !refillStarvedPreviewBuffers()) {
+        fallBackToCopyPreview();
+        return NO_ERROR;
+    }
+
     index = mSecCamera->getPreview();
     if (index < 0) {
         ALOGE("ERR(%s):Fail on SecCamera->getPreview()", __func__);
@@ -572,12 +714,52 @@ int CameraHardwareSec::previewThread()
     if (mSkipFrame > 0) {
         mSkipFrame--;
         mSkipFrameLock.unlock();
+        /* capture the next frame into the same window buffer */
+        if (mPreviewZeroCopy)
+            mSecCamera->releasePreviewFrame(index);
         return NO_ERROR;
     }
     mSkipFrameLock.unlock();
 
     timestamp = systemTime(SYSTEM_TIME_MONOTONIC);
 
+    mSecCamera->getPreviewSize(&width, &height, &frame_size);
+    offset = frame_size * index;
+
+    if (mPreviewZeroCopy) {
+        /* the frame is already in the window buffer, only the copies are left */
+        if ((mMsgEnabled & CAMERA_MSG_PREVIEW_FRAME) || mZslEnabled) {
+            void *vaddr;
+
+            if (!mGrallocHal->lock(mGrallocHal, *mPreviewBufHandle[index],
+                                   GRALLOC_USAGE_SW_READ_OFTEN,
+                                   0, 0, width, height, &vaddr)) {
+                camera_memory_t *heap;
+                int slot = -1;
+                char *v = (char *)vaddr + width * height;
+                char *u = v + width * height / 4;
+
+                // window is YV12
+                if (mZslEnabled)
+                    storeZslFrame((char *)vaddr, u, v, width, height, frame_size, timestamp);
+                if (mMsgEnabled & CAMERA_MSG_PREVIEW_FRAME)
+                    slot = acquirePreviewCallback(frame_size, &heap);
+                if (slot >= 0)
+                    copyPreviewCallbackFrame((char *)heap->data + frame_size * slot,
+                            (char *)vaddr, u, v, width, height,
+                            !strcmp(mParameters.getPreviewFormat(),
+                                    CameraParameters::PIXEL_FORMAT_YUV420SP));
+                mGrallocHal->unlock(mGrallocHal, *mPreviewBufHandle[index]);
+                if (slot >= 0)
+                    postPreviewCallback(slot);
+            } else {
+                ALOGE("%s: Could not obtain gralloc buffer", __func__);
+            }
+        }
+        queuePreviewBuffer(index);
+        goto record;
+    }
+
     phyYAddr = mSecCamera->getPhyAddrY(index);
     phyCAddr = mSecCamera->getPhyAddrC(index);
     if (phyYAddr == 0xffffffff || phyCAddr == 0xffffffff) {
@@ -586,9 +768,6 @@ int CameraHardwareSec::previewThread()
         return UNKNOWN_ERROR;
     }
 
-    mSecCamera->getPreviewSize(&width, &height, &frame_size);
-    offset = frame_size * index;
-
     // draw new frame into window
     if(mWindow && mGrallocHal) {
         buffer_handle_t *buf_handle;
@@ -648,28 +827,33 @@ int CameraHardwareSec::previewThread()
         }
     }
 
+    if (mZslEnabled) {
+        char *y = ((char *)mPreviewMemory->data) + offset;
+
+        storeZslFrame(y, y + width * height, y + width * height * 5 / 4,
+                      width, height, frame_size, timestamp);
+    }
+
     // Notify the client of a new frame.
     if (mMsgEnabled & CAMERA_MSG_PREVIEW_FRAME) {
-        const char * preview_format = mParameters.getPreviewFormat();
-        if (!strcmp(preview_format, CameraParameters::PIXEL_FORMAT_YUV420SP)) {
-            // Color conversion from YUV420 to NV21
-            char *vu = ((char *)mPreviewMemory->data) + offset + width * height;
-            const int uv_size = (width * height) >> 1;
-            char saved_uv[uv_size];
-            memcpy(saved_uv, vu, uv_size);
-            char *u = saved_uv;
-            char *v = u + (uv_size >> 1);
-
-            int h = 0;
-            while (h < width * height / 4) {
-                *vu++ = *v++;
-                *vu++ = *u++;
-                ++h;
-            }
+        camera_memory_t *heap;
+        int slot = acquirePreviewCallback(frame_size, &heap);
+
+        if (slot >= 0) {
+            // FIMC has requeued the source already, convert YUV420 to NV21 if asked
+            const char * preview_format = mParameters.getPreviewFormat();
+            char *y = ((char *)mPreviewMemory->data) + offset;
+            char *u = y + width * height;
+            char *v = u + width * height / 4;
+
+            copyPreviewCallbackFrame((char *)heap->data + frame_size * slot, y, u, v,
+                                     width, height,
+                                     !strcmp(preview_format, CameraParameters::PIXEL_FORMAT_YUV420SP));
+            postPreviewCallback(slot);
         }
-        mDataCb(CAMERA_MSG_PREVIEW_FRAME, mPreviewMemory, index, NULL, mCallbackCookie);
     }
 
+record:
     Mutex::Autolock lock(mRecordLock);
     if (mRecordRunning == true) {
         index = mSecCamera->getRecordFrame();
@@ -746,7 +930,13 @@ status_t CameraHardwareSec::startPreview_l()
         return NO_ERROR;
     }
 
+    mPreviewZeroCopy = registerPreviewBuffers_l();
     ret = mSecCamera->startPreview();
+    if (ret < 0 && mPreviewZeroCopy) {
+        ALOGW("%s: FIMC refused the window buffers, copying preview frames", __func__);
+        cancelPreviewBuffers_l();
+        ret = mSecCamera->startPreview();
+    }
     if (ret < 0) {
         ALOGE("ERR(%s):Fail on mSecCamera->startPreview()", __func__);
         return UNKNOWN_ERROR;
@@ -754,19 +944,31 @@ status_t CameraHardwareSec::startPreview_l()
 
     setSkipFrame(INITIAL_SKIP_FRAME);
 
+    /* a stopped sensor drops focus areas, setParameters only sends them again on a change */
+    if (applyFocusAreas(mLastParameters) != NO_ERROR) {
+        for (int i = 0; i < kParamHandlerCount; i++) {
+            if (kParamHandlers[i].apply == &CameraHardwareSec::applyFocusAreas)
+                mParamsStale |= 1 << i;
+        }
+    }
+
     int width, height, frame_size;
     mSecCamera->getPreviewSize(&width, &height, &frame_size);
-    ALOGD("MemoryHeapBase(fd(%d), size(%d), width(%d), height(%d))",
-             mSecCamera->getCameraFd(), frame_size * kBufferCount, width, height);
+    ALOGD("MemoryHeapBase(fd(%d), size(%d), width(%d), height(%d), zero-copy(%d))",
+             mSecCamera->getCameraFd(), frame_size * kBufferCount, width, height, mPreviewZeroCopy);
 
     RELEASE_MEMORY_BUFFER(mPreviewMemory);
-    mPreviewMemory = mGetMemoryCb(mSecCamera->getCameraFd(),
-                                  frame_size,
-                                  kBufferCount,
-                                  mCallbackCookie);
-    if (!mPreviewMemory) {
-        ALOGE("ERR(%s): Preview heap creation fail", __func__);
-        return NO_MEMORY;
+    resetPreviewCallbacks();
+    resetZslRing();
+    if (!mPreviewZeroCopy) {
+        mPreviewMemory = mGetMemoryCb(mSecCamera->getCameraFd(),
+                                      frame_size,
+                                      kBufferCount,
+                                      mCallbackCookie);
+        if (!mPreviewMemory) {
+            ALOGE("ERR(%s): Preview heap creation fail", __func__);
+            return NO_MEMORY;
+        }
     }
 
     mSecCamera->getPostViewConfig(&mPostViewWidth, &mPostViewHeight, &mPostViewSize);
@@ -776,6 +978,388 @@ status_t CameraHardwareSec::startPreview_l()
     return OK;
 }
 
+/*
+ * Zero-copy preview: hands dequeued window buffers to FIMC as capture
+ * destinations. Only possible when FIMC's packed planes line up with the
+ * window's YV12 layout, i.e. the stride equals the width and the chroma
+ * stride needs no padding.
+ */
+bool CameraHardwareSec::registerPreviewBuffers_l()
+{
+    fimc_user_buffer bufs[kBufferCount];
+    int width, height, frame_size;
+    int count, i;
+
+    mSecCamera->setPreviewUserBuffers(NULL, 0);
+    /* the window ran dry during an earlier zero-copy preview */
+    if (mPreviewZeroCopyBroken)
+        return false;
+    if (!mWindow || !mGrallocHal ||
+        !((IMG_gralloc_module_public_t const *)mGrallocHal)->GetPhyAddrs)
+        return false;
+
+    mSecCamera->getPreviewSize(&width, &height, &frame_size);
+    if (mSecCamera->getPreviewPixelFormat() != V4L2_PIX_FMT_YUV420 || (width % 32) != 0)
+        return false;
+
+    count = kBufferCount - mWindowMinUndequeued;
+    if (count < MIN_ZERO_COPY_PREVIEW_BUFFERS)
+        return false;
+
+    for (i = 0; i < count; i++) {
+        int stride;
+
+        if (mWindow->dequeue_buffer(mWindow, &mPreviewBufHandle[i], &stride)) {
+            mPreviewBufHandle[i] = NULL;
+            break;
+        }
+        if (!getPreviewUserBuffer(mPreviewBufHandle[i], stride, &bufs[i]))
+            break;
+    }
+
+    if (i < count || mSecCamera->setPreviewUserBuffers(bufs, count) < 0) {
+        ALOGV("%s: window buffers can't be captured into, copying preview frames", __func__);
+        cancelPreviewBuffers_l();
+        return false;
+    }
+    mPreviewBufCount = count;
+
+    return true;
+}
+
+/* hands out a free callback slot, or -1 when the client still holds all of them */
+int CameraHardwareSec::acquirePreviewCallback(int frame_size, camera_memory_t **heap)
+{
+    Mutex::Autolock lock(mCallbackLock);
+
+    if (!mPreviewCallbackHeap) {
+        char value[PROPERTY_VALUE_MAX];
+        int count;
+
+        property_get(PREVIEW_CALLBACK_BUFFERS_PROPERTY, value, "");
+        count = atoi(value);
+        if (count <= 0)
+            count = DEFAULT_PREVIEW_CALLBACK_BUFFERS;
+        if (count > kMaxCallbackBufferCount)
+            count = kMaxCallbackBufferCount;
+
+        mPreviewCallbackHeap = mGetMemoryCb(-1, frame_size, count, mCallbackCookie);
+        if (!mPreviewCallbackHeap) {
+            ALOGE("ERR(%s): Preview callback heap creation fail", __func__);
+            return -1;
+        }
+        mCallbackBufferCount = count;
+    }
+
+    for (int i = 0; i < mCallbackBufferCount; i++) {
+        if (!mCallbackBusy[i]) {
+            mCallbackBusy[i] = true;
+            *heap = mPreviewCallbackHeap;
+            return i;
+        }
+    }
+
+    mCallbackDropped++;
+    ALOGV("%s: client holds every callback buffer, frame dropped (%u)",
+          __func__, mCallbackDropped);
+    return -1;
+}
+
+void CameraHardwareSec::postPreviewCallback(int slot)
+{
+    Mutex::Autolock lock(mCallbackLock);
+
+    mCallbackQueue[(mCallbackQueueHead + mCallbackQueued) % kMaxCallbackBufferCount] = slot;
+    mCallbackQueued++;
+    mCallbackCondition.signal();
+}
+
+/* drops undelivered frames, a heap still with the client is freed when it returns */
+void CameraHardwareSec::resetPreviewCallbacks()
+{
+    Mutex::Autolock lock(mCallbackLock);
+
+    if (mCallbackDropped)
+        ALOGI("%s: %u preview callback frames dropped", __func__, mCallbackDropped);
+    mCallbackDropped = 0;
+    mCallbackQueueHead = 0;
+    mCallbackQueued = 0;
+    memset(mCallbackBusy, 0, sizeof(mCallbackBusy));
+
+    if (mPreviewCallbackHeap && mPreviewCallbackHeap == mCallbackHeapInUse) {
+        mCallbackHeapRetired = mPreviewCallbackHeap;
+        mPreviewCallbackHeap = NULL;
+    } else {
+        RELEASE_MEMORY_BUFFER(mPreviewCallbackHeap);
+    }
+}
+
+/* keeps the newest preview frames so takePicture can skip the sensor mode switch */
+void CameraHardwareSec::storeZslFrame(const char *y, const char *u, const char *v,
+                                      int width, int height, int frame_size,
+                                      nsecs_t timestamp)
+{
+    Mutex::Autolock lock(mZslLock);
+
+    if (mZslFrozen)
+        return;
+
+    if (!mZslHeap) {
+        int count = mZslBudget / frame_size;
+
+        if (count < 1)
+            count = 1;
+        if (count > kMaxZslBufferCount)
+            count = kMaxZslBufferCount;
+
+        /* zsl stays on as reported to the app, the next frame tries again */
+        mZslHeap = mGetMemoryCb(-1, frame_size, count, 0);
+        if (!mZslHeap) {
+            if (!mZslHeapFailed)
+                ALOGE("ERR(%s): ZSL heap creation fail", __func__);
+            mZslHeapFailed = true;
+            return;
+        }
+        mZslHeapFailed = false;
+        ALOGV("%s: %d frames of %dx%d", __func__, count, width, height);
+        mZslBufferCount = count;
+        mZslWidth = width;
+        mZslHeight = height;
+        mZslFrameSize = frame_size;
+        mZslHead = 0;
+        mZslCount = 0;
+    }
+
+    copyPreviewCallbackFrame((char *)mZslHeap->data + mZslFrameSize * mZslHead, y, u, v,
+                             width, height, false);
+    mZslTimestamp[mZslHead] = timestamp;
+    mZslHead = (mZslHead + 1) % mZslBufferCount;
+    if (mZslCount < mZslBufferCount)
+        mZslCount++;
+}
+
+/* stops the ring at the shutter, false when there is nothing to take yet */
+bool CameraHardwareSec::freezeZslRing()
+{
+    Mutex::Autolock lock(mZslLock);
+
+    if (!mZslHeap || !mZslCount)
+        return false;
+
+    mZslShutter = systemTime(SYSTEM_TIME_MONOTONIC);
+    mZslFrozen = true;
+    return true;
+}
+
+void CameraHardwareSec::resetZslRing()
+{
+    Mutex::Autolock lock(mZslLock);
+
+    RELEASE_MEMORY_BUFFER(mZslHeap);
+    mZslCount = 0;
+    mZslHead = 0;
+    mZslFrozen = false;
+    mZslHeapFailed = false;
+}
+
+/* encodes the frozen frame nearest the shutter, the ring runs again afterwards */
+int CameraHardwareSec::encodeZslFrame(PictureFrame *frame)
+{
+    int slot = -1, ret;
+    nsecs_t best = 0;
+    sp<MemoryHeapBase> yuyvHeap;
+
+    /* frozen, so the preview thread leaves the ring alone */
+    for (int i = 0; i < mZslCount; i++) {
+        nsecs_t diff = mZslTimestamp[i] - mZslShutter;
+
+        if (diff < 0)
+            diff = -diff;
+        if (slot < 0 || diff < best) {
+            slot = i;
+            best = diff;
+        }
+    }
+    ALOGV("%s: slot %d, %lld us from the shutter", __func__, slot, best / 1000);
+
+    yuyvHeap = new MemoryHeapBase(mZslWidth * mZslHeight * 2);
+    convertYuv420pToYuyv((char *)yuyvHeap->base(),
+                         (char *)mZslHeap->data + mZslFrameSize * slot,
+                         mZslWidth, mZslHeight);
+
+    ret = mSecCamera->encodeJpeg((unsigned char *)yuyvHeap->base(), mZslWidth, mZslHeight,
+                                 V4L2_PIX_FMT_YUYV, &frame->jpegSize);
+    if (ret < 0)
+        goto out;
+
+    /* zsl frames have no postview */
+    frame->hasRaw = false;
+    frame->hasExif = true;
+    frame->exifWidth = mZslWidth;
+    frame->exifHeight = mZslHeight;
+
+out:
+    mZslLock.lock();
+    mZslFrozen = false;
+    mZslLock.unlock();
+
+    return ret;
+}
+
+bool CameraHardwareSec::previewCallbackThread()
+{
+    camera_memory_t *heap;
+    int slot;
+
+    mCallbackLock.lock();
+    while (!mCallbackQueued && !mExitCallbackThread)
+        mCallbackCondition.wait(mCallbackLock);
+    if (mExitCallbackThread) {
+        mCallbackLock.unlock();
+        return false;
+    }
+    slot = mCallbackQueue[mCallbackQueueHead];
+    mCallbackQueueHead = (mCallbackQueueHead + 1) % kMaxCallbackBufferCount;
+    mCallbackQueued--;
+    heap = mCallbackHeapInUse = mPreviewCallbackHeap;
+    mCallbackLock.unlock();
+
+    /* a slow client only holds this thread, the capture loop keeps running */
+    if (mMsgEnabled & CAMERA_MSG_PREVIEW_FRAME)
+        mDataCb(CAMERA_MSG_PREVIEW_FRAME, heap, slot, NULL, mCallbackCookie);
+
+    mCallbackLock.lock();
+    mCallbackHeapInUse = NULL;
+    if (heap == mCallbackHeapRetired) {
+        RELEASE_MEMORY_BUFFER(mCallbackHeapRetired);
+    } else {
+        mCallbackBusy[slot] = false;
+    }
+    mCallbackLock.unlock();
+
+    return true;
+}
+
+/* returns every window buffer FIMC holds, preview must be stopped */
+void CameraHardwareSec::cancelPreviewBuffers_l()
+{
+    for (int i = 0; i < kBufferCount; i++) {
+        if (mPreviewBufHandle[i] == NULL)
+            continue;
+        if (mWindow)
+            mWindow->cancel_buffer(mWindow, mPreviewBufHandle[i]);
+        mPreviewBufHandle[i] = NULL;
+    }
+    memset(mPreviewBufStarved, 0, sizeof(mPreviewBufStarved));
+    mSecCamera->setPreviewUserBuffers(NULL, 0);
+    mPreviewZeroCopy = false;
+    mPreviewBufCount = 0;
+}
+
+bool CameraHardwareSec::getPreviewUserBuffer(buffer_handle_t *buf_handle, int stride,
+                                             fimc_user_buffer *buf)
+{
+    IMG_gralloc_module_public_t const *module = (IMG_gralloc_module_public_t const *)mGrallocHal;
+    unsigned int phyAddr[MAX_SUB_ALLOCS];
+    int width, height, frame_size;
+
+    mSecCamera->getPreviewSize(&width, &height, &frame_size);
+    if (stride != width)
+        return false;
+
+    memset(phyAddr, 0, sizeof(phyAddr));
+    if (module->GetPhyAddrs(module, *buf_handle, phyAddr) || phyAddr[0] == 0)
+        return false;
+
+    /* YV12 keeps V before U, FIMC takes Y, Cb, Cr */
+    buf->base[0]   = phyAddr[0];
+    buf->length[0] = width * height;
+    buf->base[2]   = buf->base[0] + buf->length[0];
+    buf->length[2] = width * height / 4;
+    buf->base[1]   = buf->base[2] + buf->length[2];
+    buf->length[1] = width * height / 4;
+
+    return true;
+}
+
+/* shows a captured frame and gives FIMC the next free window buffer for its index */
+void CameraHardwareSec::queuePreviewBuffer(int index)
+{
+    int ret;
+
+    if (0 != (ret = mWindow->enqueue_buffer(mWindow, mPreviewBufHandle[index]))) {
+        ALOGE("%s: Could not enqueue gralloc buffer: %i!", __func__, ret);
+        /* keep capturing into it rather than losing the FIMC slot */
+        mSecCamera->releasePreviewFrame(index);
+        return;
+    }
+    mPreviewBufHandle[index] = NULL;
+
+    /* the slot is retried before the next getPreview */
+    if (!refillPreviewBuffer(index))
+        mPreviewBufStarved[index] = true;
+}
+
+/* dequeues a window buffer and queues it to FIMC for an empty index */
+bool CameraHardwareSec::refillPreviewBuffer(int index)
+{
+    buffer_handle_t *buf_handle;
+    fimc_user_buffer buf;
+    int stride;
+    int ret;
+
+    if (0 != (ret = mWindow->dequeue_buffer(mWindow, &buf_handle, &stride))) {
+        ALOGE("%s: Could not dequeue gralloc buffer: %i!", __func__, ret);
+        return false;
+    }
+    if (!getPreviewUserBuffer(buf_handle, stride, &buf)) {
+        ALOGE("%s: window buffer can't be captured into", __func__);
+        mWindow->cancel_buffer(mWindow, buf_handle);
+        return false;
+    }
+
+    mPreviewBufHandle[index] = buf_handle;
+    if (mSecCamera->releasePreviewFrame(index, &buf) < 0) {
+        mWindow->cancel_buffer(mWindow, buf_handle);
+        mPreviewBufHandle[index] = NULL;
+        return false;
+    }
+
+    return true;
+}
+
+/* false when FIMC is left without any window buffer to capture into */
+bool CameraHardwareSec::refillStarvedPreviewBuffers()
+{
+    int queued = 0;
+
+    for (int i = 0; i < mPreviewBufCount; i++) {
+        if (mPreviewBufStarved[i] && refillPreviewBuffer(i))
+            mPreviewBufStarved[i] = false;
+        if (!mPreviewBufStarved[i])
+            queued++;
+    }
+
+    return queued > 0;
+}
+
+/* restarts the running preview with its own frames, the window buffers are cancelled */
+void CameraHardwareSec::fallBackToCopyPreview()
+{
+    Mutex::Autolock lock(mPreviewLock);
+
+    /* a stop in progress cancels the buffers itself */
+    if (!mPreviewRunning || mPreviewPaused || mExitPreviewThread)
+        return;
+
+    ALOGW("%s: no window buffer left for FIMC, copying preview frames", __func__);
+    mSecCamera->stopPreview();
+    cancelPreviewBuffers_l();
+    mPreviewZeroCopyBroken = true;
+    if (startPreview_l() != OK)
+        ALOGE("ERR(%s):Fail on startPreview_l", __func__);
+}
+
 void CameraHardwareSec::stopPreview()
 {
     ALOGV("%s :", __func__);
@@ -830,6 +1414,7 @@ void CameraHardwareSec::stopPreview_l()
     } else {
         ALOGD("%s : preview running but deferred, doing nothing", __func__);
     }
+    resetPreviewCallbacks();
 }
 
 bool CameraHardwareSec::previewEnabled()
@@ -977,152 +1562,341 @@ status_t CameraHardwareSec::cancelAutoFocus()
     return NO_ERROR;
 }
 
-bool CameraHardwareSec::scaleDownYuv422(char *srcBuf, uint32_t srcWidth, uint32_t srcHeight,
-                                        char *dstBuf, uint32_t dstWidth, uint32_t dstHeight)
+/* preallocates what one snapshot needs, a burst reuses the frames */
+bool CameraHardwareSec::allocPictureFrame(PictureFrame *frame)
 {
-    int32_t step_x, step_y;
-    int32_t iXsrc, iXdst;
-    int32_t x, y, src_y_start_pos, dst_pos, src_pos;
+    int width, height, frameSize;
+    int postViewWidth, postViewHeight, postViewSize;
 
-    if (dstWidth % 2 != 0 || dstHeight % 2 != 0){
-        ALOGE("scale_down_yuv422: invalid width, height for scaling");
-        return false;
-    }
+    mSecCamera->getSnapshotSize(&width, &height, &frameSize);
+    mSecCamera->getPostViewConfig(&postViewWidth, &postViewHeight, &postViewSize);
 
-    step_x = srcWidth / dstWidth;
-    step_y = srcHeight / dstHeight;
+    *frame = PictureFrame();
+    frame->hasRaw = true;
 
-    dst_pos = 0;
-    for (uint32_t y = 0; y < dstHeight; y++) {
-        src_y_start_pos = (y * step_y * (srcWidth * 2));
+    /* our back camera sensor has own jpeg encoder */
+    if (mSecCamera->getCameraId() == SecCamera::CAMERA_ID_BACK &&
+            mSecCamera->getSnapshotPixelFormat() == V4L2_PIX_FMT_JPEG)
+        return true;
 
-        for (uint32_t x = 0; x < dstWidth; x += 2) {
-            src_pos = src_y_start_pos + (x * (step_x * 2));
+    frame->hasExif = true;
+    /* a direct capture stays in the jpeg input, the heap only holds the postview */
+    frame->yuv = mSecCamera->getSnapshotBuf();
+    if (frame->yuv != NULL)
+        frame->yuvHeap = new MemoryHeapBase(postViewSize);
+    else
+        frame->yuvHeap = new MemoryHeapBase(postViewSize > width * height * 2 ?
+                                            postViewSize : width * height * 2);
 
-            dstBuf[dst_pos++] = srcBuf[src_pos    ];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 1];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 2];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 3];
-        }
-    }
+    if (frame->yuvHeap->getHeapID() < 0)
+        return false;
+    if (frame->yuv == NULL)
+        frame->yuv = (unsigned char *)frame->yuvHeap->base();
 
     return true;
 }
 
-int CameraHardwareSec::pictureThread()
+int CameraHardwareSec::capturePictureFrame(PictureFrame *frame)
 {
-    ALOGV("%s - start", __FUNCTION__);
-
-    int             ret = NO_ERROR;
-    int             pictureWidth  = 0;
-    int             pictureHeight = 0;
-    int             frameSize = 0;
-    int             postViewWidth = 0;
-    int             postViewHeight = 0;
-    int             postViewSize = 0;
-    int             thumbWidth = 0;
-    int             thumbHeight = 0;
-    int             thumbSize = 0;
-    unsigned int    picturePhyAddr = 0;
-
-    unsigned char*  jpegData = NULL;
-    unsigned int    jpegSize = 0;
-    /* * * * * * memory buffers * * * * * */
-    camera_memory_t*    jpegHeap = NULL;
-    sp<MemoryHeapBase>  postviewHeap = NULL;
-    sp<MemoryHeapBase>  thumbnailHeap = NULL;
-    struct addrs_cap*   addrs;
+    unsigned char *jpegData;
+    int ret;
 
-    mSecCamera->getSnapshotSize(&pictureWidth, &pictureHeight, &frameSize);
-    mSecCamera->getPostViewConfig(&postViewWidth, &postViewHeight, &postViewSize);
-    mSecCamera->getThumbnailConfig(&thumbWidth, &thumbHeight, &thumbSize);
+    if((mMsgEnabled & CAMERA_MSG_SHUTTER) && mNotifyCb) {
+        mNotifyCb(CAMERA_MSG_SHUTTER, 0, 0, mCallbackCookie);
+    }
 
-    addrs = (struct addrs_cap *)mRawHeap->data;
-    addrs[0].width  = pictureWidth;
-    addrs[0].height = pictureHeight;
+    if (frame->hasExif) {
+        ret = mSecCamera->getSnapshot(frame->yuv);
+        if (ret < 0 || frame->yuv == frame->yuvHeap->base())
+            return ret;
 
-    ret = mSecCamera->beginSnapshot(mCaptureMode == BURST);
-    CHECK_PICT(ret, "ERR(%s):Fail on SecCamera->beginSnapshot[%i]", __FUNCTION__, ret);
+        /* scale the postview out before anything else uses the jpeg input */
+        int width, height, frameSize;
+        int postViewWidth, postViewHeight, postViewSize;
 
-    do {
-        if((mMsgEnabled & CAMERA_MSG_SHUTTER) && mNotifyCb) {
-            mNotifyCb(CAMERA_MSG_SHUTTER, 0, 0, mCallbackCookie);
+        mSecCamera->getSnapshotSize(&width, &height, &frameSize);
+        mSecCamera->getPostViewConfig(&postViewWidth, &postViewHeight, &postViewSize);
+        if (!scaleYuv(frame->yuv, width, height,
+                      (unsigned char *)frame->yuvHeap->base(), postViewWidth, postViewHeight,
+                      mSecCamera->getSnapshotPixelFormat() == V4L2_PIX_FMT_UYVY ?
+                      YUV_SCALE_UYVY : YUV_SCALE_YUYV)) {
+            ALOGE("ERR(%s):Fail on scaleYuv()", __func__);
+            return UNKNOWN_ERROR;
         }
+        return NO_ERROR;
+    }
 
-        /* our back camera sensor has own jpeg encoder */
-        if(mSecCamera->getCameraId() == SecCamera::CAMERA_ID_BACK &&
-                    mSecCamera->getSnapshotPixelFormat() == V4L2_PIX_FMT_JPEG) {
-            ret = mSecCamera->getJpeg(&picturePhyAddr, &jpegData, &jpegSize);
-            CHECK_PICT(ret, "ERR(%s):Fail on SecCamera->getJpeg[%i]", __FUNCTION__, ret);
-        } else {
-            jpegHeap = mGetMemoryCb(-1, frameSize, 1, 0);
-            postviewHeap = new MemoryHeapBase(postViewSize);
-            thumbnailHeap = new MemoryHeapBase(thumbSize);
+    ret = mSecCamera->getJpeg(&frame->phyAddr, &jpegData, &frame->jpegSize);
+    if (ret < 0)
+        return ret;
 
-            ret = mSecCamera->getJpeg((unsigned char*)postviewHeap->base(),
-                                      (unsigned char*)jpegHeap->data, &jpegSize);
-            CHECK_PICT(ret, "ERR(%s):Fail on SecCamera->getSnapshotAndJpeg[%i]", __FUNCTION__, ret);
+    /* burst mode requeues the capture buffer, take the stream out now */
+    frame->jpegMem = mGetMemoryCb(-1, frame->jpegSize, 1, 0);
+    if (!frame->jpegMem) {
+        ALOGE("ERR(%s): JPEG heap creation fail", __func__);
+        return NO_MEMORY;
+    }
+    memcpy(frame->jpegMem->data, jpegData, frame->jpegSize);
 
-            if(!scaleDownYuv422((char *)postviewHeap->base(), postViewWidth, postViewHeight,
-                                (char *)thumbnailHeap->base(), thumbWidth, thumbHeight)) {
-                CHECK_PICT(UNKNOWN_ERROR, "ERR(%s):Fail on scaleDownYuv422()", __FUNCTION__);
-            }
-        }
+    return NO_ERROR;
+}
 
-        if((mMsgEnabled & CAMERA_MSG_RAW_IMAGE) && mDataCb) {
-            if(mSecCamera->getCameraId() == SecCamera::CAMERA_ID_BACK) {
-                if(picturePhyAddr != 0) {
-                    addrs[0].addr_y = picturePhyAddr;
-                }
-            } else {
-                memcpy(mRawHeap->data, postviewHeap->base(), postViewSize);
-            }
+int CameraHardwareSec::encodePictureFrame(PictureFrame *frame)
+{
+    int width, height, frameSize;
+    int ret;
 
-            mDataCb(CAMERA_MSG_RAW_IMAGE, mRawHeap, 0, NULL, mCallbackCookie);
-        } else if ((mMsgEnabled & CAMERA_MSG_RAW_IMAGE_NOTIFY) && mNotifyCb) {
-            mNotifyCb(CAMERA_MSG_RAW_IMAGE_NOTIFY, 0, 0, mCallbackCookie);
-        }
+    if (!frame->hasExif)
+        return NO_ERROR;
 
-        if((mMsgEnabled & CAMERA_MSG_COMPRESSED_IMAGE) && mDataCb) {
-            camera_memory_t* jpegMem = NULL;
-            if(jpegData != NULL) {
-                jpegMem = mGetMemoryCb(-1, jpegSize, 1, 0);
-                memcpy(jpegMem->data, jpegData, jpegSize);
-            } else {
-                camera_memory_t* exifHeap =
-                        mGetMemoryCb(-1, EXIF_FILE_SIZE + JPG_STREAM_BUF_SIZE, 1, 0);
-                int jpegExifSize = mSecCamera->getExif((unsigned char *)exifHeap->data,
-                        (unsigned char *)thumbnailHeap->base());
-                if (jpegExifSize < 0) {
-                    ret = UNKNOWN_ERROR;
-                    RELEASE_MEMORY_BUFFER(exifHeap);
-                    goto out;
-                }
+    mSecCamera->getSnapshotSize(&width, &height, &frameSize);
 
-                jpegMem = mGetMemoryCb(-1, jpegSize + jpegExifSize, 1, 0);
-                uint8_t *ptr = (uint8_t *) jpegMem->data;
-                memcpy(ptr, jpegHeap->data, 2); ptr += 2;
-                memcpy(ptr, exifHeap->data, jpegExifSize); ptr += jpegExifSize;
-                memcpy(ptr, (uint8_t *) jpegHeap->data + 2, jpegSize - 2);
-                RELEASE_MEMORY_BUFFER(exifHeap);
-            }
+    ret = mSecCamera->encodeJpeg(frame->yuv, width, height,
+                                 mSecCamera->getSnapshotPixelFormat(), &frame->jpegSize);
+    if (ret < 0) {
+        ALOGE("ERR(%s):Fail on SecCamera->encodeJpeg[%i]", __func__, ret);
+        return ret;
+    }
 
-            mDataCb(CAMERA_MSG_COMPRESSED_IMAGE, jpegMem, 0, NULL, mCallbackCookie);
-            RELEASE_MEMORY_BUFFER(jpegMem);
-        }
+    return assemblePictureFrame(frame);
+}
 
-        mCaptureLock.lock();
-        if(mCaptureCancel) {
-            mCaptureLock.unlock();
+/*
+ * builds the client's picture straight from the encoder, exif goes in after SOI.
+ * Must follow the frame's encodeJpeg before the encoder is used again.
+ */
+int CameraHardwareSec::assemblePictureFrame(PictureFrame *frame)
+{
+    if (!frame->hasExif || !(mMsgEnabled & CAMERA_MSG_COMPRESSED_IMAGE) || !mDataCb)
+        return NO_ERROR;
+
+    int jpegExifSize = mSecCamera->getExif(mExifBuf, frame->exifWidth, frame->exifHeight);
+    if (jpegExifSize < 0)
+        return UNKNOWN_ERROR;
+
+    frame->jpegMem = mGetMemoryCb(-1, frame->jpegSize + jpegExifSize, 1, 0);
+    if (!frame->jpegMem) {
+        ALOGE("ERR(%s): JPEG heap creation fail", __func__);
+        return NO_MEMORY;
+    }
+    if (mSecCamera->copyJpeg((unsigned char *)frame->jpegMem->data,
+                             mExifBuf, jpegExifSize) < 0) {
+        RELEASE_MEMORY_BUFFER(frame->jpegMem);
+        return UNKNOWN_ERROR;
+    }
+
+    return NO_ERROR;
+}
+
+void CameraHardwareSec::deliverPictureFrame(PictureFrame *frame)
+{
+    struct addrs_cap *addrs = (struct addrs_cap *)mRawHeap->data;
+    int postViewWidth, postViewHeight, postViewSize;
+
+    /* zsl frames have no postview, only tell the client the raw stage passed */
+    if(frame->hasRaw && (mMsgEnabled & CAMERA_MSG_RAW_IMAGE) && mDataCb) {
+        if(mSecCamera->getCameraId() == SecCamera::CAMERA_ID_BACK) {
+            if(frame->phyAddr != 0) {
+                addrs[0].addr_y = frame->phyAddr;
+            }
+        } else {
+            mSecCamera->getPostViewConfig(&postViewWidth, &postViewHeight, &postViewSize);
+            memcpy(mRawHeap->data, frame->yuvHeap->base(), postViewSize);
+        }
+
+        mDataCb(CAMERA_MSG_RAW_IMAGE, mRawHeap, 0, NULL, mCallbackCookie);
+    } else if ((mMsgEnabled & CAMERA_MSG_RAW_IMAGE_NOTIFY) && mNotifyCb) {
+        mNotifyCb(CAMERA_MSG_RAW_IMAGE_NOTIFY, 0, 0, mCallbackCookie);
+    }
+
+    if(frame->jpegMem && (mMsgEnabled & CAMERA_MSG_COMPRESSED_IMAGE) && mDataCb) {
+        mDataCb(CAMERA_MSG_COMPRESSED_IMAGE, frame->jpegMem, 0, NULL, mCallbackCookie);
+    }
+    RELEASE_MEMORY_BUFFER(frame->jpegMem);
+}
+
+/* capture runs here, encode and delivery on their own threads, kBurstDepth frames apart */
+int CameraHardwareSec::burstPictures()
+{
+    int ret = NO_ERROR;
+    bool started = false;
+
+    for (int i = 0; i < kBurstDepth && ret == NO_ERROR; i++) {
+        if (!allocPictureFrame(&mBurstFrames[i])) {
+            ALOGE("ERR(%s):Fail on allocPictureFrame", __func__);
+            ret = NO_MEMORY;
+        }
+    }
+
+    mBurstCaptured = 0;
+    mBurstEncoded = 0;
+    mBurstDelivered = 0;
+    mBurstCaptureDone = ret != NO_ERROR;
+    mBurstEncodeDone = false;
+    mBurstError = NO_ERROR;
+
+    if (ret == NO_ERROR) {
+        mBurstEncodeThread->run("CameraBurstEncodeThread", PRIORITY_DEFAULT);
+        mBurstDeliverThread->run("CameraBurstDeliverThread", PRIORITY_DEFAULT);
+        started = true;
+    }
+
+    while (ret == NO_ERROR) {
+        PictureFrame *frame;
+
+        /* wait for the oldest frame to be delivered */
+        mBurstLock.lock();
+        while (mBurstCaptured - mBurstDelivered >= kBurstDepth && mBurstError == NO_ERROR)
+            mBurstCondition.wait(mBurstLock);
+        ret = mBurstError;
+        frame = &mBurstFrames[mBurstCaptured % kBurstDepth];
+        mBurstLock.unlock();
+        if (ret != NO_ERROR)
+            break;
+
+        ret = capturePictureFrame(frame);
+        if (ret < 0) {
+            ALOGE("ERR(%s):Fail on capturePictureFrame[%i]", __func__, ret);
+            break;
+        }
+
+        mBurstLock.lock();
+        mBurstCaptured++;
+        mBurstCondition.broadcast();
+        mBurstLock.unlock();
+
+        mCaptureLock.lock();
+        if(mCaptureCancel) {
+            mCaptureLock.unlock();
             break;
         }
         mCaptureLock.unlock();
+    }
+
+    /*
+     * requestExit before a thread got to its first loop would skip it,
+     * so wait for the frames to drain and then only join
+     */
+    mBurstLock.lock();
+    mBurstCaptureDone = true;
+    mBurstCondition.broadcast();
+    while (started && !(mBurstEncodeDone && mBurstDelivered == mBurstEncoded))
+        mBurstCondition.wait(mBurstLock);
+    mBurstLock.unlock();
+
+    if (started) {
+        mBurstEncodeThread->join();
+        mBurstDeliverThread->join();
+    }
+
+    if (ret == NO_ERROR)
+        ret = mBurstError;
+    for (int i = 0; i < kBurstDepth; i++) {
+        RELEASE_MEMORY_BUFFER(mBurstFrames[i].jpegMem);
+        mBurstFrames[i] = PictureFrame();
+    }
+
+    return ret;
+}
+
+void CameraHardwareSec::burstEncodeThread()
+{
+    int ret = NO_ERROR;
+
+    mBurstLock.lock();
+    while (ret == NO_ERROR) {
+        while (mBurstEncoded == mBurstCaptured && !mBurstCaptureDone)
+            mBurstCondition.wait(mBurstLock);
+        if (mBurstEncoded == mBurstCaptured)
+            break;
 
-    } while(mCaptureMode == BURST && ret == NO_ERROR);
+        PictureFrame *frame = &mBurstFrames[mBurstEncoded % kBurstDepth];
+        mBurstLock.unlock();
+        ret = encodePictureFrame(frame);
+        mBurstLock.lock();
+
+        if (ret < 0)
+            mBurstError = ret;
+        else
+            mBurstEncoded++;
+        mBurstCondition.broadcast();
+    }
+    mBurstEncodeDone = true;
+    mBurstCondition.broadcast();
+    mBurstLock.unlock();
+}
+
+void CameraHardwareSec::burstDeliverThread()
+{
+    mBurstLock.lock();
+    while (1) {
+        while (mBurstDelivered == mBurstEncoded && !mBurstEncodeDone)
+            mBurstCondition.wait(mBurstLock);
+        if (mBurstDelivered == mBurstEncoded)
+            break;
+
+        PictureFrame *frame = &mBurstFrames[mBurstDelivered % kBurstDepth];
+        mBurstLock.unlock();
+        deliverPictureFrame(frame);
+        mBurstLock.lock();
+
+        mBurstDelivered++;
+        mBurstCondition.broadcast();
+    }
+    mBurstLock.unlock();
+}
+
+int CameraHardwareSec::pictureThread()
+{
+    ALOGV("%s - start", __FUNCTION__);
+
+    int             ret = NO_ERROR;
+    int             pictureWidth  = 0;
+    int             pictureHeight = 0;
+    int             frameSize = 0;
+    struct addrs_cap*   addrs;
+    PictureFrame        frame;
+    bool                zsl = mZslCapture;
+
+    mSecCamera->getSnapshotSize(&pictureWidth, &pictureHeight, &frameSize);
+
+    addrs = (struct addrs_cap *)mRawHeap->data;
+    addrs[0].width  = pictureWidth;
+    addrs[0].height = pictureHeight;
+
+    if (zsl) {
+        if((mMsgEnabled & CAMERA_MSG_SHUTTER) && mNotifyCb) {
+            mNotifyCb(CAMERA_MSG_SHUTTER, 0, 0, mCallbackCookie);
+        }
+        ret = encodeZslFrame(&frame);
+        CHECK_PICT(ret, "ERR(%s):Fail on encodeZslFrame[%i]", __FUNCTION__, ret);
+        ret = assemblePictureFrame(&frame);
+        CHECK_PICT(ret, "ERR(%s):Fail on assemblePictureFrame[%i]", __FUNCTION__, ret);
+        deliverPictureFrame(&frame);
+        goto out;
+    }
+
+    ret = mSecCamera->beginSnapshot(mCaptureMode == BURST);
+    CHECK_PICT(ret, "ERR(%s):Fail on SecCamera->beginSnapshot[%i]", __FUNCTION__, ret);
+
+    if (mCaptureMode == BURST) {
+        ret = burstPictures();
+        goto out;
+    }
+
+    if (!allocPictureFrame(&frame)) {
+        CHECK_PICT(NO_MEMORY, "ERR(%s):Fail on allocPictureFrame", __FUNCTION__);
+    }
+    ret = capturePictureFrame(&frame);
+    CHECK_PICT(ret, "ERR(%s):Fail on capturePictureFrame[%i]", __FUNCTION__, ret);
+    ret = encodePictureFrame(&frame);
+    CHECK_PICT(ret, "ERR(%s):Fail on encodePictureFrame[%i]", __FUNCTION__, ret);
+    deliverPictureFrame(&frame);
 
 out:
-    RELEASE_MEMORY_BUFFER(jpegHeap);
-    mSecCamera->endSnapshot();
+    RELEASE_MEMORY_BUFFER(frame.jpegMem);
+    if (!zsl)
+        mSecCamera->endSnapshot();
     mCaptureLock.lock();
     mCaptureInProgress = false;
     mCaptureCondition.broadcast();
@@ -1155,6 +1929,10 @@ status_t CameraHardwareSec::takePicture()
 {
     ALOGV("%s :", __func__);
 
+    if (waitForCaptureCompletion() != NO_ERROR) {
+        return TIMED_OUT;
+    }
+
 #if 0
     mPreviewLock.lock();
     if(!mPreviewPaused) {
@@ -1165,24 +1943,27 @@ status_t CameraHardwareSec::takePicture()
     }
     mPreviewLock.unlock();
 #else
-    stopPreview();
+    /* with a zsl frame at hand the preview keeps running */
+    mZslCapture = mZslEnabled && mPreviewRunning && freezeZslRing();
+    if (!mZslCapture)
+        stopPreview();
 #endif
 
-    if (waitForCaptureCompletion() != NO_ERROR) {
-        return TIMED_OUT;
-    }
-
     if (!mRawHeap) {
         ALOGV("mRawHeap : MemoryHeapBase(previewHeapSize(%d))", mPostViewSize);
         mRawHeap = mGetMemoryCb(-1, mPostViewSize, 1, 0);
         if (!mRawHeap) {
             ALOGE("ERR(%s): Raw heap creation fail", __func__);
+            if (mZslCapture)
+                resetZslRing();
             return UNKNOWN_ERROR;
         }
     }
 
     if (mPictureThread->run("CameraPictureThread", PRIORITY_DEFAULT) != NO_ERROR) {
         ALOGE("%s : couldn't run picture thread", __func__);
+        if (mZslCapture)
+            resetZslRing();
         return INVALID_OPERATION;
     }
 
@@ -1201,26 +1982,28 @@ status_t CameraHardwareSec::cancelPicture()
     return NO_ERROR;
 }
 
-/*
-status_t CameraHardwareSec::dump(int fd, const Vector<String16>& args) const
+status_t CameraHardwareSec::dump(int fd) const
 {
     const size_t SIZE = 256;
     char buffer[SIZE];
     String8 result;
 
     if (mSecCamera != 0) {
-        mSecCamera->dump(fd, args);
-        mParameters.dump(fd, args);
-        mInternalParameters.dump(fd, args);
         snprintf(buffer, 255, " preview running(%s)\n", mPreviewRunning?"true": "false");
         result.append(buffer);
+        snprintf(buffer, 255, " setParameters calls(%d), setters last call(%d)\n",
+                 mParamsCalls, mParamsApplied);
+        result.append(buffer);
+        snprintf(buffer, 255, " setParameters driver calls last(%d), total(%d)\n",
+                 mParamsDriverCalls, mParamsDriverCallsTotal);
+        result.append(buffer);
     } else {
         result.append("No camera client yet.\n");
     }
     write(fd, result.string(), result.size());
+    mParameters.dump(fd, Vector<String16>());
     return NO_ERROR;
 }
-*/
 
 bool CameraHardwareSec::isSupportedPreviewSize(const int width,
                                                const int height) const
@@ -1253,11 +2036,116 @@ status_t CameraHardwareSec::setParameters(const char *parameters)
     return setParameters(params);
 }
 
+/*
+ * Every setter with the keys it reads. setParameters only runs a handler when
+ * one of its keys differs from what was applied last time, or when it failed.
+ */
+const CameraHardwareSec::ParamHandler CameraHardwareSec::kParamHandlers[] = {
+    { { SecCameraParameters::KEY_PREVIEW_SIZE, SecCameraParameters::KEY_PREVIEW_FORMAT, NULL },
+      { NULL },
+      &CameraHardwareSec::applyPreviewSize },
+    { { SecCameraParameters::KEY_PICTURE_SIZE, NULL },
+      { NULL },
+      &CameraHardwareSec::applyPictureSize },
+    { { SecCameraParameters::KEY_BURST, NULL },
+      { NULL },
+      &CameraHardwareSec::applyCaptureMode },
+    { { SecCameraParameters::KEY_ZSL, SecCameraParameters::KEY_ZSL_BUFFER_SIZE, NULL },
+      { NULL },
+      &CameraHardwareSec::applyZsl },
+    { { SecCameraParameters::KEY_PICTURE_FORMAT, NULL },
+      { NULL },
+      &CameraHardwareSec::applyPictureFormat },
+    { { SecCameraParameters::KEY_JPEG_QUALITY, NULL },
+      { NULL },
+      &CameraHardwareSec::applyJpegQuality },
+    { { SecCameraParameters::KEY_JPEG_THUMBNAIL_WIDTH, SecCameraParameters::KEY_JPEG_THUMBNAIL_HEIGHT, NULL },
+      { NULL },
+      &CameraHardwareSec::applyJpegThumbnailSize },
+    { { SecCameraParameters::KEY_PREVIEW_FRAME_RATE, NULL },
+      { NULL },
+      &CameraHardwareSec::applyFrameRate },
+    { { SecCameraParameters::KEY_ROTATION, NULL },
+      { NULL },
+      &CameraHardwareSec::applyRotation },
+    { { SecCameraParameters::KEY_ZOOM, SecCameraParameters::KEY_MAX_ZOOM, NULL },
+      { NULL },
+      &CameraHardwareSec::applyZoom },
+    { { SecCameraParameters::KEY_EXPOSURE_COMPENSATION, SecCameraParameters::KEY_MAX_EXPOSURE_COMPENSATION, SecCameraParameters::KEY_MIN_EXPOSURE_COMPENSATION, NULL },
+      { NULL },
+      &CameraHardwareSec::applyExposureCompensation },
+    { { SecCameraParameters::KEY_CONTRAST, SecCameraParameters::KEY_MAX_CONTRAST, SecCameraParameters::KEY_MIN_CONTRAST, NULL },
+      { NULL },
+      &CameraHardwareSec::applyContrast },
+    { { SecCameraParameters::KEY_WHITE_BALANCE, NULL },
+      { NULL },
+      &CameraHardwareSec::applyWhiteBalance },
+    { { SecCameraParameters::KEY_ISO, NULL },
+      { NULL },
+      &CameraHardwareSec::applyIso },
+    { { SecCameraParameters::KEY_SCENE_MODE, SecCameraParameters::KEY_PREVIEW_FPS_RANGE, SecCameraParameters::KEY_FOCUS_MODE, SecCameraParameters::KEY_FLASH_MODE, NULL },
+      { NULL },
+      &CameraHardwareSec::applySceneMode },
+    { { SecCameraParameters::KEY_EFFECT, NULL },
+      { NULL },
+      &CameraHardwareSec::applyImageEffect },
+    { { NULL },
+      { "vtmode", NULL },
+      &CameraHardwareSec::applyVtMode },
+    { { NULL },
+      { "wdr", NULL },
+      &CameraHardwareSec::applyWdr },
+    { { SecCameraParameters::KEY_VIDEO_STABILIZATION, NULL },
+      { NULL },
+      &CameraHardwareSec::applyVideoStabilization },
+    { { SecCameraParameters::KEY_GPS_LATITUDE, SecCameraParameters::KEY_GPS_LONGITUDE, SecCameraParameters::KEY_GPS_ALTITUDE, SecCameraParameters::KEY_GPS_TIMESTAMP, SecCameraParameters::KEY_GPS_PROCESSING_METHOD, NULL },
+      { NULL },
+      &CameraHardwareSec::applyGps },
+    { { SecCameraParameters::KEY_FOCUS_AREAS, SecCameraParameters::KEY_PREVIEW_SIZE, NULL },
+      { NULL },
+      &CameraHardwareSec::applyFocusAreas },
+    { { SecCameraParameters::KEY_PREVIEW_SIZE, NULL },
+      { "recording-size-width", "recording-size-height", NULL },
+      &CameraHardwareSec::applyRecordingSize },
+    { { NULL },
+      { "video_recording_gamma", NULL },
+      &CameraHardwareSec::applyGamma },
+    { { NULL },
+      { "slow_ae", NULL },
+      &CameraHardwareSec::applySlowAe },
+    { { NULL },
+      { "cam_mode", NULL },
+      &CameraHardwareSec::applySensorMode },
+    { { NULL },
+      { "shot_mode", NULL },
+      &CameraHardwareSec::applyShotMode },
+    { { NULL },
+      { "blur", NULL },
+      &CameraHardwareSec::applyBlur },
+    { { NULL },
+      { "chk_dataline", NULL },
+      &CameraHardwareSec::applyDataLineCheck },
+};
+
+static bool paramChanged(const CameraParameters& params, const CameraParameters& last,
+                         const char *key)
+{
+    const char *value = params.get(key);
+    const char *lastValue = last.get(key);
+
+    if (value == NULL || lastValue == NULL)
+        return value != lastValue;
+    return strcmp(value, lastValue) != 0;
+}
+
 status_t CameraHardwareSec::setParameters(const CameraParameters& params)
 {
     ALOGV("%s :", __func__);
 
     status_t ret = NO_ERROR;
+    uint32_t stale = 0;
+    int applied = 0;
+    int driverCalls = mSecCamera->getDriverCallCount();
 
     /* if someone calls us while picture thread is running, it could screw
      * up the sensor quite a bit so try to wait and after that return error.
@@ -1266,6 +2154,52 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         return TIMED_OUT;
     }
 
+    for (int i = 0; i < kParamHandlerCount; i++) {
+        const ParamHandler *handler = &kParamHandlers[i];
+        bool changed = mParamsStale & (1 << i);
+
+        for (int k = 0; !changed && handler->keys[k] != NULL; k++)
+            changed = paramChanged(params, mLastParameters, handler->keys[k]);
+        for (int k = 0; !changed && handler->internalKeys[k] != NULL; k++)
+            changed = paramChanged(mInternalParameters, mLastInternalParameters,
+                                   handler->internalKeys[k]);
+        if (!changed)
+            continue;
+
+        status_t err = (this->*handler->apply)(params);
+        if (err != NO_ERROR) {
+            /* bad values are tried again next time, even if they don't change */
+            stale |= 1 << i;
+            ret = err;
+        }
+        applied++;
+    }
+    mParamsStale = stale;
+    mLastParameters = params;
+    mLastInternalParameters = mInternalParameters;
+
+    // galaxys ce147 need this
+    mPreviewLock.lock();
+    if(ret == NO_ERROR && mPreviewRunning && applied > 0) {
+        ret = mSecCamera->setBatchReflection();
+    }
+    mPreviewLock.unlock();
+
+    mParamsCalls++;
+    mParamsApplied = applied;
+    mParamsDriverCalls = mSecCamera->getDriverCallCount() - driverCalls;
+    mParamsDriverCallsTotal += mParamsDriverCalls;
+
+    ALOGV("%s return ret = %d, %d setters, %d driver calls",
+          __func__, ret, applied, mParamsDriverCalls);
+
+    return ret;
+}
+
+status_t CameraHardwareSec::applyPreviewSize(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // preview size
     int new_preview_width  = 0;
     int new_preview_height = 0;
@@ -1303,6 +2237,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         ret = INVALID_OPERATION;
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyPictureSize(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     int new_picture_width  = 0;
     int new_picture_height = 0;
 
@@ -1318,6 +2259,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyCaptureMode(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // burst mode
     const char* burst_mode = params.get(SecCameraParameters::KEY_BURST);
     if (burst_mode && !strcmp(burst_mode, SecCameraParameters::TRUE)) {
@@ -1326,6 +2274,36 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         mCaptureMode = SNAPSHOT;
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyZsl(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
+    // zero shutter lag, a new budget resizes the ring on the next frame
+    const char* zsl_mode = params.get(SecCameraParameters::KEY_ZSL);
+    int new_zsl_budget = params.getInt(SecCameraParameters::KEY_ZSL_BUFFER_SIZE);
+    bool new_zsl = zsl_mode && !strcmp(zsl_mode, SecCameraParameters::TRUE);
+    if (new_zsl_budget <= 0)
+        new_zsl_budget = DEFAULT_ZSL_BUFFER_SIZE;
+    if (new_zsl != mZslEnabled || new_zsl_budget * 1024 != mZslBudget) {
+        mZslEnabled = false;
+        resetZslRing();
+        mZslBudget = new_zsl_budget * 1024;
+        mZslEnabled = new_zsl;
+        mParameters.set(SecCameraParameters::KEY_ZSL,
+                        new_zsl ? SecCameraParameters::TRUE : SecCameraParameters::FALSE);
+        mParameters.set(SecCameraParameters::KEY_ZSL_BUFFER_SIZE, new_zsl_budget);
+    }
+
+    return ret;
+}
+
+status_t CameraHardwareSec::applyPictureFormat(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // picture format
     const char *new_str_picture_format = params.getPictureFormat();
     ALOGV("%s : new_str_picture_format %s", __func__, new_str_picture_format);
@@ -1362,6 +2340,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyJpegQuality(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //JPEG image quality
     int new_jpeg_quality = params.getInt(SecCameraParameters::KEY_JPEG_QUALITY);
     ALOGV("%s : new_jpeg_quality %d", __func__, new_jpeg_quality);
@@ -1375,6 +2360,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyJpegThumbnailSize(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // JPEG thumbnail size
     int new_jpeg_thumbnail_width = params.getInt(SecCameraParameters::KEY_JPEG_THUMBNAIL_WIDTH);
     int new_jpeg_thumbnail_height= params.getInt(SecCameraParameters::KEY_JPEG_THUMBNAIL_HEIGHT);
@@ -1388,6 +2380,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyFrameRate(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // frame rate
     int new_frame_rate = params.getPreviewFrameRate();
     /* ignore any fps request, we're determine fps automatically based
@@ -1398,6 +2397,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
              __func__, new_frame_rate, mParameters.getPreviewFrameRate());
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyRotation(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // rotation
     int new_rotation = params.getInt(SecCameraParameters::KEY_ROTATION);
     ALOGV("%s : new_rotation %d", __func__, new_rotation);
@@ -1411,6 +2417,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyZoom(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // zoom
     int new_zoom = params.getInt(SecCameraParameters::KEY_ZOOM);
     int max_zoom = params.getInt(SecCameraParameters::KEY_MAX_ZOOM);
@@ -1425,6 +2438,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyExposureCompensation(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // brightness
     int new_exposure_compensation = params.getInt(SecCameraParameters::KEY_EXPOSURE_COMPENSATION);
     int max_exposure_compensation = params.getInt(SecCameraParameters::KEY_MAX_EXPOSURE_COMPENSATION);
@@ -1440,21 +2460,35 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyContrast(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // contrast
     int new_contrast = params.getInt(SecCameraParameters::KEY_CONTRAST);
     int max_contrast = params.getInt(SecCameraParameters::KEY_MAX_CONTRAST);
     int min_contrast = params.getInt(SecCameraParameters::KEY_MIN_CONTRAST);
-    ALOGV("%s : new_exposure_compensation %d", __func__, new_exposure_compensation);
+    ALOGV("%s : new_contrast %d", __func__, new_contrast);
     if ((min_contrast <= new_contrast) &&
         (max_contrast >= new_contrast)) {
         if (mSecCamera->setContrast(new_contrast) < 0) {
-            ALOGE("ERR(%s):Fail on mSecCamera->setContrast(brightness(%d))", __func__, new_exposure_compensation);
+            ALOGE("ERR(%s):Fail on mSecCamera->setContrast(contrast(%d))", __func__, new_contrast);
             ret = UNKNOWN_ERROR;
         } else {
             mParameters.set(SecCameraParameters::KEY_CONTRAST, new_contrast);
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyWhiteBalance(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // whitebalance
     const char *new_white_str = params.get(SecCameraParameters::KEY_WHITE_BALANCE);
     ALOGV("%s : new_white_str %s", __func__, new_white_str);
@@ -1490,6 +2524,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyIso(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // iso mode
     const char *new_iso_str = params.get(SecCameraParameters::KEY_ISO);
     if (new_iso_str != NULL) {
@@ -1531,6 +2572,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applySceneMode(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // scene mode
     const char *new_scene_mode_str = params.get(SecCameraParameters::KEY_SCENE_MODE);
     const char *current_scene_mode_str = mParameters.get(SecCameraParameters::KEY_SCENE_MODE);
@@ -1697,7 +2745,12 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
-    // ---------------------------------------------------------------------------
+    return ret;
+}
+
+status_t CameraHardwareSec::applyImageEffect(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
 
     // image effect
     const char *new_image_effect_str = params.get(SecCameraParameters::KEY_EFFECT);
@@ -1742,6 +2795,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyVtMode(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //vt mode
     int new_vtmode = mInternalParameters.getInt("vtmode");
     if (0 <= new_vtmode) {
@@ -1751,6 +2811,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyWdr(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //WDR
     int new_wdr = mInternalParameters.getInt("wdr");
     if (0 <= new_wdr) {
@@ -1760,6 +2827,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyVideoStabilization(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // video stabilization
     const char* video_stabilization = params.get(SecCameraParameters::KEY_VIDEO_STABILIZATION);
     if (video_stabilization) {
@@ -1770,6 +2844,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyGps(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // gps latitude
     const char *new_gps_latitude_str = params.get(SecCameraParameters::KEY_GPS_LATITUDE);
     if (mSecCamera->setGPSLatitude(new_gps_latitude_str) < 0) {
@@ -1835,6 +2916,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyFocusAreas(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // focus areas
     const char *new_focus_area = params.get(SecCameraParameters::KEY_FOCUS_AREAS);
     if (new_focus_area != NULL) {
@@ -1865,7 +2953,17 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
-    // Recording size
+    return ret;
+}
+
+status_t CameraHardwareSec::applyRecordingSize(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
+    // Recording size, the preview size unless set
+    int new_preview_width  = 0;
+    int new_preview_height = 0;
+    params.getPreviewSize(&new_preview_width, &new_preview_height);
     int new_recording_width = mInternalParameters.getInt("recording-size-width");
     int new_recording_height= mInternalParameters.getInt("recording-size-height");
     if (0 < new_recording_width && 0 < new_recording_height) {
@@ -1880,6 +2978,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyGamma(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //gamma
     const char *new_gamma_str = mInternalParameters.get("video_recording_gamma");
     if (new_gamma_str != NULL) {
@@ -1901,6 +3006,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applySlowAe(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //slow ae
     const char *new_slow_ae_str = mInternalParameters.get("slow_ae");
     if (new_slow_ae_str != NULL) {
@@ -1923,6 +3035,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applySensorMode(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     /*Camcorder fix fps*/
     int new_sensor_mode = mInternalParameters.getInt("cam_mode");
     if (0 <= new_sensor_mode) {
@@ -1934,6 +3053,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         new_sensor_mode=0;
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyShotMode(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     /*Shot mode*/
     int new_shot_mode = mInternalParameters.getInt("shot_mode");
     if (0 <= new_shot_mode) {
@@ -1945,6 +3071,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         new_shot_mode=0;
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyBlur(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     //blur for Video call
     int new_blur_level = mInternalParameters.getInt("blur");
     if (0 <= new_blur_level) {
@@ -1954,6 +3087,13 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
+    return ret;
+}
+
+status_t CameraHardwareSec::applyDataLineCheck(const CameraParameters& params)
+{
+    status_t ret = NO_ERROR;
+
     // chk_dataline
     int new_dataline = mInternalParameters.getInt("chk_dataline");
     if (0 <= new_dataline) {
@@ -1963,15 +3103,6 @@ status_t CameraHardwareSec::setParameters(const CameraParameters& params)
         }
     }
 
-    // galaxys ce147 need this
-    mPreviewLock.lock();
-    if(ret == NO_ERROR && mPreviewRunning) {
-        ret = mSecCamera->setBatchReflection();
-    }
-    mPreviewLock.unlock();
-
-    ALOGV("%s return ret = %d", __func__, ret);
-
     return ret;
 }
 
@@ -2041,6 +3172,16 @@ void CameraHardwareSec::release()
         mPreviewThread.clear();
         mPreviewThread = NULL;
     }
+    if (mPreviewCallbackThread != NULL) {
+        mCallbackLock.lock();
+        mPreviewCallbackThread->requestExit();
+        mExitCallbackThread = true;
+        mCallbackCondition.signal();
+        mCallbackLock.unlock();
+        mPreviewCallbackThread->requestExitAndWait();
+        mPreviewCallbackThread.clear();
+        mPreviewCallbackThread = NULL;
+    }
     if (mAutoFocusThread != NULL) {
         /* this thread is normally already in it's threadLoop but blocked
          * on the condition variable.  signal it so it wakes up and can exit.
@@ -2059,9 +3200,14 @@ void CameraHardwareSec::release()
         mPictureThread.clear();
         mPictureThread = NULL;
     }
+    mBurstEncodeThread.clear();
+    mBurstDeliverThread.clear();
 
     RELEASE_MEMORY_BUFFER(mRawHeap);
     RELEASE_MEMORY_BUFFER(mPreviewMemory);
+    RELEASE_MEMORY_BUFFER(mPreviewCallbackHeap);
+    RELEASE_MEMORY_BUFFER(mCallbackHeapRetired);
+    RELEASE_MEMORY_BUFFER(mZslHeap);
     RELEASE_MEMORY_BUFFER(mRecordHeap);
 
     /* close after all the heaps are cleared since those
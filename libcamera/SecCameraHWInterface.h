@@ -73,9 +73,14 @@ public:
     status_t    sendCommand(int32_t command, int32_t arg1,
                                     int32_t arg2);
     void        release();
+    status_t    dump(int fd) const;
 
 private:
     static  const int   kBufferCount = MAX_BUFFERS;
+    static  const int   kMaxCallbackBufferCount = 8;
+    static  const int   kMaxZslBufferCount = 8;
+    static  const int   kBurstDepth = 3;
+    static  const int   kParamHandlerCount = 28;
 
     enum CaptureMode {
         INVALID,
@@ -98,6 +103,18 @@ private:
         }
     };
 
+    class PreviewCallbackThread : public Thread {
+        CameraHardwareSec *mHardware;
+    public:
+        PreviewCallbackThread(CameraHardwareSec *hw): Thread(false), mHardware(hw) { }
+        virtual void onFirstRef() {
+            run("CameraPreviewCallbackThread", PRIORITY_DEFAULT);
+        }
+        virtual bool threadLoop() {
+            return mHardware->previewCallbackThread();
+        }
+    };
+
     class PictureThread : public Thread {
         CameraHardwareSec *mHardware;
     public:
@@ -110,6 +127,42 @@ private:
         }
     };
 
+    class BurstEncodeThread : public Thread {
+        CameraHardwareSec *mHardware;
+    public:
+        BurstEncodeThread(CameraHardwareSec *hw): Thread(false), mHardware(hw) { }
+        virtual bool threadLoop() {
+            mHardware->burstEncodeThread();
+            return false;
+        }
+    };
+
+    class BurstDeliverThread : public Thread {
+        CameraHardwareSec *mHardware;
+    public:
+        BurstDeliverThread(CameraHardwareSec *hw): Thread(false), mHardware(hw) { }
+        virtual bool threadLoop() {
+            mHardware->burstDeliverThread();
+            return false;
+        }
+    };
+
+    /* one picture on its way from capture through encode to the client */
+    struct PictureFrame {
+        sp<MemoryHeapBase>  yuvHeap;        /* postview, the encoder input unless captured direct */
+        unsigned char*      yuv;            /* snapshot the encoder reads */
+        unsigned int        jpegSize;       /* left in the encoder, exif still missing */
+        unsigned int        phyAddr;
+        int                 exifWidth;
+        int                 exifHeight;
+        bool                hasRaw;
+        bool                hasExif;
+        camera_memory_t*    jpegMem;        /* the assembled picture */
+
+        PictureFrame() : yuv(NULL), jpegSize(0), phyAddr(0), exifWidth(0), exifHeight(0),
+                         hasRaw(false), hasExif(false), jpegMem(NULL) { }
+    };
+
     class AutoFocusThread : public Thread {
         CameraHardwareSec *mHardware;
     public:
@@ -127,24 +180,54 @@ private:
 
     status_t            startPreview_l();
     void                stopPreview_l();
+            bool        registerPreviewBuffers_l();
+            void        cancelPreviewBuffers_l();
+            bool        getPreviewUserBuffer(buffer_handle_t *buf_handle, int stride,
+                                             fimc_user_buffer *buf);
+            void        queuePreviewBuffer(int index);
+            bool        refillPreviewBuffer(int index);
+            bool        refillStarvedPreviewBuffers();
+            void        fallBackToCopyPreview();
+            int         acquirePreviewCallback(int frame_size, camera_memory_t **heap);
+            void        postPreviewCallback(int slot);
+            void        resetPreviewCallbacks();
+            void        storeZslFrame(const char *y, const char *u, const char *v,
+                                      int width, int height, int frame_size,
+                                      nsecs_t timestamp);
+            bool        freezeZslRing();
+            void        resetZslRing();
+            int         encodeZslFrame(PictureFrame *frame);
 
     sp<PreviewThread>   mPreviewThread;
             int         previewThread();
             int         previewThreadWrapper();
 
+    sp<PreviewCallbackThread> mPreviewCallbackThread;
+            bool        previewCallbackThread();
+
     sp<AutoFocusThread> mAutoFocusThread;
             int         autoFocusThread();
 
     sp<PictureThread>   mPictureThread;
             int         pictureThread();
+            int         burstPictures();
+            bool        allocPictureFrame(PictureFrame *frame);
+            int         capturePictureFrame(PictureFrame *frame);
+            int         encodePictureFrame(PictureFrame *frame);
+            int         assemblePictureFrame(PictureFrame *frame);
+            void        deliverPictureFrame(PictureFrame *frame);
+
+    sp<BurstEncodeThread>  mBurstEncodeThread;
+    sp<BurstDeliverThread> mBurstDeliverThread;
+            void        burstEncodeThread();
+            void        burstDeliverThread();
             CaptureMode mCaptureMode;
+            bool        mZslCapture;
+            /* exif of the picture being assembled */
+            unsigned char mExifBuf[EXIF_FILE_SIZE];
             bool        mCaptureInProgress;
             bool        mCaptureCancel;
 
-            bool        scaleDownYuv422(char *srcBuf, uint32_t srcWidth,
-                                        uint32_t srcHight, char *dstBuf,
-                                        uint32_t dstWidth, uint32_t dstHight);
-
             void        setSkipFrame(int frame);
             bool        isSupportedPreviewSize(const int width,
                                                const int height) const;
@@ -164,6 +247,46 @@ private:
     volatile bool       mExitPreviewThread;
     volatile bool       mFaceDetectStarted;
 
+    /* ring of client preview buffers, handed to the client by the callback thread */
+    mutable Mutex       mCallbackLock;
+    mutable Condition   mCallbackCondition;
+    volatile bool       mExitCallbackThread;
+    int                 mCallbackBufferCount;
+    bool                mCallbackBusy[kMaxCallbackBufferCount];
+    int                 mCallbackQueue[kMaxCallbackBufferCount];
+    int                 mCallbackQueueHead;
+    int                 mCallbackQueued;
+    camera_memory_t*    mCallbackHeapInUse;
+    camera_memory_t*    mCallbackHeapRetired;
+    unsigned int        mCallbackDropped;
+
+    /* zero shutter lag: the newest preview frames, frozen while a picture is taken */
+    mutable Mutex       mZslLock;
+    volatile bool       mZslEnabled;
+    int                 mZslBudget;
+    camera_memory_t*    mZslHeap;
+    int                 mZslBufferCount;
+    int                 mZslWidth;
+    int                 mZslHeight;
+    int                 mZslFrameSize;
+    int                 mZslHead;
+    int                 mZslCount;
+    bool                mZslFrozen;
+    bool                mZslHeapFailed;
+    nsecs_t             mZslShutter;
+    nsecs_t             mZslTimestamp[kMaxZslBufferCount];
+
+    /* burst pipeline, frames move capture -> encode -> deliver through the ring */
+    mutable Mutex       mBurstLock;
+    mutable Condition   mBurstCondition;
+    PictureFrame        mBurstFrames[kBurstDepth];
+    int                 mBurstCaptured;
+    int                 mBurstEncoded;
+    int                 mBurstDelivered;
+    bool                mBurstCaptureDone;
+    bool                mBurstEncodeDone;
+    int                 mBurstError;
+
     /* used to guard mCaptureInProgress */
     mutable Mutex       mCaptureLock;
     mutable Condition   mCaptureCondition;
@@ -171,7 +294,52 @@ private:
     CameraParameters    mParameters;
     CameraParameters    mInternalParameters;
 
+    /* setParameters applies only what changed since these */
+    struct ParamHandler {
+        const char  *keys[6];
+        const char  *internalKeys[3];
+        status_t    (CameraHardwareSec::*apply)(const CameraParameters& params);
+    };
+    static const ParamHandler kParamHandlers[kParamHandlerCount];
+            status_t    applyPreviewSize(const CameraParameters& params);
+            status_t    applyPictureSize(const CameraParameters& params);
+            status_t    applyCaptureMode(const CameraParameters& params);
+            status_t    applyZsl(const CameraParameters& params);
+            status_t    applyPictureFormat(const CameraParameters& params);
+            status_t    applyJpegQuality(const CameraParameters& params);
+            status_t    applyJpegThumbnailSize(const CameraParameters& params);
+            status_t    applyFrameRate(const CameraParameters& params);
+            status_t    applyRotation(const CameraParameters& params);
+            status_t    applyZoom(const CameraParameters& params);
+            status_t    applyExposureCompensation(const CameraParameters& params);
+            status_t    applyContrast(const CameraParameters& params);
+            status_t    applyWhiteBalance(const CameraParameters& params);
+            status_t    applyIso(const CameraParameters& params);
+            status_t    applySceneMode(const CameraParameters& params);
+            status_t    applyImageEffect(const CameraParameters& params);
+            status_t    applyVtMode(const CameraParameters& params);
+            status_t    applyWdr(const CameraParameters& params);
+            status_t    applyVideoStabilization(const CameraParameters& params);
+            status_t    applyGps(const CameraParameters& params);
+            status_t    applyFocusAreas(const CameraParameters& params);
+            status_t    applyRecordingSize(const CameraParameters& params);
+            status_t    applyGamma(const CameraParameters& params);
+            status_t    applySlowAe(const CameraParameters& params);
+            status_t    applySensorMode(const CameraParameters& params);
+            status_t    applyShotMode(const CameraParameters& params);
+            status_t    applyBlur(const CameraParameters& params);
+            status_t    applyDataLineCheck(const CameraParameters& params);
+
+    CameraParameters    mLastParameters;
+    CameraParameters    mLastInternalParameters;
+    uint32_t            mParamsStale;
+    int                 mParamsCalls;
+    int                 mParamsApplied;
+    int                 mParamsDriverCalls;
+    int                 mParamsDriverCallsTotal;
+
     camera_memory_t*    mPreviewMemory;
+    camera_memory_t*    mPreviewCallbackHeap;
     camera_memory_t*    mRawHeap;
     camera_memory_t*    mRecordHeap;
 
@@ -182,6 +350,14 @@ private:
     int                 mSkipFrame;
 
     preview_stream_ops* mWindow;
+    int                 mWindowMinUndequeued;
+
+    /* zero-copy preview: FIMC captures straight into the window buffers */
+    bool                mPreviewZeroCopy;
+    bool                mPreviewZeroCopyBroken;
+    int                 mPreviewBufCount;
+    buffer_handle_t*    mPreviewBufHandle[kBufferCount];
+    bool                mPreviewBufStarved[kBufferCount];
 
     camera_notify_callback mNotifyCb;
     camera_data_callback mDataCb;
@@ -25,6 +25,10 @@ const char SecCameraParameters::KEY_VIDEO_STABILIZATION_SUPPORTED[] = "video-sta
 const char SecCameraParameters::KEY_BURST[] = "burst-capture";
 const char SecCameraParameters::KEY_BURST_SUPPORTED[] = "burst-capture-supported";
 
+const char SecCameraParameters::KEY_ZSL[] = "zsl";
+const char SecCameraParameters::KEY_ZSL_SUPPORTED[] = "zsl-supported";
+const char SecCameraParameters::KEY_ZSL_BUFFER_SIZE[] = "zsl-buffer-size";
+
 const char SecCameraParameters::KEY_ISO[] = "iso";
 const char SecCameraParameters::KEY_SUPPORTED_ISO_MODES[] = "iso-values";
 
@@ -98,6 +98,10 @@ public:
     static const char KEY_BURST[];
     static const char KEY_BURST_SUPPORTED[];
 
+    static const char KEY_ZSL[];
+    static const char KEY_ZSL_SUPPORTED[];
+    static const char KEY_ZSL_BUFFER_SIZE[];
+
     static const char KEY_ISO[];
     static const char KEY_SUPPORTED_ISO_MODES[];
 
@@ -318,7 +318,6 @@ void camera_release(struct camera_device * device)
     hw->release();
 }
 
-/*
 int camera_dump(struct camera_device * device, int fd)
 {
     CameraHardwareSec* hw = sec_obtain_hw(device);
@@ -326,7 +325,6 @@ int camera_dump(struct camera_device * device, int fd)
 
     return hw->dump(fd);
 }
-*/
 
 extern "C" void heaptracker_free_leaked_memory(void);
 
@@ -451,7 +449,7 @@ int camera_device_open(const hw_module_t* module, const char* name,
         camera_ops->put_parameters = camera_put_parameters;
         camera_ops->send_command = camera_send_command;
         camera_ops->release = camera_release;
-        camera_ops->dump = NULL;
+        camera_ops->dump = camera_dump;
 
         *device = &camera_device->base.common;
 
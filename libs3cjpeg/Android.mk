@@ -20,7 +20,8 @@ LOCAL_C_INCLUDES := $(LOCAL_PATH)
 LOCAL_C_INCLUDES += $(LOCAL_PATH)/../include
 
 LOCAL_SRC_FILES:= \
-	JpegEncoder.cpp
+	JpegEncoder.cpp \
+	YuvScaler.cpp
 
 LOCAL_SHARED_LIBRARIES:= liblog
 LOCAL_SHARED_LIBRARIES+= libdl
@@ -28,6 +28,7 @@
 #include <fcntl.h>
 
 #include "JpegEncoder.h"
+#include "YuvScaler.h"
 
 #define MAX_JPG_WIDTH                   800
 #define MAX_JPG_HEIGHT                  480
@@ -231,6 +232,19 @@ void* JpegEncoder::getInBuf(uint64_t size)
     return (void *)(mArgs.in_buf);
 }
 
+/* physical address of the input frame buffer, for devices that DMA into it */
+unsigned int JpegEncoder::getPhyInBuf(uint64_t size)
+{
+    if (!available)
+        return 0;
+
+    if (size > mInfo.frame_buf_size) {
+        ALOGE("The buffer size requested is too large");
+        return 0;
+    }
+    return (unsigned int)ioctl(mDevFd, IOCTL_JPG_GET_PHY_FRMBUF, mArgs.mmapped_addr);
+}
+
 void* JpegEncoder::getOutBuf(uint64_t *size)
 {
     if (!available)
@@ -371,13 +385,13 @@ jpg_return_status JpegEncoder::encodeThumbImg(unsigned int *size, bool useMain)
             return JPG_FAIL;
         }
 
-        ret = (jpg_return_status)scaleDownYuv422(mArgs.in_buf,
-                                                 mArgs.enc_param->width,
-                                                 mArgs.enc_param->height,
-                                                 mArgs.in_thumb_buf,
-                                                 param->width,
-                                                 param->height);
-        if (ret != JPG_SUCCESS)
+        if (!scaleYuv((unsigned char *)mArgs.in_buf,
+                      mArgs.enc_param->width,
+                      mArgs.enc_param->height,
+                      (unsigned char *)mArgs.in_thumb_buf,
+                      param->width,
+                      param->height,
+                      YUV_SCALE_YUYV))
             return JPG_FAIL;
     }
 
@@ -736,41 +750,6 @@ bool JpegEncoder::pad(char *srcBuf, uint32_t srcWidth, uint32_t srcHight,
     return true;
 }
 
-bool JpegEncoder::scaleDownYuv422(char *srcBuf, uint32_t srcWidth, uint32_t srcHight,
-                                  char *dstBuf, uint32_t dstWidth, uint32_t dstHight)
-{
-    if (!available)
-        return false;
-
-    int32_t step_x, step_y;
-    int32_t iXsrc, iXdst;
-    int32_t x, y, src_y_start_pos, dst_pos, src_pos;
-
-    if (dstWidth % 2 != 0 || dstHight % 2 != 0){
-        ALOGE("scale_down_yuv422: invalid width, height for scaling");
-        return false;
-    }
-
-    step_x = srcWidth / dstWidth;
-    step_y = srcHight / dstHight;
-
-    dst_pos = 0;
-    for (uint32_t y = 0; y < dstHight; y++) {
-        src_y_start_pos = (y * step_y * (srcWidth * 2));
-
-        for (uint32_t x = 0; x < dstWidth; x += 2) {
-            src_pos = src_y_start_pos + (x * (step_x * 2));
-
-            dstBuf[dst_pos++] = srcBuf[src_pos    ];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 1];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 2];
-            dstBuf[dst_pos++] = srcBuf[src_pos + 3];
-        }
-    }
-
-    return true;
-}
-
 inline void JpegEncoder::writeExifIfd(unsigned char **pCur,
                                          unsigned short tag,
                                          unsigned short type,
@@ -164,6 +164,7 @@ public:
     int openHardware();
     jpg_return_status setConfig(jpeg_conf type, int32_t value);
     void *getInBuf(uint64_t size);
+    unsigned int getPhyInBuf(uint64_t size);
     void *getOutBuf(uint64_t *size);
     void *getThumbInBuf(uint64_t size);
     void *getThumbOutBuf(uint64_t *size);
@@ -178,8 +179,6 @@ private:
     jpg_return_status checkMcu(sample_mode_t sampleMode, uint32_t width, uint32_t height, bool isThumb);
     bool pad(char *srcBuf, uint32_t srcWidth, uint32_t srcHight,
              char *dstBuf, uint32_t dstWidth, uint32_t dstHight);
-    bool scaleDownYuv422(char *srcBuf, uint32_t srcWidth, uint32_t srcHight,
-                         char *dstBuf, uint32_t dstWidth, uint32_t dstHight);
 
     inline void writeExifIfd(unsigned char **pCur,
                                  unsigned short tag,
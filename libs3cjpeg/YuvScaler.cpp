@@ -0,0 +1,317 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * YUV SCALER (YuvScaler.cpp)
+ * Purpose : Separable box and bilinear resizing of packed 4:2:2 and
+ *           semi-planar 4:2:0 frames. Rows are filtered horizontally into
+ *           16 bit intermediates, then blended vertically with NEON or SSE2.
+ */
+#define LOG_TAG "YuvScaler"
+
+#include <stdlib.h>
+#include <string.h>
+#include <utils/Log.h>
+
+#if defined(__ARM_NEON__)
+#include <arm_neon.h>
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
+#include "YuvScaler.h"
+
+namespace android {
+
+/* weights are 2.14 fixed point, intermediate rows keep 6 fraction bits */
+#define WEIGHT_BITS     14
+#define ROW_BITS        6
+
+/* which source samples, and how much of each, make up every output sample of an axis */
+typedef struct {
+    int         size;
+    int         taps;
+    int         *index;
+    uint16_t    *weight;
+} scale_axis;
+
+/* one component within a row, the byte of its first sample and the distance to the next */
+typedef struct {
+    int         offset;
+    int         step;
+    bool        chroma;
+} scale_channel;
+
+static void freeAxis(scale_axis *axis)
+{
+    free(axis->index);
+    free(axis->weight);
+    axis->index = NULL;
+    axis->weight = NULL;
+}
+
+static bool initAxis(scale_axis *axis, int srcSize, int dstSize, yuv_scale_filter filter)
+{
+    if (filter == YUV_SCALE_BOX)
+        axis->taps = (srcSize + dstSize - 1) / dstSize + 1;
+    else
+        axis->taps = 2;
+
+    axis->size = dstSize;
+    axis->index = (int *)malloc(sizeof(int) * axis->taps * dstSize);
+    axis->weight = (uint16_t *)malloc(sizeof(uint16_t) * axis->taps * dstSize);
+    if (axis->index == NULL || axis->weight == NULL) {
+        freeAxis(axis);
+        return false;
+    }
+
+    for (int d = 0; d < dstSize; d++) {
+        int *index = axis->index + d * axis->taps;
+        uint16_t *weight = axis->weight + d * axis->taps;
+        int n = 0;
+
+        if (filter == YUV_SCALE_BOX) {
+            /* the output sample covers [lo, hi) of the source, in 16.16 */
+            int64_t lo = ((int64_t)d * srcSize << 16) / dstSize;
+            int64_t hi = ((int64_t)(d + 1) * srcSize << 16) / dstSize;
+            int sum = 0;
+
+            for (int s = lo >> 16; s < srcSize && ((int64_t)s << 16) < hi && n < axis->taps; s++) {
+                int64_t start = (int64_t)s << 16;
+                int64_t end = start + (1 << 16);
+
+                if (start < lo)
+                    start = lo;
+                if (end > hi)
+                    end = hi;
+                index[n] = s;
+                weight[n] = ((end - start) << WEIGHT_BITS) / (hi - lo);
+                sum += weight[n++];
+            }
+            /* rounding leftovers go to the first tap */
+            weight[0] += (1 << WEIGHT_BITS) - sum;
+        } else {
+            /* sample centres line up, the edges clamp */
+            int64_t pos = (((int64_t)d * 2 + 1) * srcSize << 15) / dstSize - (1 << 15);
+            int frac;
+
+            if (pos < 0)
+                pos = 0;
+            index[0] = pos >> 16;
+            frac = (pos & 0xffff) >> (16 - WEIGHT_BITS);
+            if (index[0] >= srcSize - 1) {
+                index[0] = srcSize - 1;
+                frac = 0;
+            }
+            index[1] = frac ? index[0] + 1 : index[0];
+            weight[0] = (1 << WEIGHT_BITS) - frac;
+            weight[1] = frac;
+            n = 2;
+        }
+
+        for (; n < axis->taps; n++) {
+            index[n] = index[n - 1];
+            weight[n] = 0;
+        }
+    }
+
+    return true;
+}
+
+static void scaleRow(uint16_t *dst, const unsigned char *src,
+                     const scale_channel *channels, int numChannels,
+                     const scale_axis *luma, const scale_axis *chroma)
+{
+    for (int c = 0; c < numChannels; c++) {
+        const scale_channel *ch = &channels[c];
+        const scale_axis *axis = ch->chroma ? chroma : luma;
+        const unsigned char *in = src + ch->offset;
+        uint16_t *out = dst + ch->offset;
+
+        for (int d = 0; d < axis->size; d++) {
+            const int *index = axis->index + d * axis->taps;
+            const uint16_t *weight = axis->weight + d * axis->taps;
+            uint32_t acc = 1 << (WEIGHT_BITS - ROW_BITS - 1);
+
+            for (int k = 0; k < axis->taps; k++)
+                acc += weight[k] * in[index[k] * ch->step];
+            out[d * ch->step] = acc >> (WEIGHT_BITS - ROW_BITS);
+        }
+    }
+}
+
+static void blendRows(unsigned char *dst, const uint16_t *const *rows,
+                      const uint16_t *weight, int taps, int n)
+{
+    int i = 0;
+
+#if defined(__ARM_NEON__)
+    for (; i + 8 <= n; i += 8) {
+        uint32x4_t lo = vdupq_n_u32(1 << (WEIGHT_BITS + ROW_BITS - 1));
+        uint32x4_t hi = lo;
+
+        for (int k = 0; k < taps; k++) {
+            uint16x8_t v = vld1q_u16(rows[k] + i);
+
+            lo = vmlal_n_u16(lo, vget_low_u16(v), weight[k]);
+            hi = vmlal_n_u16(hi, vget_high_u16(v), weight[k]);
+        }
+        lo = vshrq_n_u32(lo, WEIGHT_BITS + ROW_BITS);
+        hi = vshrq_n_u32(hi, WEIGHT_BITS + ROW_BITS);
+        vst1_u8(dst + i, vqmovn_u16(vcombine_u16(vmovn_u32(lo), vmovn_u32(hi))));
+    }
+#elif defined(__SSE2__)
+    for (; i + 8 <= n; i += 8) {
+        __m128i lo = _mm_set1_epi32(1 << (WEIGHT_BITS + ROW_BITS - 1));
+        __m128i hi = lo;
+
+        for (int k = 0; k < taps; k++) {
+            __m128i v = _mm_loadu_si128((const __m128i *)(rows[k] + i));
+            __m128i w = _mm_set1_epi16(weight[k]);
+            __m128i pl = _mm_mullo_epi16(v, w);
+            __m128i ph = _mm_mulhi_epu16(v, w);
+
+            lo = _mm_add_epi32(lo, _mm_unpacklo_epi16(pl, ph));
+            hi = _mm_add_epi32(hi, _mm_unpackhi_epi16(pl, ph));
+        }
+        lo = _mm_srli_epi32(lo, WEIGHT_BITS + ROW_BITS);
+        hi = _mm_srli_epi32(hi, WEIGHT_BITS + ROW_BITS);
+        lo = _mm_packs_epi32(lo, hi);
+        _mm_storel_epi64((__m128i *)(dst + i), _mm_packus_epi16(lo, lo));
+    }
+#endif
+
+    for (; i < n; i++) {
+        uint32_t acc = 1 << (WEIGHT_BITS + ROW_BITS - 1);
+
+        for (int k = 0; k < taps; k++)
+            acc += weight[k] * rows[k][i];
+        acc >>= WEIGHT_BITS + ROW_BITS;
+        dst[i] = acc > 255 ? 255 : acc;
+    }
+}
+
+/* scales one plane, a row of dstRowBytes holds all of its channels */
+static bool scalePlane(const unsigned char *src, int srcRowBytes,
+                       unsigned char *dst, int dstRowBytes,
+                       const scale_channel *channels, int numChannels,
+                       const scale_axis *luma, const scale_axis *chroma,
+                       const scale_axis *vert)
+{
+    /* the source rows of one output row are consecutive, so a ring of taps rows caches them */
+    uint16_t *cache = (uint16_t *)malloc(sizeof(uint16_t) * dstRowBytes * vert->taps);
+    int *cached = (int *)malloc(sizeof(int) * vert->taps);
+    const uint16_t **rows = (const uint16_t **)malloc(sizeof(uint16_t *) * vert->taps);
+    uint16_t *weights = (uint16_t *)malloc(sizeof(uint16_t) * vert->taps);
+    bool ret = cache != NULL && cached != NULL && rows != NULL && weights != NULL;
+
+    for (int k = 0; ret && k < vert->taps; k++)
+        cached[k] = -1;
+
+    for (int r = 0; ret && r < vert->size; r++) {
+        const int *index = vert->index + r * vert->taps;
+        const uint16_t *weight = vert->weight + r * vert->taps;
+        int taps = 0;
+
+        for (int k = 0; k < vert->taps; k++) {
+            int slot = index[k] % vert->taps;
+
+            if (weight[k] == 0)
+                continue;
+            if (cached[slot] != index[k]) {
+                scaleRow(cache + slot * dstRowBytes, src + index[k] * srcRowBytes,
+                         channels, numChannels, luma, chroma);
+                cached[slot] = index[k];
+            }
+            rows[taps] = cache + slot * dstRowBytes;
+            weights[taps++] = weight[k];
+        }
+        blendRows(dst + r * dstRowBytes, rows, weights, taps, dstRowBytes);
+    }
+
+    free(cache);
+    free(cached);
+    free(rows);
+    free(weights);
+
+    return ret;
+}
+
+bool scaleYuv(const unsigned char *srcBuf, uint32_t srcWidth, uint32_t srcHeight,
+              unsigned char *dstBuf, uint32_t dstWidth, uint32_t dstHeight,
+              yuv_scale_format format, yuv_scale_filter filter)
+{
+    static const scale_channel yuyv[] = { { 0, 2, false }, { 1, 4, true }, { 3, 4, true } };
+    static const scale_channel uyvy[] = { { 1, 2, false }, { 0, 4, true }, { 2, 4, true } };
+    static const scale_channel y[] = { { 0, 1, false } };
+    static const scale_channel cbcr[] = { { 0, 2, true }, { 1, 2, true } };
+    scale_axis lumaH, chromaH, lumaV, chromaV;
+    bool packed = format == YUV_SCALE_YUYV || format == YUV_SCALE_UYVY;
+    bool ret;
+
+    if (srcWidth < 2 || srcHeight < 2 || dstWidth < 2 || dstHeight < 2 ||
+            srcWidth % 2 != 0 || srcHeight % 2 != 0 ||
+            dstWidth % 2 != 0 || dstHeight % 2 != 0) {
+        ALOGE("%s: invalid size %dx%d -> %dx%d", __func__,
+              srcWidth, srcHeight, dstWidth, dstHeight);
+        return false;
+    }
+
+    if (srcWidth == dstWidth && srcHeight == dstHeight) {
+        memcpy(dstBuf, srcBuf, packed ? srcWidth * srcHeight * 2 : srcWidth * srcHeight * 3 / 2);
+        return true;
+    }
+
+    memset(&chromaV, 0, sizeof(chromaV));
+    ret = initAxis(&lumaH, srcWidth, dstWidth, filter);
+    if (ret && !initAxis(&chromaH, srcWidth / 2, dstWidth / 2, filter)) {
+        freeAxis(&lumaH);
+        ret = false;
+    }
+    if (ret && !initAxis(&lumaV, srcHeight, dstHeight, filter)) {
+        freeAxis(&lumaH);
+        freeAxis(&chromaH);
+        ret = false;
+    }
+    if (!ret) {
+        ALOGE("%s: no memory for the filters", __func__);
+        return false;
+    }
+
+    if (packed) {
+        ret = scalePlane(srcBuf, srcWidth * 2, dstBuf, dstWidth * 2,
+                         format == YUV_SCALE_YUYV ? yuyv : uyvy, 3,
+                         &lumaH, &chromaH, &lumaV);
+    } else {
+        /* both semi-planar orders scale the same way */
+        ret = scalePlane(srcBuf, srcWidth, dstBuf, dstWidth, y, 1,
+                         &lumaH, &chromaH, &lumaV) &&
+              initAxis(&chromaV, srcHeight / 2, dstHeight / 2, filter) &&
+              scalePlane(srcBuf + srcWidth * srcHeight, srcWidth,
+                         dstBuf + dstWidth * dstHeight, dstWidth, cbcr, 2,
+                         &lumaH, &chromaH, &chromaV);
+    }
+
+    freeAxis(&lumaH);
+    freeAxis(&chromaH);
+    freeAxis(&lumaV);
+    freeAxis(&chromaV);
+
+    if (!ret)
+        ALOGE("%s: scaling failed", __func__);
+
+    return ret;
+}
+
+};
@@ -0,0 +1,48 @@
+/*
+ * Copyright (C) 2010 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *     http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ *
+ * YUV SCALER (YuvScaler.h)
+ * Purpose : Resizes camera frames for postviews and thumbnails, shared by
+ *           the camera HAL and the JPEG encoder
+ */
+#ifndef __YUV_SCALER_H__
+#define __YUV_SCALER_H__
+
+#include <stdint.h>
+
+namespace android {
+
+typedef enum {
+    YUV_SCALE_YUYV,
+    YUV_SCALE_UYVY,
+    YUV_SCALE_NV12,     /* Y plane followed by the CbCr plane */
+    YUV_SCALE_NV21,
+} yuv_scale_format;
+
+typedef enum {
+    YUV_SCALE_BOX,      /* area averaging, what shrinking wants */
+    YUV_SCALE_BILINEAR,
+} yuv_scale_filter;
+
+/*
+ * Scales one frame by any ratio, widths and heights have to be even.
+ * Returns false for bad sizes or when out of memory.
+ */
+bool scaleYuv(const unsigned char *srcBuf, uint32_t srcWidth, uint32_t srcHeight,
+              unsigned char *dstBuf, uint32_t dstWidth, uint32_t dstHeight,
+              yuv_scale_format format, yuv_scale_filter filter = YUV_SCALE_BOX);
+
+};
+#endif /* __YUV_SCALER_H__ */
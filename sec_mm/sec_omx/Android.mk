@@ -9,6 +9,9 @@ SEC_CODECS := $(SEC_OMX_TOP)/sec_codecs/
 SEC_OMX_INC := $(SEC_OMX_TOP)/sec_omx_include/
 SEC_OMX_COMPONENT := $(SEC_OMX_TOP)/sec_omx_component
 
+# <module>:<library_register.h> of each component, for secomxregistry
+SEC_OMX_REGISTRY_LIBS :=
+
 include $(SEC_OMX_TOP)/sec_osal/Android.mk
 include $(SEC_OMX_TOP)/sec_omx_core/Android.mk
 
@@ -20,3 +23,6 @@ include $(SEC_OMX_COMPONENT)/video/dec/mpeg4dec/Android.mk
 include $(SEC_OMX_COMPONENT)/video/enc/Android.mk
 include $(SEC_OMX_COMPONENT)/video/enc/h264enc/Android.mk
 include $(SEC_OMX_COMPONENT)/video/enc/mpeg4enc/Android.mk
+include $(SEC_OMX_TOP)/sec_omx_core/secomxregistry.mk
+include $(SEC_OMX_TOP)/sec_omx_tools/perfstat/Android.mk
+include $(SEC_OMX_TOP)/sec_omx_tools/replay/Android.mk
@@ -11,11 +11,13 @@ LOCAL_SRC_FILES := \
 	csc_nv12t_yuv420_y_neon.s \
 	csc_nv12t_yuv420_uv_neon.s \
 	csc_interleave_memcpy.s \
-	csc_deinterleave_memcpy.s
+	csc_deinterleave_memcpy.s \
+	csc_tiled_downscale.c
 
 else
 LOCAL_SRC_FILES := \
-	color_space_convertor.c
+	color_space_convertor.c \
+	csc_tiled_downscale.c
 
 endif
 
@@ -0,0 +1,167 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    csc_tiled_downscale.c
+ * @brief   NV12T(tiled) to linear conversion with integer decimation.
+ *          Used for thumbnail extraction, where only a fraction of the
+ *          decoded pixels is needed, so only the sampled bytes are read.
+ * @version 1.0
+ */
+
+#include "stdlib.h"
+#include "color_space_convertor.h"
+
+/*
+ * Returns byte offset of (x, y) in a NV12T plane
+ *
+ * @param x
+ *   Horizontal byte position[in]
+ *
+ * @param y
+ *   Vertical line position[in]
+ *
+ * @param width
+ *   Width of plane[in]
+ *
+ * @param height
+ *   Height of plane[in]
+ */
+static unsigned int tiled_offset(unsigned int x, unsigned int y, unsigned int width, unsigned int height)
+{
+    unsigned int tiled_x_index = x>>6;
+    unsigned int tiled_y_index = y>>5;
+    unsigned int x_block_num = (((width+127)>>7)<<7)>>6;
+    unsigned int aligned_height = ((height+31)>>5)<<5;
+    unsigned int offset = 0;
+
+    if (tiled_y_index & 0x1) {
+        /* odd fomula: 2+x_block_num*(y-1) */
+        offset = x_block_num*(tiled_y_index-1)+tiled_x_index+2+((tiled_x_index>>2)<<2);
+    } else if ((y+32) < aligned_height) {
+        /* even fomula: x_block_num*y */
+        offset = x_block_num*tiled_y_index+tiled_x_index+(((tiled_x_index+2)>>2)<<2);
+    } else {
+        /* last even row is not z-ordered */
+        offset = x_block_num*tiled_y_index+tiled_x_index;
+    }
+
+    return (offset<<11)+((y&0x1F)<<6)+(x&0x3F);
+}
+
+/*
+ * Converts tiled data to linear with decimation
+ * 1. Y of NV12T to Y of YUV420P(S)
+ *
+ * @param yuv420_dest
+ *   Y plane address of YUV420, (width/scale)x(height/scale)[out]
+ *
+ * @param nv12t_src
+ *   Y plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_height
+ *   Height of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_to_linear_downscale(char *yuv420_dest, char *nv12t_src, int yuv420_width, int yuv420_height, int scale)
+{
+    unsigned int i, j;
+    unsigned int dest_width = (yuv420_width/scale) & ~1;
+    unsigned int dest_height = (yuv420_height/scale) & ~1;
+
+    for (i=0; i<dest_height; i++) {
+        for (j=0; j<dest_width; j++)
+            yuv420_dest[j] = nv12t_src[tiled_offset(j*scale, i*scale, yuv420_width, yuv420_height)];
+        yuv420_dest += dest_width;
+    }
+}
+
+/*
+ * Converts tiled data to linear with decimation
+ * 1. UV of NV12T to UV of YUV420S
+ *
+ * @param yuv420_uv_dest
+ *   UV plane address of YUV420S[out]
+ *
+ * @param nv12t_uv_src
+ *   UV plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_uv_height
+ *   Height/2 of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_uv_to_linear_downscale(char *yuv420_uv_dest, char *nv12t_uv_src, int yuv420_width, int yuv420_uv_height, int scale)
+{
+    unsigned int i, j, offset;
+    unsigned int dest_width = (yuv420_width/scale) & ~1;
+    unsigned int dest_height = ((yuv420_uv_height*2)/scale) >> 1;
+
+    for (i=0; i<dest_height; i++) {
+        for (j=0; j<dest_width; j+=2) {
+            offset = tiled_offset(j*scale, i*scale, yuv420_width, yuv420_uv_height);
+            yuv420_uv_dest[j] = nv12t_uv_src[offset];
+            yuv420_uv_dest[j+1] = nv12t_uv_src[offset+1];
+        }
+        yuv420_uv_dest += dest_width;
+    }
+}
+
+/*
+ * Converts and Deinterleaves tiled data to linear with decimation
+ * 1. UV of NV12T to UV of YUV420P
+ *
+ * @param yuv420_u_dest
+ *   U plane address of YUV420P[out]
+ *
+ * @param yuv420_v_dest
+ *   V plane address of YUV420P[out]
+ *
+ * @param nv12t_uv_src
+ *   UV plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_uv_height
+ *   Height/2 of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_uv_to_linear_downscale_deinterleave(char *yuv420_u_dest, char *yuv420_v_dest, char *nv12t_uv_src, int yuv420_width, int yuv420_uv_height, int scale)
+{
+    unsigned int i, j, offset;
+    unsigned int dest_width = ((yuv420_width/scale) & ~1) >> 1;
+    unsigned int dest_height = ((yuv420_uv_height*2)/scale) >> 1;
+
+    for (i=0; i<dest_height; i++) {
+        for (j=0; j<dest_width; j++) {
+            offset = tiled_offset(j*2*scale, i*scale, yuv420_width, yuv420_uv_height);
+            yuv420_u_dest[j] = nv12t_uv_src[offset];
+            yuv420_v_dest[j] = nv12t_uv_src[offset+1];
+        }
+        yuv420_u_dest += dest_width;
+        yuv420_v_dest += dest_width;
+    }
+}
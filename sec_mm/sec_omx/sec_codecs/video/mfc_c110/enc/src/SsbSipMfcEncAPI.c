@@ -387,7 +387,10 @@ SSBSIP_MFC_ERROR_CODE SsbSipMfcEncExe(void *openHandle)
     EncArg.args.enc_exe.in_strm_st = (unsigned int)pCTX->phyStrmBuf;
     EncArg.args.enc_exe.in_strm_end = (unsigned int)pCTX->phyStrmBuf + pCTX->sizeStrmBuf;
     EncArg.args.enc_exe.in_frametag = pCTX->in_frametag;
-    if (pCTX->encode_cnt == 0) {
+    if (pCTX->virUserStrmBuf != 0) {
+        EncArg.args.enc_exe.in_strm_st = pCTX->phyUserStrmBuf;
+        EncArg.args.enc_exe.in_strm_end = pCTX->phyUserStrmBuf + pCTX->sizeUserStrmBuf;
+    } else if (pCTX->encode_cnt == 0) {
         EncArg.args.enc_exe.in_strm_st = (unsigned int)pCTX->phyStrmBuf;
         EncArg.args.enc_exe.in_strm_end = (unsigned int)pCTX->phyStrmBuf + pCTX->sizeStrmBuf;
     } else {
@@ -555,16 +558,22 @@ SSBSIP_MFC_ERROR_CODE SsbSipMfcEncGetOutBuf(void *openHandle, SSBSIP_MFC_ENC_OUT
     output_info->headerSize = pCTX->encodedHeaderSize;
     output_info->dataSize = pCTX->encodedDataSize;
 
-    if (pCTX->encode_cnt == 0) {
-        output_info->StrmPhyAddr = (void *)pCTX->phyStrmBuf;
-        output_info->StrmVirAddr = (void *)pCTX->virStrmBuf;
+    if (pCTX->virUserStrmBuf != 0) {
+        /* The frame went to the buffer registered with SsbSipMfcEncSetOutBuf */
+        output_info->StrmPhyAddr = (void *)pCTX->phyUserStrmBuf;
+        output_info->StrmVirAddr = (void *)pCTX->virUserStrmBuf;
     } else {
-        output_info->StrmPhyAddr = (unsigned char *)pCTX->phyStrmBuf + (MAX_ENCODER_OUTPUT_BUFFER_SIZE/2);
-        output_info->StrmVirAddr = (unsigned char *)pCTX->virStrmBuf + (MAX_ENCODER_OUTPUT_BUFFER_SIZE/2);
-    }
+        if (pCTX->encode_cnt == 0) {
+            output_info->StrmPhyAddr = (void *)pCTX->phyStrmBuf;
+            output_info->StrmVirAddr = (void *)pCTX->virStrmBuf;
+        } else {
+            output_info->StrmPhyAddr = (unsigned char *)pCTX->phyStrmBuf + (MAX_ENCODER_OUTPUT_BUFFER_SIZE/2);
+            output_info->StrmVirAddr = (unsigned char *)pCTX->virStrmBuf + (MAX_ENCODER_OUTPUT_BUFFER_SIZE/2);
+        }
 
-    pCTX->encode_cnt ++;
-    pCTX->encode_cnt %= 2;
+        pCTX->encode_cnt ++;
+        pCTX->encode_cnt %= 2;
+    }
 
     if (pCTX->encodedframeType == 0)
         output_info->frameType = MFC_FRAME_TYPE_NOT_CODED;
@@ -598,9 +607,76 @@ SSBSIP_MFC_ERROR_CODE SsbSipMfcEncSetOutBuf(void *openHandle, void *phyOutbuf, v
 
     pCTX = (_MFCLIB *)openHandle;
 
-    pCTX->phyStrmBuf = (int)phyOutbuf;
-    pCTX->virStrmBuf = (int)virOutbuf;
-    pCTX->sizeStrmBuf = outputBufferSize;
+    /*
+     * The next SsbSipMfcEncExe writes its stream to this buffer instead of
+     * the internal one. It has to live in MFC memory (SsbSipMfcEncAllocOutBuf).
+     * Passing NULL goes back to the internal stream buffer.
+     */
+    pCTX->phyUserStrmBuf = (unsigned int)phyOutbuf;
+    pCTX->virUserStrmBuf = (unsigned int)virOutbuf;
+    pCTX->sizeUserStrmBuf = outputBufferSize;
+
+    return MFC_RET_OK;
+}
+
+void *SsbSipMfcEncAllocOutBuf(void *openHandle, void **phyOutbuf, int outputBufferSize)
+{
+    int ret_code;
+    _MFCLIB *pCTX;
+    mfc_common_args user_addr_arg;
+
+    if (openHandle == NULL) {
+        ALOGE("SsbSipMfcEncAllocOutBuf: openHandle is NULL\n");
+        return NULL;
+    }
+
+    if ((outputBufferSize < 0) || (outputBufferSize > MAX_ENCODER_OUTPUT_BUFFER_SIZE)) {
+        ALOGE("SsbSipMfcEncAllocOutBuf: outputBufferSize is too large : %d\n", outputBufferSize);
+        return NULL;
+    }
+
+    pCTX = (_MFCLIB *)openHandle;
+
+    /* SsbSipMfcEncSetSize must have been called, the driver needs the codec type */
+    user_addr_arg.args.mem_alloc.codec_type = pCTX->codec_type;
+    user_addr_arg.args.mem_alloc.buff_size = ALIGN_TO_8KB(outputBufferSize);
+    user_addr_arg.args.mem_alloc.mapped_addr = pCTX->mapped_addr;
+    ret_code = ioctl(pCTX->hMFC, IOCTL_MFC_GET_IN_BUF, &user_addr_arg);
+    if (ret_code < 0) {
+        ALOGE("SsbSipMfcEncAllocOutBuf: IOCTL_MFC_GET_IN_BUF failed\n");
+        return NULL;
+    }
+
+    *phyOutbuf = (void *)user_addr_arg.args.mem_alloc.out_paddr;
+
+    return (void *)user_addr_arg.args.mem_alloc.out_uaddr;
+}
+
+SSBSIP_MFC_ERROR_CODE SsbSipMfcEncFreeOutBuf(void *openHandle, void *virOutbuf)
+{
+    int ret_code;
+    _MFCLIB *pCTX;
+    mfc_common_args free_arg;
+
+    if (openHandle == NULL) {
+        ALOGE("SsbSipMfcEncFreeOutBuf: openHandle is NULL\n");
+        return MFC_RET_INVALID_PARAM;
+    }
+
+    pCTX = (_MFCLIB *)openHandle;
+
+    if (pCTX->virUserStrmBuf == (unsigned int)virOutbuf) {
+        pCTX->phyUserStrmBuf = 0;
+        pCTX->virUserStrmBuf = 0;
+        pCTX->sizeUserStrmBuf = 0;
+    }
+
+    free_arg.args.mem_free.u_addr = (unsigned int)virOutbuf;
+    ret_code = ioctl(pCTX->hMFC, IOCTL_MFC_FREE_BUF, &free_arg);
+    if (ret_code < 0) {
+        ALOGE("SsbSipMfcEncFreeOutBuf: IOCTL_MFC_FREE_BUF failed\n");
+        return MFC_RET_FAIL;
+    }
 
     return MFC_RET_OK;
 }
@@ -132,6 +132,72 @@ void csc_tiled_to_linear(char *yuv420p_y_dest, char *nv12t_y_src, int yuv420p_wi
  */
 void csc_tiled_to_linear_deinterleave(char *yuv420p_u_dest, char *yuv420p_v_dest, char *nv12t_uv_src, int yuv420p_width, int yuv420p_uv_height);
 
+/*
+ * Converts tiled data to linear with decimation
+ * 1. Y of NV12T to Y of YUV420P(S)
+ *
+ * @param yuv420_dest
+ *   Y plane address of YUV420, (width/scale)x(height/scale)[out]
+ *
+ * @param nv12t_src
+ *   Y plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_height
+ *   Height of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_to_linear_downscale(char *yuv420_dest, char *nv12t_src, int yuv420_width, int yuv420_height, int scale);
+
+/*
+ * Converts tiled data to linear with decimation
+ * 1. UV of NV12T to UV of YUV420S
+ *
+ * @param yuv420_uv_dest
+ *   UV plane address of YUV420S[out]
+ *
+ * @param nv12t_uv_src
+ *   UV plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_uv_height
+ *   Height/2 of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_uv_to_linear_downscale(char *yuv420_uv_dest, char *nv12t_uv_src, int yuv420_width, int yuv420_uv_height, int scale);
+
+/*
+ * Converts and Deinterleaves tiled data to linear with decimation
+ * 1. UV of NV12T to UV of YUV420P
+ *
+ * @param yuv420_u_dest
+ *   U plane address of YUV420P[out]
+ *
+ * @param yuv420_v_dest
+ *   V plane address of YUV420P[out]
+ *
+ * @param nv12t_uv_src
+ *   UV plane address of NV12T[in]
+ *
+ * @param yuv420_width
+ *   Width of decoded frame[in]
+ *
+ * @param yuv420_uv_height
+ *   Height/2 of decoded frame[in]
+ *
+ * @param scale
+ *   Decimation factor[in]
+ */
+void csc_tiled_uv_to_linear_downscale_deinterleave(char *yuv420_u_dest, char *yuv420_v_dest, char *nv12t_uv_src, int yuv420_width, int yuv420_uv_height, int scale);
+
 /*
  * Converts linear data to tiled.
  * 1. Y of YUV420P to Y of NV12T
@@ -342,6 +342,9 @@ typedef struct {
     unsigned int encoded_Y_paddr;
     unsigned int encoded_C_paddr;
     unsigned int encode_cnt;
+    unsigned int phyUserStrmBuf;
+    unsigned int virUserStrmBuf;
+    int sizeUserStrmBuf;
 } _MFCLIB;
 
 #endif /* _MFC_INTERFACE_H_ */
@@ -28,9 +28,14 @@
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <cutils/properties.h>
 
 #include "SEC_OSAL_Event.h"
 #include "SEC_OSAL_Thread.h"
+#include "SEC_OSAL_ETC.h"
 #include "SEC_OMX_Baseport.h"
 #include "SEC_OMX_Basecomponent.h"
 #include "SEC_OMX_Macros.h"
@@ -260,6 +265,8 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
             }
             if (pSECComponent->sec_mfc_componentTerminate != NULL)
                 pSECComponent->sec_mfc_componentTerminate(pOMXComponent);
+            SEC_OMX_CallbackStop(pSECComponent);
+            SEC_OMX_RecordClose(pSECComponent);
             break;
         }
         ret = OMX_ErrorInvalidState;
@@ -291,6 +298,8 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
             }
 
             pSECComponent->sec_mfc_componentTerminate(pOMXComponent);
+            SEC_OMX_CallbackStop(pSECComponent);
+            SEC_OMX_RecordClose(pSECComponent);
 
             for (i = 0; i < (pSECComponent->portParam.nPorts); i++) {
                 pSECPort = (pSECComponent->pSECPort + i);
@@ -300,7 +309,7 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
                         if (message != NULL)
                             SEC_OSAL_Free(message);
                     }
-                    ret = pSECComponent->sec_FreeTunnelBuffer(pSECComponent, i);
+                    ret = pSECComponent->sec_FreeTunnelBuffer(pSECPort, i);
                     if (OMX_ErrorNone != ret) {
                         goto EXIT;
                     }
@@ -353,6 +362,7 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
                  */
                 goto EXIT;
             }
+            SEC_OMX_CallbackStart(pOMXComponent);
             pSECComponent->bExitBufferProcessThread = OMX_FALSE;
             SEC_OSAL_SignalCreate(&pSECComponent->pauseEvent);
             for (i = 0; i < ALL_PORT_NUM; i++) {
@@ -378,15 +388,18 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
                     SEC_OSAL_SemaphoreTerminate(pSECComponent->pSECPort[i].bufferSemID);
                     pSECComponent->pSECPort[i].bufferSemID = NULL;
                 }
+                SEC_OMX_CallbackStop(pSECComponent);
 
                 ret = OMX_ErrorInsufficientResources;
                 goto EXIT;
             }
+            SEC_OMX_RecordOpen(pSECComponent);
             pSECComponent->currentState = OMX_StateIdle;
             break;
         case OMX_StateExecuting:
         case OMX_StatePause:
             SEC_OMX_BufferFlushProcessNoEvent(pOMXComponent, ALL_PORT_INDEX);
+            SEC_OMX_PerfPublish(pSECComponent);
             pSECComponent->currentState = OMX_StateIdle;
             break;
         case OMX_StateWaitForResources:
@@ -468,6 +481,7 @@ OMX_ERRORTYPE SEC_OMX_ComponentStateSet(OMX_COMPONENTTYPE *pOMXComponent, OMX_U3
     }
 
 EXIT:
+    SEC_OMX_CallbackDrain(pSECComponent);
     if (ret == OMX_ErrorNone) {
         if (pSECComponent->pCallbacks != NULL) {
             pSECComponent->pCallbacks->EventHandler((OMX_HANDLETYPE)pOMXComponent,
@@ -536,6 +550,9 @@ static OMX_ERRORTYPE SEC_OMX_MessageHandlerThread(OMX_PTR threadData)
             case (OMX_COMMANDTYPE)SEC_OMX_CommandComponentDeInit:
                 pSECComponent->bExitMessageHandlerThread = OMX_TRUE;
                 break;
+            case (OMX_COMMANDTYPE)SEC_OMX_CommandPerfPublish:
+                SEC_OMX_PerfPublish(pSECComponent);
+                break;
             default:
                 break;
             }
@@ -1183,6 +1200,472 @@ EXIT:
     return ret;
 }
 
+/*
+ * Performance counters
+ *
+ * Frame and queue counters are bumped from the client and buffer threads
+ * with atomic adds. Each timer histogram has a single writer (the thread
+ * that runs the timed stage), so it is updated without atomics. Readers
+ * take a snapshot through OMX_IndexVendorPerfStats, which may be a few
+ * samples behind but never blocks the data path.
+ *
+ * When SEC_OMX_PERF_DIR_PROPERTY names a directory, a snapshot is also
+ * written there every SEC_OMX_PERF_PUBLISH_FRAMES output frames and when
+ * the component leaves Executing, for sec_omx_perfstat to read. The file
+ * is written from the message handler thread, the frame path only queues
+ * a SEC_OMX_CommandPerfPublish.
+ */
+#define SEC_OMX_PERF_PUBLISH_FRAMES 300
+
+static OMX_U64 SEC_OMX_PerfNowUs(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((OMX_U64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+void SEC_OMX_PerfBufferQueued(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer)
+{
+    SEC_OMX_CONFIG_PERFSTATSTYPE *pStats = &pSECComponent->perfStats;
+    OMX_U32 depth = (OMX_U32)pSECComponent->pSECPort[nPortIndex].bufferQ.numElem;
+    OMX_U32 depthMax = 0;
+    OMX_TICKS interval = 0;
+
+    do {
+        depthMax = pStats->nQueueDepthMax[nPortIndex];
+        if (depth <= depthMax)
+            break;
+    } while (!__sync_bool_compare_and_swap(&pStats->nQueueDepthMax[nPortIndex], depthMax, depth));
+
+    if ((nPortIndex != INPUT_PORT_INDEX) || (pBuffer->nFilledLen == 0) ||
+        (pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+        return;
+
+    __sync_fetch_and_add(&pStats->nFramesIn, 1);
+
+    /* input arrives in decode order, the smallest forward step is the frame interval */
+    interval = pBuffer->nTimeStamp - pSECComponent->perfLastTimeStamp;
+    if ((interval > 0) && (interval < 1000000) &&
+        ((pSECComponent->perfFrameIntervalUs == 0) || ((OMX_U32)interval < pSECComponent->perfFrameIntervalUs)))
+        pSECComponent->perfFrameIntervalUs = (OMX_U32)interval;
+    pSECComponent->perfLastTimeStamp = pBuffer->nTimeStamp;
+}
+
+void SEC_OMX_PerfFrameDone(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_BOOL bDropped)
+{
+    if (bDropped == OMX_TRUE) {
+        __sync_fetch_and_add(&pSECComponent->perfStats.nFramesDropped, 1);
+    } else {
+        if (((__sync_add_and_fetch(&pSECComponent->perfStats.nFramesOut, 1) % SEC_OMX_PERF_PUBLISH_FRAMES) == 0) &&
+            (pSECComponent->perfFilePath != NULL))
+            SEC_OMX_CommandQueue(pSECComponent, (OMX_COMMANDTYPE)SEC_OMX_CommandPerfPublish, 0, NULL);
+    }
+}
+
+void SEC_OMX_PerfPublish(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    SEC_OMX_PERF_SNAPSHOTTYPE snapshot;
+    char tmpPath[PROPERTY_VALUE_MAX + 64];
+    OMX_U32 i = 0;
+    int fd = -1;
+
+    if (pSECComponent->perfFilePath == NULL)
+        return;
+
+    SEC_OSAL_Memset(&snapshot, 0, sizeof(snapshot));
+    if (pSECComponent->componentName != NULL)
+        SEC_OSAL_Strncpy(snapshot.componentName, pSECComponent->componentName, MAX_OMX_COMPONENT_NAME_SIZE - 1);
+    SEC_OSAL_Memcpy(&snapshot.stats, &pSECComponent->perfStats, sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE));
+    snapshot.stats.nSize = sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE);
+    snapshot.stats.nVersion = pSECComponent->specVersion;
+    for (i = 0; i < ALL_PORT_NUM; i++)
+        snapshot.stats.nQueueDepth[i] = (OMX_U32)pSECComponent->pSECPort[i].bufferQ.numElem;
+
+    /* write aside and rename, so a reader never sees a partial snapshot */
+    snprintf(tmpPath, sizeof(tmpPath), "%s.tmp", pSECComponent->perfFilePath);
+    fd = open(tmpPath, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+        return;
+    if (write(fd, &snapshot, sizeof(snapshot)) == sizeof(snapshot))
+        rename(tmpPath, pSECComponent->perfFilePath);
+    else
+        unlink(tmpPath);
+    close(fd);
+}
+
+OMX_U64 SEC_OMX_PerfTimerStart(void)
+{
+    return SEC_OMX_PerfNowUs();
+}
+
+void SEC_OMX_PerfTimerStop(SEC_OMX_BASECOMPONENT *pSECComponent, SEC_OMX_PERF_TIMERTYPE eTimer, OMX_U64 nStartUs)
+{
+    SEC_OMX_PERF_HISTOGRAMTYPE *pHistogram = &pSECComponent->perfStats.timer[eTimer];
+    OMX_U32 elapsedUs = (OMX_U32)(SEC_OMX_PerfNowUs() - nStartUs);
+    OMX_U32 bin = 0;
+
+    while ((bin < (SEC_OMX_PERF_HISTOGRAM_BINS - 1)) &&
+           (elapsedUs >= ((OMX_U32)SEC_OMX_PERF_HISTOGRAM_BASE << bin)))
+        bin++;
+
+    pHistogram->nBin[bin]++;
+    pHistogram->nTotalUs += elapsedUs;
+    if (elapsedUs > pHistogram->nMaxUs)
+        pHistogram->nMaxUs = elapsedUs;
+    pHistogram->nCount++;
+
+    if ((eTimer == SEC_OMX_PERF_TIMER_CODEC) &&
+        (pSECComponent->perfFrameIntervalUs != 0) &&
+        (elapsedUs > pSECComponent->perfFrameIntervalUs))
+        __sync_fetch_and_add(&pSECComponent->perfStats.nFramesLate, 1);
+}
+
+/*
+ * Buffer traffic recording
+ *
+ * When SEC_OMX_RECORD_DIR_PROPERTY names a directory, every EmptyThisBuffer
+ * and FillThisBuffer call of a Loaded->Idle->Loaded session is appended to
+ * a file there, input payload included. sec_omx_replay feeds it back to
+ * the component. The property is read at each Loaded->Idle transition, so
+ * recording can be switched on without restarting the media server.
+ * Input buffers holding metadata or physical addresses only point at the
+ * frame, so their payload is left out and the port is marked in the header.
+ */
+void SEC_OMX_RecordOpen(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    SEC_OMX_RECORD_HEADERTYPE header;
+    SEC_OMX_BASEPORT *pSECPort = NULL;
+    char recordDir[PROPERTY_VALUE_MAX];
+    char path[PROPERTY_VALUE_MAX + 64];
+    OMX_U32 i = 0;
+    int fd = -1;
+
+    if (property_get(SEC_OMX_RECORD_DIR_PROPERTY, recordDir, NULL) <= 0)
+        return;
+
+    snprintf(path, sizeof(path), "%s/secomx-%d-%p-%u.rec",
+             recordDir, getpid(), pSECComponent, pSECComponent->recordSession++);
+    fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+        SEC_OSAL_Log(SEC_LOG_WARNING, "cannot create %s", path);
+        return;
+    }
+
+    SEC_OSAL_Memset(&header, 0, sizeof(header));
+    header.nMagic = SEC_OMX_RECORD_MAGIC;
+    header.nVersion = SEC_OMX_RECORD_VERSION;
+    if (pSECComponent->componentName != NULL)
+        SEC_OSAL_Strncpy(header.componentName, pSECComponent->componentName, MAX_OMX_COMPONENT_NAME_SIZE - 1);
+    for (i = 0; i < ALL_PORT_NUM; i++) {
+        pSECPort = &pSECComponent->pSECPort[i];
+        header.port[i].nBufferCountActual = pSECPort->portDefinition.nBufferCountActual;
+        header.port[i].nBufferSize        = pSECPort->portDefinition.nBufferSize;
+        header.port[i].nFrameWidth        = pSECPort->portDefinition.format.video.nFrameWidth;
+        header.port[i].nFrameHeight       = pSECPort->portDefinition.format.video.nFrameHeight;
+        header.port[i].nBitrate           = pSECPort->portDefinition.format.video.nBitrate;
+        header.port[i].xFramerate         = pSECPort->portDefinition.format.video.xFramerate;
+        header.port[i].eCompressionFormat = pSECPort->portDefinition.format.video.eCompressionFormat;
+        header.port[i].eColorFormat       = pSECPort->portDefinition.format.video.eColorFormat;
+        header.port[i].ePayload           = SEC_OMX_RECORD_PAYLOAD_DATA;
+        if ((pSECPort->bStoreMetaDataInBuffer == OMX_TRUE) ||
+            (pSECPort->portDefinition.format.video.eColorFormat == OMX_SEC_COLOR_FormatNV12TPhysicalAddress))
+            header.port[i].ePayload = SEC_OMX_RECORD_PAYLOAD_NONE;
+    }
+    if (write(fd, &header, sizeof(header)) != sizeof(header)) {
+        close(fd);
+        unlink(path);
+        return;
+    }
+
+    SEC_OSAL_MutexLock(pSECComponent->recordMutex);
+    pSECComponent->recordStartUs = SEC_OMX_PerfNowUs();
+    pSECComponent->bRecordInputData =
+        (header.port[INPUT_PORT_INDEX].ePayload == SEC_OMX_RECORD_PAYLOAD_DATA) ? OMX_TRUE : OMX_FALSE;
+    pSECComponent->recordFd = fd;
+    SEC_OSAL_MutexUnlock(pSECComponent->recordMutex);
+}
+
+void SEC_OMX_RecordBuffer(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer)
+{
+    SEC_OMX_RECORD_ENTRYTYPE entry;
+    OMX_U32 payloadLen = 0;
+
+    if (pSECComponent->recordFd < 0)
+        return;
+
+    entry.eEvent     = (nPortIndex == INPUT_PORT_INDEX) ? SEC_OMX_RECORD_EMPTY_BUFFER : SEC_OMX_RECORD_FILL_BUFFER;
+    entry.nAllocLen  = pBuffer->nAllocLen;
+    entry.nFlags     = pBuffer->nFlags;
+    entry.nTimeStamp = pBuffer->nTimeStamp;
+    if ((nPortIndex == INPUT_PORT_INDEX) && (pBuffer->pBuffer != NULL) &&
+        (pSECComponent->bRecordInputData == OMX_TRUE))
+        payloadLen = pBuffer->nFilledLen;
+    entry.nFilledLen = payloadLen;
+
+    SEC_OSAL_MutexLock(pSECComponent->recordMutex);
+    if (pSECComponent->recordFd >= 0) {
+        entry.nCallUs = SEC_OMX_PerfNowUs() - pSECComponent->recordStartUs;
+        if ((write(pSECComponent->recordFd, &entry, sizeof(entry)) != sizeof(entry)) ||
+            ((payloadLen > 0) &&
+             (write(pSECComponent->recordFd, pBuffer->pBuffer + pBuffer->nOffset, payloadLen) != (ssize_t)payloadLen))) {
+            /* a torn record would desync the replay, stop here */
+            SEC_OSAL_Log(SEC_LOG_WARNING, "recording stopped, write failed");
+            close(pSECComponent->recordFd);
+            pSECComponent->recordFd = -1;
+        }
+    }
+    SEC_OSAL_MutexUnlock(pSECComponent->recordMutex);
+}
+
+void SEC_OMX_RecordClose(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    if (pSECComponent->recordFd < 0)
+        return;
+
+    SEC_OSAL_MutexLock(pSECComponent->recordMutex);
+    if (pSECComponent->recordFd >= 0) {
+        close(pSECComponent->recordFd);
+        pSECComponent->recordFd = -1;
+    }
+    SEC_OSAL_MutexUnlock(pSECComponent->recordMutex);
+}
+
+/*
+ * Callback dispatcher
+ *
+ * EmptyBufferDone/FillBufferDone run client code that may block, e.g. on
+ * binder locks in stagefright. When SEC_OMX_CALLBACK_THREAD_PROPERTY is "1"
+ * at Loaded->Idle, buffer returns and the events that must stay ordered
+ * with them are put on a bounded lock-free queue and delivered by a
+ * dispatcher thread, so the buffer thread never waits on the client.
+ * Producers claim slots with a compare-and-swap, the dispatcher alone
+ * consumes. It is only woken when it went to sleep, so a run of returns
+ * costs one wakeup and is delivered in one pass.
+ *
+ * Command completions are not queued. They drain the queue first, so the
+ * client still sees every returned buffer before the flush, disable or
+ * state change completes. The ring holds every buffer of both ports plus
+ * an event for each, so it does not fill in practice. If it ever does, the
+ * callback is delivered in place rather than waiting for a slot.
+ *
+ * The time from return to the end of the client callback goes to
+ * SEC_OMX_PERF_TIMER_CALLBACK from the dispatcher only, which keeps it the
+ * single writer. Callbacks delivered in place are not timed.
+ */
+static void SEC_OMX_CallbackDeliver(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_CALLBACK_ENTRY *pEntry, OMX_BOOL bTimed)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+
+    switch (pEntry->eType) {
+    case SEC_OMX_CALLBACK_EMPTY_BUFFER_DONE:
+        pSECComponent->pCallbacks->EmptyBufferDone(pOMXComponent, pSECComponent->callbackData,
+                                                   (OMX_BUFFERHEADERTYPE *)pEntry->pData);
+        if (bTimed == OMX_TRUE)
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CALLBACK, pEntry->nQueuedUs);
+        break;
+    case SEC_OMX_CALLBACK_FILL_BUFFER_DONE:
+        pSECComponent->pCallbacks->FillBufferDone(pOMXComponent, pSECComponent->callbackData,
+                                                  (OMX_BUFFERHEADERTYPE *)pEntry->pData);
+        if (bTimed == OMX_TRUE)
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CALLBACK, pEntry->nQueuedUs);
+        break;
+    case SEC_OMX_CALLBACK_EVENT:
+        pSECComponent->pCallbacks->EventHandler(pOMXComponent, pSECComponent->callbackData,
+                                                pEntry->eEvent, pEntry->nData1, pEntry->nData2, pEntry->pData);
+        break;
+    }
+}
+
+static OMX_BOOL SEC_OMX_CallbackReady(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    SEC_OMX_CALLBACK_ENTRY *pSlot = &pSECComponent->callbackQ[pSECComponent->callbackTail & (SEC_OMX_CALLBACK_QUEUE_SIZE - 1)];
+
+    return (pSlot->nSequence == (pSECComponent->callbackTail + 1)) ? OMX_TRUE : OMX_FALSE;
+}
+
+static OMX_ERRORTYPE SEC_OMX_CallbackThread(OMX_PTR threadData)
+{
+    OMX_COMPONENTTYPE      *pOMXComponent = (OMX_COMPONENTTYPE *)threadData;
+    SEC_OMX_BASECOMPONENT  *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_CALLBACK_ENTRY *pSlot = NULL;
+    SEC_OMX_CALLBACK_ENTRY  entry;
+
+    FunctionIn();
+
+    while (1) {
+        while (SEC_OMX_CallbackReady(pSECComponent) == OMX_TRUE) {
+            pSlot = &pSECComponent->callbackQ[pSECComponent->callbackTail & (SEC_OMX_CALLBACK_QUEUE_SIZE - 1)];
+            __sync_synchronize();
+            SEC_OSAL_Memcpy(&entry, pSlot, sizeof(entry));
+            __sync_synchronize();
+            pSlot->nSequence = pSECComponent->callbackTail + SEC_OMX_CALLBACK_QUEUE_SIZE;
+            pSECComponent->callbackTail++;
+
+            SEC_OMX_CallbackDeliver(pOMXComponent, &entry, OMX_TRUE);
+            __sync_fetch_and_add(&pSECComponent->callbackDelivered, 1);
+        }
+        SEC_OSAL_SignalSet(pSECComponent->callbackDrainEvent);
+
+        if (pSECComponent->bExitCallbackThread == OMX_TRUE)
+            break;
+
+        /* announce the sleep before the last look, a producer either sees it or we see its entry */
+        __sync_lock_test_and_set(&pSECComponent->callbackSleeping, 1);
+        __sync_synchronize();
+        if ((SEC_OMX_CallbackReady(pSECComponent) == OMX_TRUE) &&
+            __sync_bool_compare_and_swap(&pSECComponent->callbackSleeping, 1, 0))
+            continue;
+        SEC_OSAL_SemaphoreWait(pSECComponent->callbackSemaphore);
+    }
+
+    FunctionOut();
+
+    SEC_OSAL_ThreadExit(NULL);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_BOOL SEC_OMX_CallbackQueue(SEC_OMX_BASECOMPONENT *pSECComponent, SEC_OMX_CALLBACK_ENTRY *pEntry)
+{
+    SEC_OMX_CALLBACK_ENTRY *pSlot = NULL;
+    OMX_U32 pos = 0;
+    OMX_S32 diff = 0;
+
+    while (1) {
+        pos = pSECComponent->callbackHead;
+        pSlot = &pSECComponent->callbackQ[pos & (SEC_OMX_CALLBACK_QUEUE_SIZE - 1)];
+        diff = (OMX_S32)(pSlot->nSequence - pos);
+        if (diff == 0) {
+            if (__sync_bool_compare_and_swap(&pSECComponent->callbackHead, pos, pos + 1))
+                break;
+        } else if (diff < 0) {
+            /* more returns in flight than the ring holds, should not happen */
+            SEC_OSAL_Log(SEC_LOG_WARNING, "callback queue full");
+            return OMX_FALSE;
+        }
+    }
+
+    pSlot->eType     = pEntry->eType;
+    pSlot->eEvent    = pEntry->eEvent;
+    pSlot->nData1    = pEntry->nData1;
+    pSlot->nData2    = pEntry->nData2;
+    pSlot->pData     = pEntry->pData;
+    pSlot->nQueuedUs = pEntry->nQueuedUs;
+    __sync_synchronize();
+    pSlot->nSequence = pos + 1;
+
+    if (__sync_bool_compare_and_swap(&pSECComponent->callbackSleeping, 1, 0))
+        SEC_OSAL_SemaphorePost(pSECComponent->callbackSemaphore);
+
+    return OMX_TRUE;
+}
+
+void SEC_OMX_CallbackStart(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    char value[PROPERTY_VALUE_MAX];
+    OMX_U32 i = 0;
+
+    if ((pSECComponent->hCallbackThread != NULL) ||
+        (property_get(SEC_OMX_CALLBACK_THREAD_PROPERTY, value, "0") <= 0) || (value[0] != '1'))
+        return;
+
+    for (i = 0; i < SEC_OMX_CALLBACK_QUEUE_SIZE; i++)
+        pSECComponent->callbackQ[i].nSequence = i;
+    pSECComponent->callbackHead = 0;
+    pSECComponent->callbackTail = 0;
+    pSECComponent->callbackDelivered = 0;
+    pSECComponent->callbackSleeping = 0;
+    pSECComponent->bExitCallbackThread = OMX_FALSE;
+
+    if (SEC_OSAL_SemaphoreCreate(&pSECComponent->callbackSemaphore) != OMX_ErrorNone)
+        goto EXIT;
+    if (SEC_OSAL_SignalCreate(&pSECComponent->callbackDrainEvent) != OMX_ErrorNone)
+        goto EXIT;
+    if (SEC_OSAL_ThreadCreate(&pSECComponent->hCallbackThread, SEC_OMX_CallbackThread, pOMXComponent) != OMX_ErrorNone) {
+        pSECComponent->hCallbackThread = NULL;
+        goto EXIT;
+    }
+    return;
+
+EXIT:
+    /* callbacks are simply delivered in place */
+    SEC_OSAL_Log(SEC_LOG_WARNING, "callback thread not started");
+    if (pSECComponent->callbackDrainEvent != NULL) {
+        SEC_OSAL_SignalTerminate(pSECComponent->callbackDrainEvent);
+        pSECComponent->callbackDrainEvent = NULL;
+    }
+    if (pSECComponent->callbackSemaphore != NULL) {
+        SEC_OSAL_SemaphoreTerminate(pSECComponent->callbackSemaphore);
+        pSECComponent->callbackSemaphore = NULL;
+    }
+}
+
+void SEC_OMX_CallbackDrain(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    if (pSECComponent->hCallbackThread == NULL)
+        return;
+
+    while (1) {
+        SEC_OSAL_SignalReset(pSECComponent->callbackDrainEvent);
+        if (pSECComponent->callbackDelivered == pSECComponent->callbackHead)
+            break;
+        SEC_OSAL_SignalWait(pSECComponent->callbackDrainEvent, DEF_MAX_WAIT_TIME);
+    }
+}
+
+void SEC_OMX_CallbackStop(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    if (pSECComponent->hCallbackThread == NULL)
+        return;
+
+    SEC_OMX_CallbackDrain(pSECComponent);
+    pSECComponent->bExitCallbackThread = OMX_TRUE;
+    SEC_OSAL_SemaphorePost(pSECComponent->callbackSemaphore);
+    SEC_OSAL_ThreadTerminate(pSECComponent->hCallbackThread);
+    pSECComponent->hCallbackThread = NULL;
+
+    SEC_OSAL_SignalTerminate(pSECComponent->callbackDrainEvent);
+    pSECComponent->callbackDrainEvent = NULL;
+    SEC_OSAL_SemaphoreTerminate(pSECComponent->callbackSemaphore);
+    pSECComponent->callbackSemaphore = NULL;
+}
+
+void SEC_OMX_CallbackBufferDone(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_CALLBACK_ENTRY entry;
+
+    entry.eType     = (nPortIndex == INPUT_PORT_INDEX) ? SEC_OMX_CALLBACK_EMPTY_BUFFER_DONE : SEC_OMX_CALLBACK_FILL_BUFFER_DONE;
+    entry.eEvent    = OMX_EventMax;
+    entry.nData1    = 0;
+    entry.nData2    = 0;
+    entry.pData     = pBuffer;
+    entry.nQueuedUs = SEC_OMX_PerfNowUs();
+
+    if ((pSECComponent->hCallbackThread == NULL) ||
+        (SEC_OMX_CallbackQueue(pSECComponent, &entry) == OMX_FALSE))
+        SEC_OMX_CallbackDeliver(pOMXComponent, &entry, OMX_FALSE);
+}
+
+void SEC_OMX_CallbackEvent(OMX_COMPONENTTYPE *pOMXComponent, OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_CALLBACK_ENTRY entry;
+
+    entry.eType     = SEC_OMX_CALLBACK_EVENT;
+    entry.eEvent    = eEvent;
+    entry.nData1    = nData1;
+    entry.nData2    = nData2;
+    entry.pData     = pEventData;
+    entry.nQueuedUs = 0;
+
+    if ((pSECComponent->hCallbackThread == NULL) ||
+        (SEC_OMX_CallbackQueue(pSECComponent, &entry) == OMX_FALSE))
+        SEC_OMX_CallbackDeliver(pOMXComponent, &entry, OMX_FALSE);
+}
+
 OMX_ERRORTYPE SEC_OMX_GetConfig(
     OMX_IN OMX_HANDLETYPE hComponent,
     OMX_IN OMX_INDEXTYPE  nIndex,
@@ -1218,7 +1701,28 @@ OMX_ERRORTYPE SEC_OMX_GetConfig(
         ret = OMX_ErrorInvalidState;
         goto EXIT;
     }
-    ret = OMX_ErrorUnsupportedIndex;
+
+    switch (nIndex) {
+    case OMX_IndexVendorPerfStats:
+    {
+        SEC_OMX_CONFIG_PERFSTATSTYPE *pPerfStats = (SEC_OMX_CONFIG_PERFSTATSTYPE *)pComponentConfigStructure;
+        OMX_U32 i = 0;
+
+        ret = SEC_OMX_Check_SizeVersion(pPerfStats, sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE));
+        if (ret != OMX_ErrorNone)
+            goto EXIT;
+
+        SEC_OSAL_Memcpy((OMX_U8 *)pPerfStats + sizeof(OMX_U32) + sizeof(OMX_VERSIONTYPE),
+                        (OMX_U8 *)&pSECComponent->perfStats + sizeof(OMX_U32) + sizeof(OMX_VERSIONTYPE),
+                        sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE) - sizeof(OMX_U32) - sizeof(OMX_VERSIONTYPE));
+        for (i = 0; i < ALL_PORT_NUM; i++)
+            pPerfStats->nQueueDepth[i] = (OMX_U32)pSECComponent->pSECPort[i].bufferQ.numElem;
+    }
+        break;
+    default:
+        ret = OMX_ErrorUnsupportedIndex;
+        break;
+    }
 
 EXIT:
     FunctionOut();
@@ -1261,7 +1765,20 @@ OMX_ERRORTYPE SEC_OMX_SetConfig(
         ret = OMX_ErrorInvalidState;
         goto EXIT;
     }
-    ret = OMX_ErrorUnsupportedIndex;
+
+    switch (nIndex) {
+    case OMX_IndexVendorPerfStats:
+    {
+        /* any write clears the counters */
+        SEC_OSAL_Memset(&pSECComponent->perfStats, 0, sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE));
+        pSECComponent->perfFrameIntervalUs = 0;
+        ret = OMX_ErrorNone;
+    }
+        break;
+    default:
+        ret = OMX_ErrorUnsupportedIndex;
+        break;
+    }
 
 EXIT:
     FunctionOut();
@@ -1305,6 +1822,12 @@ OMX_ERRORTYPE SEC_OMX_GetExtensionIndex(
         goto EXIT;
     }
 
+    if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_CONFIG_PERF_STATS) == 0) {
+        *pIndexType = OMX_IndexVendorPerfStats;
+        ret = OMX_ErrorNone;
+        goto EXIT;
+    }
+
     ret = OMX_ErrorBadParameter;
 
 EXIT:
@@ -1420,6 +1943,25 @@ OMX_ERRORTYPE SEC_OMX_BaseComponent_Constructor(
         goto EXIT;
     }
 
+    {
+        char perfDir[PROPERTY_VALUE_MAX];
+
+        if (property_get(SEC_OMX_PERF_DIR_PROPERTY, perfDir, NULL) > 0) {
+            pSECComponent->perfFilePath = SEC_OSAL_Malloc(PROPERTY_VALUE_MAX + 48);
+            if (pSECComponent->perfFilePath != NULL)
+                snprintf(pSECComponent->perfFilePath, PROPERTY_VALUE_MAX + 48, "%s/secomx-%d-%p.perf",
+                         perfDir, getpid(), pSECComponent);
+        }
+    }
+
+    pSECComponent->recordFd = -1;
+    ret = SEC_OSAL_MutexCreate(&pSECComponent->recordMutex);
+    if (ret != OMX_ErrorNone) {
+        ret = OMX_ErrorInsufficientResources;
+        SEC_OSAL_Log(SEC_LOG_ERROR, "OMX_ErrorInsufficientResources, Line:%d", __LINE__);
+        goto EXIT;
+    }
+
     pOMXComponent->GetComponentVersion = &SEC_OMX_GetComponentVersion;
     pOMXComponent->SendCommand         = &SEC_OMX_SendCommand;
     pOMXComponent->GetExtensionIndex   = &SEC_OMX_GetExtensionIndex;
@@ -1469,12 +2011,23 @@ OMX_ERRORTYPE SEC_OMX_BaseComponent_Destructor(
     SEC_OSAL_ThreadTerminate(pSECComponent->hMessageHandler);
     pSECComponent->hMessageHandler = NULL;
 
+    SEC_OMX_CallbackStop(pSECComponent);
+
     SEC_OSAL_MutexTerminate(pSECComponent->compMutex);
     pSECComponent->compMutex = NULL;
     SEC_OSAL_SemaphoreTerminate(pSECComponent->msgSemaphoreHandle);
     pSECComponent->msgSemaphoreHandle = NULL;
     SEC_OSAL_QueueTerminate(&pSECComponent->messageQ);
 
+    if (pSECComponent->perfFilePath != NULL) {
+        SEC_OSAL_Free(pSECComponent->perfFilePath);
+        pSECComponent->perfFilePath = NULL;
+    }
+
+    SEC_OMX_RecordClose(pSECComponent);
+    SEC_OSAL_MutexTerminate(pSECComponent->recordMutex);
+    pSECComponent->recordMutex = NULL;
+
     SEC_OSAL_Free(pSECComponent);
     pSECComponent = NULL;
 
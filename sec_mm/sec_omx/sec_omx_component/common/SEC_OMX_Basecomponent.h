@@ -85,6 +85,31 @@ typedef struct _SEC_OMX_TIMESTAPM
     OMX_U32   nStartFlags;
 } SEC_OMX_TIMESTAMP;
 
+/* callback dispatcher, slots for every buffer of both ports plus one event each */
+#define SEC_OMX_CALLBACK_THREAD_PROPERTY "debug.sec.omx.callback.thread"
+#define SEC_OMX_CALLBACK_QUEUE_SIZE      128 /* power of two */
+#if SEC_OMX_CALLBACK_QUEUE_SIZE < (4 * MAX_BUFFER_NUM)
+#error "SEC_OMX_CALLBACK_QUEUE_SIZE can not hold every outstanding buffer"
+#endif
+
+typedef enum _SEC_OMX_CALLBACKTYPE
+{
+    SEC_OMX_CALLBACK_EMPTY_BUFFER_DONE = 0,
+    SEC_OMX_CALLBACK_FILL_BUFFER_DONE,
+    SEC_OMX_CALLBACK_EVENT
+} SEC_OMX_CALLBACKTYPE;
+
+typedef struct _SEC_OMX_CALLBACK_ENTRY
+{
+    volatile OMX_U32     nSequence;
+    SEC_OMX_CALLBACKTYPE eType;
+    OMX_EVENTTYPE        eEvent;
+    OMX_U32              nData1;
+    OMX_U32              nData2;
+    OMX_PTR              pData;     /* buffer header or event data */
+    OMX_U64              nQueuedUs;
+} SEC_OMX_CALLBACK_ENTRY;
+
 typedef struct _SEC_OMX_BASECOMPONENT
 {
     OMX_STRING               componentName;
@@ -144,10 +169,39 @@ typedef struct _SEC_OMX_BASECOMPONENT
     OMX_BOOL bUseFlagEOF;
     OMX_BOOL bSaveFlagEOS;
 
+    /* Performance counters, see SEC_OMX_Perf* */
+    SEC_OMX_CONFIG_PERFSTATSTYPE perfStats;
+    OMX_TICKS                    perfLastTimeStamp;
+    OMX_U32                      perfFrameIntervalUs;
+    OMX_STRING                   perfFilePath;
+
+    /* Buffer traffic recording, see SEC_OMX_Record* */
+    OMX_HANDLETYPE               recordMutex;
+    OMX_S32                      recordFd;
+    OMX_U32                      recordSession;
+    OMX_U64                      recordStartUs;
+    OMX_BOOL                     bRecordInputData;
+
+    /* Callback dispatcher, see SEC_OMX_Callback* */
+    OMX_HANDLETYPE               hCallbackThread;
+    OMX_HANDLETYPE               callbackSemaphore;
+    OMX_HANDLETYPE               callbackDrainEvent;
+    OMX_BOOL                     bExitCallbackThread;
+    volatile OMX_U32             callbackSleeping;
+    volatile OMX_U32             callbackHead;      /* next slot to claim */
+    OMX_U32                      callbackTail;      /* next slot to deliver, dispatcher only */
+    volatile OMX_U32             callbackDelivered;
+    SEC_OMX_CALLBACK_ENTRY       callbackQ[SEC_OMX_CALLBACK_QUEUE_SIZE];
+
     OMX_ERRORTYPE (*sec_mfc_componentInit)(OMX_COMPONENTTYPE *pOMXComponent);
     OMX_ERRORTYPE (*sec_mfc_componentTerminate)(OMX_COMPONENTTYPE *pOMXComponent);
     OMX_ERRORTYPE (*sec_mfc_bufferProcess) (OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA *pInputData, SEC_OMX_DATA *pOutputData);
 
+    /* Optional, lets the codec hand out output buffers MFC can write into */
+    OMX_ERRORTYPE (*sec_mfc_allocateStreamBuffer)(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nSize, OMX_PTR *ppVirAddr, OMX_PTR *ppPhyAddr);
+    OMX_ERRORTYPE (*sec_mfc_freeStreamBuffer)(OMX_COMPONENTTYPE *pOMXComponent, OMX_PTR pVirAddr);
+    OMX_ERRORTYPE (*sec_mfc_releaseStreamBuffer)(OMX_COMPONENTTYPE *pOMXComponent);
+
     OMX_ERRORTYPE (*sec_AllocateTunnelBuffer)(SEC_OMX_BASEPORT *pOMXBasePort, OMX_U32 nPortIndex);
     OMX_ERRORTYPE (*sec_FreeTunnelBuffer)(SEC_OMX_BASEPORT *pOMXBasePort, OMX_U32 nPortIndex);
     OMX_ERRORTYPE (*sec_BufferProcess)(OMX_HANDLETYPE hComponent);
@@ -155,7 +209,8 @@ typedef struct _SEC_OMX_BASECOMPONENT
     OMX_ERRORTYPE (*sec_InputBufferReturn)(OMX_COMPONENTTYPE *pOMXComponent);
     OMX_ERRORTYPE (*sec_OutputBufferReturn)(OMX_COMPONENTTYPE *pOMXComponent);
 
-    int (*sec_checkInputFrame)(unsigned char *pInputStream, int buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame);
+    int (*sec_checkInputFrame)(OMX_COMPONENTTYPE *pOMXComponent, unsigned char *pInputStream, int buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame);
+    OMX_U32 (*sec_checkOutputSlice)(OMX_COMPONENTTYPE *pOMXComponent, OMX_U8 *pOutputStream, OMX_U32 streamSize);
 
 } SEC_OMX_BASECOMPONENT;
 
@@ -166,6 +221,22 @@ extern "C" {
 
     OMX_ERRORTYPE SEC_OMX_Check_SizeVersion(OMX_PTR header, OMX_U32 size);
 
+    void    SEC_OMX_PerfBufferQueued(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer);
+    void    SEC_OMX_PerfFrameDone(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_BOOL bDropped);
+    OMX_U64 SEC_OMX_PerfTimerStart(void);
+    void    SEC_OMX_PerfTimerStop(SEC_OMX_BASECOMPONENT *pSECComponent, SEC_OMX_PERF_TIMERTYPE eTimer, OMX_U64 nStartUs);
+    void    SEC_OMX_PerfPublish(SEC_OMX_BASECOMPONENT *pSECComponent);
+
+    void    SEC_OMX_RecordOpen(SEC_OMX_BASECOMPONENT *pSECComponent);
+    void    SEC_OMX_RecordBuffer(SEC_OMX_BASECOMPONENT *pSECComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer);
+    void    SEC_OMX_RecordClose(SEC_OMX_BASECOMPONENT *pSECComponent);
+
+    void    SEC_OMX_CallbackStart(OMX_COMPONENTTYPE *pOMXComponent);
+    void    SEC_OMX_CallbackStop(SEC_OMX_BASECOMPONENT *pSECComponent);
+    void    SEC_OMX_CallbackDrain(SEC_OMX_BASECOMPONENT *pSECComponent);
+    void    SEC_OMX_CallbackBufferDone(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nPortIndex, OMX_BUFFERHEADERTYPE *pBuffer);
+    void    SEC_OMX_CallbackEvent(OMX_COMPONENTTYPE *pOMXComponent, OMX_EVENTTYPE eEvent, OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData);
+
 
 #ifdef __cplusplus
 };
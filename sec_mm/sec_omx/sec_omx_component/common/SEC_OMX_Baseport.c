@@ -56,7 +56,14 @@ OMX_ERRORTYPE SEC_OMX_FlushPort(OMX_COMPONENTTYPE *pOMXComponent, OMX_S32 portIn
     FunctionIn();
 
     pSECPort = &pSECComponent->pSECPort[portIndex];
-    while (SEC_OSAL_GetElemNum(&pSECPort->bufferQ) > 0) {
+
+    /* The encoder may still own an output buffer MFC is writing into */
+    if ((portIndex == OUTPUT_PORT_INDEX) && (pSECComponent->sec_mfc_releaseStreamBuffer != NULL))
+        pSECComponent->sec_mfc_releaseStreamBuffer(pOMXComponent);
+
+    /* a supplier keeps the buffers it holds and only waits for the rest below */
+    while (!(CHECK_PORT_TUNNELED(pSECPort) && CHECK_PORT_BUFFER_SUPPLIER(pSECPort)) &&
+           (SEC_OSAL_GetElemNum(&pSECPort->bufferQ) > 0)) {
         SEC_OSAL_Get_SemaphoreCount(pSECComponent->pSECPort[portIndex].bufferSemID, &semValue);
         if (semValue == 0)
             SEC_OSAL_SemaphorePost(pSECComponent->pSECPort[portIndex].bufferSemID);
@@ -67,7 +74,7 @@ OMX_ERRORTYPE SEC_OMX_FlushPort(OMX_COMPONENTTYPE *pOMXComponent, OMX_S32 portIn
             bufferHeader = (OMX_BUFFERHEADERTYPE *)message->pCmdData;
             bufferHeader->nFilledLen = 0;
 
-            if (CHECK_PORT_TUNNELED(pSECPort) && !CHECK_PORT_BUFFER_SUPPLIER(pSECPort)) {
+            if (CHECK_PORT_TUNNELED(pSECPort)) {
                 if (portIndex) {
                     OMX_EmptyThisBuffer(pSECPort->tunneledComponent, bufferHeader);
                 } else {
@@ -75,17 +82,8 @@ OMX_ERRORTYPE SEC_OMX_FlushPort(OMX_COMPONENTTYPE *pOMXComponent, OMX_S32 portIn
                 }
                 SEC_OSAL_Free(message);
                 message = NULL;
-            } else if (CHECK_PORT_TUNNELED(pSECPort) && CHECK_PORT_BUFFER_SUPPLIER(pSECPort)) {
-                SEC_OSAL_Log(SEC_LOG_ERROR, "Tunneled mode is not working, Line:%d", __LINE__);
-                ret = OMX_ErrorNotImplemented;
-                SEC_OSAL_Queue(&pSECPort->bufferQ, pSECPort);
-                goto EXIT;
             } else {
-                if (portIndex == OUTPUT_PORT_INDEX) {
-                    pSECComponent->pCallbacks->FillBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
-                } else {
-                    pSECComponent->pCallbacks->EmptyBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
-                }
+                SEC_OMX_CallbackBufferDone(pOMXComponent, portIndex, bufferHeader);
 
                 SEC_OSAL_Free(message);
                 message = NULL;
@@ -115,6 +113,21 @@ OMX_ERRORTYPE SEC_OMX_FlushPort(OMX_COMPONENTTYPE *pOMXComponent, OMX_S32 portIn
         }
         if (SEC_OSAL_GetElemNum(&pSECPort->bufferQ) != pSECPort->assignedBufferNum)
             SEC_OSAL_SetElemNum(&pSECPort->bufferQ, pSECPort->assignedBufferNum);
+        /*
+         * Every buffer is home again. Keep one count per queued buffer unless
+         * the component is heading to Idle, where Idle->Executing posts them.
+         */
+        while (1) {
+            OMX_S32 cnt;
+            SEC_OSAL_Get_SemaphoreCount(pSECComponent->pSECPort[portIndex].bufferSemID, &cnt);
+            if (cnt == 0)
+                break;
+            SEC_OSAL_SemaphoreWait(pSECComponent->pSECPort[portIndex].bufferSemID);
+        }
+        if (pSECComponent->transientState != SEC_OMX_TransStateExecutingToIdle) {
+            for (flushNum = 0; flushNum < pSECPort->assignedBufferNum; flushNum++)
+                SEC_OSAL_SemaphorePost(pSECComponent->pSECPort[portIndex].bufferSemID);
+        }
     } else {
         while(1) {
             int cnt;
@@ -184,6 +197,7 @@ OMX_ERRORTYPE SEC_OMX_BufferFlushProcess(OMX_COMPONENTTYPE *pOMXComponent, OMX_S
 
         if (ret == OMX_ErrorNone) {
             SEC_OSAL_Log(SEC_LOG_TRACE,"OMX_CommandFlush EventCmdComplete");
+            SEC_OMX_CallbackDrain(pSECComponent);
             pSECComponent->pCallbacks->EventHandler((OMX_HANDLETYPE)pOMXComponent,
                             pSECComponent->callbackData,
                             OMX_EventCmdComplete,
@@ -501,6 +515,7 @@ OMX_ERRORTYPE SEC_OMX_PortDisableProcess(OMX_COMPONENTTYPE *pOMXComponent, OMX_S
         ret = SEC_OMX_DisablePort(pOMXComponent, portIndex);
         pSECComponent->pSECPort[portIndex].bIsPortDisabled = OMX_FALSE;
         if (ret == OMX_ErrorNone) {
+            SEC_OMX_CallbackDrain(pSECComponent);
             pSECComponent->pCallbacks->EventHandler(pOMXComponent,
                             pSECComponent->callbackData,
                             OMX_EventCmdComplete,
@@ -609,7 +624,10 @@ OMX_ERRORTYPE SEC_OMX_EmptyThisBuffer(
     message->messageParam = (OMX_U32) i;
     message->pCmdData = (OMX_PTR)pBuffer;
 
+    /* before queueing, the buffer thread may start on it right away */
+    SEC_OMX_RecordBuffer(pSECComponent, INPUT_PORT_INDEX, pBuffer);
     SEC_OSAL_Queue(&pSECPort->bufferQ, (void *)message);
+    SEC_OMX_PerfBufferQueued(pSECComponent, INPUT_PORT_INDEX, pBuffer);
     SEC_OSAL_SemaphorePost(pSECPort->bufferSemID);
 
 EXIT:
@@ -706,7 +724,10 @@ OMX_ERRORTYPE SEC_OMX_FillThisBuffer(
     message->messageParam = (OMX_U32) i;
     message->pCmdData = (OMX_PTR)pBuffer;
 
+    /* before queueing, the buffer thread may start on it right away */
+    SEC_OMX_RecordBuffer(pSECComponent, OUTPUT_PORT_INDEX, pBuffer);
     SEC_OSAL_Queue(&pSECPort->bufferQ, (void *)message);
+    SEC_OMX_PerfBufferQueued(pSECComponent, OUTPUT_PORT_INDEX, pBuffer);
     SEC_OSAL_SemaphorePost(pSECPort->bufferSemID);
 
 EXIT:
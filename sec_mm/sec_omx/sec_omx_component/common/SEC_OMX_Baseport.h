@@ -46,6 +46,13 @@
 #define ALL_PORT_INDEX     -1
 #define ALL_PORT_NUM        2
 
+/* gralloc lock of an Android native buffer, taken once when the buffer is registered */
+typedef struct _SEC_OMX_ANB_MAP
+{
+    OMX_PTR                        pANB;
+    OMX_PTR                        pVirAddrs[2];
+} SEC_OMX_ANB_MAP;
+
 typedef struct _SEC_OMX_BASEPORT
 {
     OMX_BUFFERHEADERTYPE         **bufferHeader;
@@ -75,9 +82,14 @@ typedef struct _SEC_OMX_BASEPORT
 
     /* For Android Native Buffer */
     OMX_BOOL                       bUseAndroidNativeBuffer;
+    SEC_OMX_ANB_MAP                anbMap[MAX_BUFFER_NUM];
     /* For Android Store Meta Data inBuffer */
     OMX_BOOL                       bStoreMetaDataInBuffer;
     OMX_PTR                        pIMGGrallocModule;
+    /* For adaptive playback, buffers are sized for the maximum frame */
+    OMX_BOOL                       bAdaptivePlayback;
+    OMX_U32                        nMaxFrameWidth;
+    OMX_U32                        nMaxFrameHeight;
 } SEC_OMX_BASEPORT;
 
 
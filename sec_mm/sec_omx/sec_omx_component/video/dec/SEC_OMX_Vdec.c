@@ -35,6 +35,9 @@
 #include "SEC_OMX_Basecomponent.h"
 #include "SEC_OSAL_Thread.h"
 #include "color_space_convertor.h"
+#ifdef USE_ANDROID_EXTENSION
+#include "SEC_OSAL_Buffer.h"
+#endif
 
 #undef  SEC_LOG_TAG
 #define SEC_LOG_TAG    "SEC_VIDEO_DEC"
@@ -75,11 +78,95 @@ inline void SEC_UpdateFrameSize(OMX_COMPONENTTYPE *pOMXComponent)
                 secOutputPort->portDefinition.nBufferSize = width * height * 2;
             break;
         }
+        SEC_UpdateAdaptiveBufferSize(pOMXComponent);
     }
 
   return ;
 }
 
+void SEC_UpdateThumbnailFrameSize(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nScale)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_BASEPORT      *secInputPort = &pSECComponent->pSECPort[INPUT_PORT_INDEX];
+    SEC_OMX_BASEPORT      *secOutputPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+    OMX_U32                width = 0, height = 0;
+
+    if (nScale <= 1)
+        return ;
+
+    /* decimated frame is written linear, without tile alignment */
+    width  = (secInputPort->portDefinition.format.video.nFrameWidth / nScale) & (~1);
+    height = (secInputPort->portDefinition.format.video.nFrameHeight / nScale) & (~1);
+
+    secOutputPort->portDefinition.format.video.nFrameWidth = width;
+    secOutputPort->portDefinition.format.video.nFrameHeight = height;
+    secOutputPort->portDefinition.format.video.nStride = width;
+    secOutputPort->portDefinition.format.video.nSliceHeight = height;
+    if (width && height)
+        secOutputPort->portDefinition.nBufferSize = (width * height * 3) / 2;
+
+    return ;
+}
+
+/*
+ * with adaptive playback, output buffers never shrink below the declared maximum frame,
+ * and their stride and slice height stay those of the maximum frame
+ */
+void SEC_UpdateAdaptiveBufferSize(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_BASEPORT      *secOutputPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+    OMX_U32                width = 0, height = 0, size = 0;
+
+    if (secOutputPort->bAdaptivePlayback != OMX_TRUE)
+        return ;
+
+    width  = (secOutputPort->nMaxFrameWidth + 15) & (~15);
+    height = (secOutputPort->nMaxFrameHeight + 15) & (~15);
+    if (secOutputPort->portDefinition.format.video.nStride < width)
+        secOutputPort->portDefinition.format.video.nStride = width;
+    if (secOutputPort->portDefinition.format.video.nSliceHeight < height)
+        secOutputPort->portDefinition.format.video.nSliceHeight = height;
+
+    size = (secOutputPort->portDefinition.format.video.nStride *
+            secOutputPort->portDefinition.format.video.nSliceHeight * 3) / 2;
+    if (secOutputPort->portDefinition.nBufferSize < size)
+        secOutputPort->portDefinition.nBufferSize = size;
+
+    return ;
+}
+
+/*
+ * csc writes rows back to back, this moves them out to the stride of an
+ * adaptive playback buffer. The last row goes first since rows only move up.
+ */
+void SEC_SpreadFrameRows(OMX_U8 *pPlane, OMX_U32 nWidth, OMX_U32 nHeight, OMX_U32 nStride)
+{
+    OMX_S32 i;
+
+    if (nStride <= nWidth)
+        return ;
+
+    for (i = (OMX_S32)nHeight - 1; i > 0; i--)
+        memmove(pPlane + (i * nStride), pPlane + (i * nWidth), nWidth);
+
+    return ;
+}
+
+/* OMX_TRUE when a frame of this size fits the buffers allocated for adaptive playback */
+OMX_BOOL SEC_CheckAdaptiveFrameSize(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nWidth, OMX_U32 nHeight)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_BASEPORT      *secOutputPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+
+    if ((secOutputPort->bAdaptivePlayback == OMX_TRUE) &&
+        (nWidth <= secOutputPort->nMaxFrameWidth) &&
+        (nHeight <= secOutputPort->nMaxFrameHeight))
+        return OMX_TRUE;
+
+    return OMX_FALSE;
+}
+
 OMX_ERRORTYPE SEC_OMX_UseBuffer(
     OMX_IN OMX_HANDLETYPE            hComponent,
     OMX_INOUT OMX_BUFFERHEADERTYPE **ppBufferHdr,
@@ -317,6 +404,10 @@ OMX_ERRORTYPE SEC_OMX_FreeBuffer(
     for (i = 0; i < pSECPort->portDefinition.nBufferCountActual; i++) {
         if (((pSECPort->bufferStateAllocate[i] | BUFFER_STATE_FREE) != 0) && (pSECPort->bufferHeader[i] != NULL)) {
             if (pSECPort->bufferHeader[i]->pBuffer == pBufferHdr->pBuffer) {
+#ifdef USE_ANDROID_EXTENSION
+                /* port disable frees its buffers through here as well */
+                freeAndroidNativeBuffer(hComponent, nPortIndex, pSECPort->bufferHeader[i]->pBuffer);
+#endif
                 if (pSECPort->bufferStateAllocate[i] & BUFFER_STATE_ALLOCATED) {
                     SEC_OSAL_Free(pSECPort->bufferHeader[i]->pBuffer);
                     pSECPort->bufferHeader[i]->pBuffer = NULL;
@@ -361,9 +452,100 @@ OMX_ERRORTYPE SEC_OMX_AllocateTunnelBuffer(SEC_OMX_BASEPORT *pOMXBasePort, OMX_U
     OMX_U8                       *temp_buffer = NULL;
     OMX_U32                       bufferSize = 0;
     OMX_PARAM_PORTDEFINITIONTYPE  portDefinition;
+    SEC_OMX_MESSAGE              *message = NULL;
+    int                           i = 0, retry = 0;
+
+    FunctionIn();
+
+    pSECPort = pOMXBasePort;
+    if ((pSECPort == NULL) || (pSECPort->tunneledComponent == NULL)) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    /* both ends of the tunnel must agree on count and size */
+    INIT_SET_SIZE_VERSION(&portDefinition, OMX_PARAM_PORTDEFINITIONTYPE);
+    portDefinition.nPortIndex = pSECPort->tunneledPort;
+    ret = OMX_GetParameter(pSECPort->tunneledComponent, OMX_IndexParamPortDefinition, &portDefinition);
+    if (ret != OMX_ErrorNone)
+        goto EXIT;
+
+    bufferSize = pSECPort->portDefinition.nBufferSize;
+    if (portDefinition.nBufferSize > bufferSize)
+        bufferSize = portDefinition.nBufferSize;
+
+    if (portDefinition.nBufferCountActual > pSECPort->portDefinition.nBufferCountActual) {
+        if (portDefinition.nBufferCountActual > MAX_BUFFER_NUM) {
+            ret = OMX_ErrorInsufficientResources;
+            goto EXIT;
+        }
+        pSECPort->portDefinition.nBufferCountActual = portDefinition.nBufferCountActual;
+    } else if (portDefinition.nBufferCountActual < pSECPort->portDefinition.nBufferCountActual) {
+        portDefinition.nBufferCountActual = pSECPort->portDefinition.nBufferCountActual;
+        ret = OMX_SetParameter(pSECPort->tunneledComponent, OMX_IndexParamPortDefinition, &portDefinition);
+        if (ret != OMX_ErrorNone)
+            goto EXIT;
+    }
+
+    for (i = 0; i < pSECPort->portDefinition.nBufferCountActual; i++) {
+        temp_buffer = (OMX_U8 *)SEC_OSAL_Malloc(bufferSize);
+        if (temp_buffer == NULL) {
+            ret = OMX_ErrorInsufficientResources;
+            goto EXIT;
+        }
+
+        for (retry = 0; retry < TUNNEL_BUFFER_RETRY_NUM; retry++) {
+            ret = OMX_UseBuffer(pSECPort->tunneledComponent, &temp_bufferHeader,
+                                pSECPort->tunneledPort, NULL, bufferSize, temp_buffer);
+            if ((ret != OMX_ErrorIncorrectStateTransition) && (ret != OMX_ErrorIncorrectStateOperation))
+                break;
+            SEC_OSAL_SleepMillisec(TUNNEL_BUFFER_RETRY_MS);
+        }
+        if (ret != OMX_ErrorNone) {
+            SEC_OSAL_Log(SEC_LOG_ERROR, "tunnel UseBuffer failed (0x%x), port:%d", ret, nPortIndex);
+            SEC_OSAL_Free(temp_buffer);
+            goto EXIT;
+        }
+
+        if (nPortIndex == INPUT_PORT_INDEX)
+            temp_bufferHeader->nInputPortIndex = nPortIndex;
+        else
+            temp_bufferHeader->nOutputPortIndex = nPortIndex;
+
+        message = SEC_OSAL_Malloc(sizeof(SEC_OMX_MESSAGE));
+        if (message == NULL) {
+            OMX_FreeBuffer(pSECPort->tunneledComponent, pSECPort->tunneledPort, temp_bufferHeader);
+            SEC_OSAL_Free(temp_buffer);
+            ret = OMX_ErrorInsufficientResources;
+            goto EXIT;
+        }
+
+        pSECPort->bufferHeader[i] = temp_bufferHeader;
+        pSECPort->bufferStateAllocate[i] = BUFFER_STATE_ALLOCATED;
+        pSECPort->assignedBufferNum++;
+        pSECPort->tunnelBufferNum++;
+
+        /* the supplier starts out owning every buffer */
+        message->messageType  = (nPortIndex == INPUT_PORT_INDEX) ? SEC_OMX_CommandEmptyBuffer : SEC_OMX_CommandFillBuffer;
+        message->messageParam = (OMX_U32)i;
+        message->pCmdData     = (OMX_PTR)temp_bufferHeader;
+        SEC_OSAL_Queue(&pSECPort->bufferQ, (void *)message);
+    }
+
+    pSECPort->portDefinition.bPopulated = OMX_TRUE;
+    ret = OMX_ErrorNone;
 
-    ret = OMX_ErrorTunnelingUnsupported;
 EXIT:
+    if ((ret != OMX_ErrorNone) && (pSECPort != NULL) && (pSECPort->tunnelBufferNum > 0)) {
+        while (SEC_OSAL_GetElemNum(&pSECPort->bufferQ) > 0) {
+            message = (SEC_OMX_MESSAGE *)SEC_OSAL_Dequeue(&pSECPort->bufferQ);
+            SEC_OSAL_Free(message);
+        }
+        SEC_OMX_FreeTunnelBuffer(pOMXBasePort, nPortIndex);
+    }
+
+    FunctionOut();
+
     return ret;
 }
 
@@ -373,10 +555,46 @@ OMX_ERRORTYPE SEC_OMX_FreeTunnelBuffer(SEC_OMX_BASEPORT *pOMXBasePort, OMX_U32 n
     SEC_OMX_BASEPORT* pSECPort = NULL;
     OMX_BUFFERHEADERTYPE* temp_bufferHeader = NULL;
     OMX_U8 *temp_buffer = NULL;
-    OMX_U32 bufferSize = 0;
+    OMX_ERRORTYPE freeRet = OMX_ErrorNone;
+    int i = 0, retry = 0;
+
+    FunctionIn();
+
+    pSECPort = pOMXBasePort;
+    if (pSECPort == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    for (i = 0; i < MAX_BUFFER_NUM; i++) {
+        if ((pSECPort->bufferStateAllocate[i] != BUFFER_STATE_ALLOCATED) || (pSECPort->bufferHeader[i] == NULL))
+            continue;
+
+        temp_bufferHeader = pSECPort->bufferHeader[i];
+        temp_buffer = temp_bufferHeader->pBuffer;
+
+        for (retry = 0; retry < TUNNEL_BUFFER_RETRY_NUM; retry++) {
+            freeRet = OMX_FreeBuffer(pSECPort->tunneledComponent, pSECPort->tunneledPort, temp_bufferHeader);
+            if ((freeRet != OMX_ErrorIncorrectStateTransition) && (freeRet != OMX_ErrorIncorrectStateOperation))
+                break;
+            SEC_OSAL_SleepMillisec(TUNNEL_BUFFER_RETRY_MS);
+        }
+        if (freeRet != OMX_ErrorNone) {
+            SEC_OSAL_Log(SEC_LOG_ERROR, "tunnel FreeBuffer failed (0x%x), port:%d", freeRet, nPortIndex);
+            ret = freeRet;
+        }
+
+        SEC_OSAL_Free(temp_buffer);
+        pSECPort->bufferHeader[i] = NULL;
+        pSECPort->bufferStateAllocate[i] = BUFFER_STATE_FREE;
+        pSECPort->assignedBufferNum--;
+    }
+    pSECPort->tunnelBufferNum = 0;
+    pSECPort->portDefinition.bPopulated = OMX_FALSE;
 
-    ret = OMX_ErrorTunnelingUnsupported;
 EXIT:
+    FunctionOut();
+
     return ret;
 }
 
@@ -387,10 +605,118 @@ OMX_ERRORTYPE SEC_OMX_ComponentTunnelRequest(
     OMX_IN OMX_U32        nTunneledPort,
     OMX_INOUT OMX_TUNNELSETUPTYPE *pTunnelSetup)
 {
-    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    OMX_ERRORTYPE                 ret = OMX_ErrorNone;
+    OMX_COMPONENTTYPE            *pOMXComponent = NULL;
+    SEC_OMX_BASECOMPONENT        *pSECComponent = NULL;
+    SEC_OMX_BASEPORT             *pSECPort = NULL;
+    OMX_PARAM_PORTDEFINITIONTYPE  portDefinition;
+    OMX_PARAM_BUFFERSUPPLIERTYPE  bufferSupplier;
+
+    FunctionIn();
+
+    if (hComp == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+    pOMXComponent = (OMX_COMPONENTTYPE *)hComp;
+    ret = SEC_OMX_Check_SizeVersion(pOMXComponent, sizeof(OMX_COMPONENTTYPE));
+    if (ret != OMX_ErrorNone) {
+        goto EXIT;
+    }
+    if (pOMXComponent->pComponentPrivate == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+    pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+
+    if (nPort >= pSECComponent->portParam.nPorts) {
+        ret = OMX_ErrorBadPortIndex;
+        goto EXIT;
+    }
+    pSECPort = &pSECComponent->pSECPort[nPort];
+
+    if ((pSECComponent->currentState != OMX_StateLoaded) && CHECK_PORT_ENABLED(pSECPort)) {
+        ret = OMX_ErrorIncorrectStateOperation;
+        goto EXIT;
+    }
+
+    if (hTunneledComp == NULL) {
+        /* tear down */
+        pSECPort->tunneledComponent = NULL;
+        pSECPort->tunneledPort = 0;
+        pSECPort->tunnelFlags = 0;
+        pSECPort->bufferSupplier = OMX_BufferSupplyUnspecified;
+        ret = OMX_ErrorNone;
+        goto EXIT;
+    }
+
+    if (pTunnelSetup == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    if (pSECPort->portDefinition.eDir == OMX_DirOutput) {
+        /*
+         * The input side drives the negotiation. The supplier role is set later
+         * through OMX_IndexParamCompBufferSupplier if the peer hands it over.
+         */
+        pTunnelSetup->nTunnelFlags = 0;
+        pTunnelSetup->eSupplier = pSECPort->bufferSupplier;
+
+        pSECPort->tunneledComponent = hTunneledComp;
+        pSECPort->tunneledPort = nTunneledPort;
+        pSECPort->tunnelFlags = SEC_TUNNEL_ESTABLISHED;
+        if (pSECPort->bufferSupplier == OMX_BufferSupplyOutput)
+            pSECPort->tunnelFlags |= SEC_TUNNEL_IS_SUPPLIER;
+        ret = OMX_ErrorNone;
+        goto EXIT;
+    }
+
+    /* input port: check the peer can feed us and settle who supplies the buffers */
+    INIT_SET_SIZE_VERSION(&portDefinition, OMX_PARAM_PORTDEFINITIONTYPE);
+    portDefinition.nPortIndex = nTunneledPort;
+    ret = OMX_GetParameter(hTunneledComp, OMX_IndexParamPortDefinition, &portDefinition);
+    if (ret != OMX_ErrorNone) {
+        ret = OMX_ErrorPortsNotCompatible;
+        goto EXIT;
+    }
+    if ((portDefinition.eDir != OMX_DirOutput) ||
+        (portDefinition.eDomain != pSECPort->portDefinition.eDomain) ||
+        (portDefinition.format.video.eCompressionFormat != pSECPort->portDefinition.format.video.eCompressionFormat)) {
+        ret = OMX_ErrorPortsNotCompatible;
+        goto EXIT;
+    }
+
+    INIT_SET_SIZE_VERSION(&bufferSupplier, OMX_PARAM_BUFFERSUPPLIERTYPE);
+    bufferSupplier.nPortIndex = nTunneledPort;
+    if ((pTunnelSetup->nTunnelFlags & OMX_PORTTUNNELFLAG_READONLY) ||
+        (pTunnelSetup->eSupplier == OMX_BufferSupplyOutput)) {
+        bufferSupplier.eBufferSupplier = OMX_BufferSupplyOutput;
+    } else if (pTunnelSetup->eSupplier == OMX_BufferSupplyInput) {
+        bufferSupplier.eBufferSupplier = OMX_BufferSupplyInput;
+    } else if (pSECPort->bufferSupplier == OMX_BufferSupplyOutput) {
+        bufferSupplier.eBufferSupplier = OMX_BufferSupplyOutput;
+    } else {
+        bufferSupplier.eBufferSupplier = OMX_BufferSupplyInput;
+    }
+
+    ret = OMX_SetParameter(hTunneledComp, OMX_IndexParamCompBufferSupplier, &bufferSupplier);
+    if (ret != OMX_ErrorNone) {
+        ret = OMX_ErrorPortsNotCompatible;
+        goto EXIT;
+    }
+
+    pTunnelSetup->eSupplier = bufferSupplier.eBufferSupplier;
+    pSECPort->tunneledComponent = hTunneledComp;
+    pSECPort->tunneledPort = nTunneledPort;
+    pSECPort->tunnelFlags = SEC_TUNNEL_ESTABLISHED;
+    if (bufferSupplier.eBufferSupplier == OMX_BufferSupplyInput)
+        pSECPort->tunnelFlags |= SEC_TUNNEL_IS_SUPPLIER;
+    ret = OMX_ErrorNone;
 
-    ret = OMX_ErrorTunnelingUnsupported;
 EXIT:
+    FunctionOut();
+
     return ret;
 }
 
@@ -428,10 +754,7 @@ static OMX_ERRORTYPE SEC_InputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
 
         if (bufferHeader->hMarkTargetComponent != NULL) {
             if (bufferHeader->hMarkTargetComponent == pOMXComponent) {
-                pSECComponent->pCallbacks->EventHandler(pOMXComponent,
-                                pSECComponent->callbackData,
-                                OMX_EventMark,
-                                0, 0, bufferHeader->pMarkData);
+                SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventMark, 0, 0, bufferHeader->pMarkData);
             } else {
                 pSECComponent->propagateMarkType.hMarkTargetComponent = bufferHeader->hMarkTargetComponent;
                 pSECComponent->propagateMarkType.pMarkData = bufferHeader->pMarkData;
@@ -442,7 +765,7 @@ static OMX_ERRORTYPE SEC_InputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
             OMX_FillThisBuffer(secOMXInputPort->tunneledComponent, bufferHeader);
         } else {
             bufferHeader->nFilledLen = 0;
-            pSECComponent->pCallbacks->EmptyBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
+            SEC_OMX_CallbackBufferDone(pOMXComponent, INPUT_PORT_INDEX, bufferHeader);
         }
     }
 
@@ -533,6 +856,10 @@ static OMX_ERRORTYPE SEC_OutputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
         bufferHeader->nFlags     = dataBuffer->nFlags;
         bufferHeader->nTimeStamp = dataBuffer->timeStamp;
 
+        if ((bufferHeader->nFilledLen > 0) &&
+            !(bufferHeader->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+            SEC_OMX_PerfFrameDone(pSECComponent, OMX_FALSE);
+
         if (pSECComponent->propagateMarkType.hMarkTargetComponent != NULL) {
             bufferHeader->hMarkTargetComponent = pSECComponent->propagateMarkType.hMarkTargetComponent;
             bufferHeader->pMarkData = pSECComponent->propagateMarkType.pMarkData;
@@ -541,17 +868,14 @@ static OMX_ERRORTYPE SEC_OutputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
         }
 
         if (bufferHeader->nFlags & OMX_BUFFERFLAG_EOS) {
-            pSECComponent->pCallbacks->EventHandler(pOMXComponent,
-                            pSECComponent->callbackData,
-                            OMX_EventBufferFlag,
-                            OUTPUT_PORT_INDEX,
-                            bufferHeader->nFlags, NULL);
+            SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventBufferFlag,
+                                  OUTPUT_PORT_INDEX, bufferHeader->nFlags, NULL);
         }
 
         if (CHECK_PORT_TUNNELED(secOMXOutputPort)) {
             OMX_EmptyThisBuffer(secOMXOutputPort->tunneledComponent, bufferHeader);
         } else {
-            pSECComponent->pCallbacks->FillBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
+            SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, bufferHeader);
         }
     }
 
@@ -693,7 +1017,7 @@ OMX_BOOL SEC_Preprocessor_InputData(OMX_COMPONENTTYPE *pOMXComponent)
             checkedSize = checkInputStreamLen;
         } else {
             pSECComponent->bUseFlagEOF = OMX_FALSE;
-            checkedSize = pSECComponent->sec_checkInputFrame(checkInputStream, checkInputStreamLen, inputUseBuffer->nFlags, previousFrameEOF, &flagEOF);
+            checkedSize = pSECComponent->sec_checkInputFrame(pOMXComponent, checkInputStream, checkInputStreamLen, inputUseBuffer->nFlags, previousFrameEOF, &flagEOF);
         }
 
         if (flagEOF == OMX_TRUE) {
@@ -1097,6 +1421,24 @@ OMX_ERRORTYPE SEC_OMX_VideoDecodeGetParameter(
         ret = getAndroidNativeBuffer(hComponent, ComponentParameterStructure);
     }
         break;
+    case OMX_IndexParamPrepareForAdaptivePlayback:
+    {
+        SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE *pAdaptive = (SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE *)ComponentParameterStructure;
+        SEC_OMX_BASEPORT *pSECPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+
+        ret = SEC_OMX_Check_SizeVersion(pAdaptive, sizeof(SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE));
+        if (ret != OMX_ErrorNone)
+            goto EXIT;
+
+        if (pAdaptive->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pAdaptive->bEnable         = pSECPort->bAdaptivePlayback;
+        pAdaptive->nMaxFrameWidth  = pSECPort->nMaxFrameWidth;
+        pAdaptive->nMaxFrameHeight = pSECPort->nMaxFrameHeight;
+    }
+        break;
 #endif
     default:
     {
@@ -1234,6 +1576,41 @@ OMX_ERRORTYPE SEC_OMX_VideoDecodeSetParameter(
         ret = useAndroidNativeBuffer(hComponent, ComponentParameterStructure);
     }
         break;
+    case OMX_IndexParamPrepareForAdaptivePlayback:
+    {
+        SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE *pAdaptive = (SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE *)ComponentParameterStructure;
+
+        ret = SEC_OMX_Check_SizeVersion(pAdaptive, sizeof(SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE));
+        if (ret != OMX_ErrorNone)
+            goto EXIT;
+
+        if (pAdaptive->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pSECPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+
+        /* decides the buffer size, so only before the buffers exist */
+        if ((pSECComponent->currentState != OMX_StateLoaded) &&
+            (pSECPort->portDefinition.bEnabled == OMX_TRUE)) {
+            ret = OMX_ErrorIncorrectStateOperation;
+            goto EXIT;
+        }
+
+        if (pAdaptive->bEnable == OMX_TRUE) {
+            if ((pAdaptive->nMaxFrameWidth == 0) || (pAdaptive->nMaxFrameHeight == 0) ||
+                (pAdaptive->nMaxFrameWidth > ADAPTIVE_FRAME_WIDTH_MAX) ||
+                (pAdaptive->nMaxFrameHeight > ADAPTIVE_FRAME_HEIGHT_MAX)) {
+                ret = OMX_ErrorBadParameter;
+                goto EXIT;
+            }
+            pSECPort->nMaxFrameWidth  = pAdaptive->nMaxFrameWidth;
+            pSECPort->nMaxFrameHeight = pAdaptive->nMaxFrameHeight;
+        }
+        pSECPort->bAdaptivePlayback = pAdaptive->bEnable;
+        SEC_UpdateAdaptiveBufferSize(pOMXComponent);
+    }
+        break;
 #endif
     default:
     {
@@ -46,6 +46,15 @@
 #define MFC_INPUT_BUFFER_NUM_MAX         2
 #define DEFAULT_MFC_INPUT_BUFFER_SIZE    ((1280 * 720 * 3) / 2)
 
+#define THUMBNAIL_SCALE_MAX          8
+
+#define ADAPTIVE_FRAME_WIDTH_MAX     1920
+#define ADAPTIVE_FRAME_HEIGHT_MAX    1088
+
+/* the peer of a tunnel may not have entered its own transition yet */
+#define TUNNEL_BUFFER_RETRY_NUM      100
+#define TUNNEL_BUFFER_RETRY_MS       10
+
 #define INPUT_PORT_SUPPORTFORMAT_NUM_MAX    1
 #define OUTPUT_PORT_SUPPORTFORMAT_NUM_MAX   3
 
@@ -82,6 +91,10 @@ typedef struct _MFC_DEC_INPUT_BUFFER
 extern "C" {
 #endif
 
+void SEC_UpdateThumbnailFrameSize(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nScale);
+void SEC_UpdateAdaptiveBufferSize(OMX_COMPONENTTYPE *pOMXComponent);
+OMX_BOOL SEC_CheckAdaptiveFrameSize(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nWidth, OMX_U32 nHeight);
+void SEC_SpreadFrameRows(OMX_U8 *pPlane, OMX_U32 nWidth, OMX_U32 nHeight, OMX_U32 nStride);
 OMX_ERRORTYPE SEC_OMX_UseBuffer(
     OMX_IN OMX_HANDLETYPE            hComponent,
     OMX_INOUT OMX_BUFFERHEADERTYPE **ppBufferHdr,
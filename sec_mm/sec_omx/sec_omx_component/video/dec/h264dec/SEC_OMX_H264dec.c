@@ -36,6 +36,9 @@
 #include "SEC_OMX_H264dec.h"
 #include "SsbSipMfcApi.h"
 #include "color_space_convertor.h"
+#ifdef USE_ANDROID_EXTENSION
+#include "SEC_OSAL_Buffer.h"
+#endif
 
 #undef  SEC_LOG_TAG
 #define SEC_LOG_TAG    "SEC_H264_DEC"
@@ -81,7 +84,7 @@ SEC_OMX_VIDEO_PROFILELEVEL supportedAVCProfileLevels[] ={
     {OMX_VIDEO_AVCProfileHigh, OMX_VIDEO_AVCLevel31}};
 
 
-static int Check_H264_Frame(OMX_U8 *pInputStream, int buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
+static int Check_H264_Frame(OMX_COMPONENTTYPE *pOMXComponent, OMX_U8 *pInputStream, int buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
 {
     OMX_U32  preFourByte       = (OMX_U32)-1;
     int      accessUnitSize    = 0;
@@ -175,6 +178,283 @@ OMX_BOOL Check_H264_StartCode(OMX_U8 *pInputStream, OMX_U32 streamSize)
     }
 }
 
+static OMX_U32 H264_ReadBits(OMX_U8 *pStream, OMX_U32 streamSize, OMX_U32 *pBitPos, int nBits)
+{
+    OMX_U32 value = 0;
+
+    while (nBits-- > 0) {
+        value <<= 1;
+        if ((*pBitPos >> 3) < streamSize)
+            value |= (pStream[*pBitPos >> 3] >> (7 - (*pBitPos & 0x7))) & 0x1;
+        (*pBitPos)++;
+    }
+
+    return value;
+}
+
+/*
+ * Returns H264_UE_INVALID and moves *pBitPos past the end of the stream when
+ * the code has more than 31 leading zeros, which only truncated or corrupt
+ * data produces.
+ */
+static OMX_U32 H264_ReadUE(OMX_U8 *pStream, OMX_U32 streamSize, OMX_U32 *pBitPos)
+{
+    int leadingZeroBits = 0;
+
+    while (H264_ReadBits(pStream, streamSize, pBitPos, 1) == 0) {
+        if (++leadingZeroBits > 31) {
+            *pBitPos = (streamSize << 3) + 1;
+            return H264_UE_INVALID;
+        }
+    }
+
+    return (((OMX_U32)1 << leadingZeroBits) - 1) + H264_ReadBits(pStream, streamSize, pBitPos, leadingZeroBits);
+}
+
+static OMX_S32 H264_ReadSE(OMX_U8 *pStream, OMX_U32 streamSize, OMX_U32 *pBitPos)
+{
+    OMX_U32 codeNum = H264_ReadUE(pStream, streamSize, pBitPos);
+
+    return (codeNum & 0x1) ? (OMX_S32)((codeNum + 1) >> 1) : -(OMX_S32)(codeNum >> 1);
+}
+
+static void H264_SkipHRD(OMX_U8 *pStream, OMX_U32 streamSize, OMX_U32 *pBitPos)
+{
+    OMX_U32 cpbCnt = H264_ReadUE(pStream, streamSize, pBitPos) + 1;
+    OMX_U32 i = 0;
+
+    H264_ReadBits(pStream, streamSize, pBitPos, 8);     /* bit_rate_scale, cpb_size_scale */
+    for (i = 0; (i < cpbCnt) && (i < 32); i++) {
+        H264_ReadUE(pStream, streamSize, pBitPos);      /* bit_rate_value_minus1 */
+        H264_ReadUE(pStream, streamSize, pBitPos);      /* cpb_size_value_minus1 */
+        H264_ReadBits(pStream, streamSize, pBitPos, 1); /* cbr_flag */
+    }
+    H264_ReadBits(pStream, streamSize, pBitPos, 20);    /* delay and length fields */
+}
+
+/*
+ * Copies the first SPS of the stream into pRbsp without emulation prevention
+ * bytes and returns its size, at most H264_SPS_PARSE_SIZE_MAX.
+ */
+static OMX_U32 H264_GetSPS(OMX_U8 *pInputStream, OMX_U32 streamSize, OMX_U8 *pRbsp)
+{
+    OMX_U32 rbspSize = 0;
+    OMX_U32 preThreeByte = (OMX_U32)-1;
+    OMX_U32 zeroCount = 0;
+    OMX_U32 i;
+
+    for (i = 0; i < streamSize; i++) {
+        if (((preThreeByte & 0x00FFFFFF) == 0x00000001) && ((pInputStream[i] & 0x1F) == 7))
+            break;
+        preThreeByte = (preThreeByte << 8) | pInputStream[i];
+    }
+    for (i = i + 1; (i < streamSize) && (rbspSize < H264_SPS_PARSE_SIZE_MAX); i++) {
+        if ((zeroCount == 2) && (pInputStream[i] == 0x03)) {
+            zeroCount = 0;
+            continue;
+        }
+        if ((zeroCount == 2) && (pInputStream[i] <= 0x01))
+            break;
+        zeroCount = (pInputStream[i] == 0x00) ? (zeroCount + 1) : 0;
+        if (zeroCount > 2)
+            zeroCount = 2;
+        pRbsp[rbspSize++] = pInputStream[i];
+    }
+
+    return rbspSize;
+}
+
+/*
+ * Returns the number of frames the SPS allows to be held back for reordering,
+ * or -1 if the stream does not say.
+ */
+static OMX_S32 H264_GetReorderDepth(OMX_U8 *pInputStream, OMX_U32 streamSize)
+{
+    OMX_U8  rbsp[H264_SPS_PARSE_SIZE_MAX];
+    OMX_U32 rbspSize = 0;
+    OMX_U32 bitPos = 0;
+    OMX_U32 profileIdc, pocType, i;
+
+    rbspSize = H264_GetSPS(pInputStream, streamSize, rbsp);
+    if (rbspSize < 4)
+        return -1;
+
+    profileIdc = H264_ReadBits(rbsp, rbspSize, &bitPos, 8);
+    H264_ReadBits(rbsp, rbspSize, &bitPos, 16);         /* constraint flags, level_idc */
+    H264_ReadUE(rbsp, rbspSize, &bitPos);               /* seq_parameter_set_id */
+    if ((profileIdc == 100) || (profileIdc == 110) || (profileIdc == 122) ||
+        (profileIdc == 244) || (profileIdc == 44)  || (profileIdc == 83)  ||
+        (profileIdc == 86)  || (profileIdc == 118) || (profileIdc == 128)) {
+        OMX_U32 chromaFormatIdc = H264_ReadUE(rbsp, rbspSize, &bitPos);
+
+        if (chromaFormatIdc == 3)
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 1);  /* separate_colour_plane_flag */
+        H264_ReadUE(rbsp, rbspSize, &bitPos);           /* bit_depth_luma_minus8 */
+        H264_ReadUE(rbsp, rbspSize, &bitPos);           /* bit_depth_chroma_minus8 */
+        H264_ReadBits(rbsp, rbspSize, &bitPos, 1);      /* qpprime_y_zero_transform_bypass_flag */
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            OMX_U32 listNum = (chromaFormatIdc != 3) ? 8 : 12;
+            OMX_S32 lastScale, nextScale;
+            OMX_U32 j, size;
+
+            for (i = 0; i < listNum; i++) {
+                if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1) == 0)
+                    continue;
+                size = (i < 6) ? 16 : 64;
+                lastScale = nextScale = 8;
+                /* next_scale == 0 repeats the last scale up to the end of the list */
+                for (j = 0; (j < size) && (nextScale != 0); j++) {
+                    nextScale = (lastScale + H264_ReadSE(rbsp, rbspSize, &bitPos) + 256) % 256;
+                    if (nextScale != 0)
+                        lastScale = nextScale;
+                }
+            }
+        }
+    }
+    H264_ReadUE(rbsp, rbspSize, &bitPos);               /* log2_max_frame_num_minus4 */
+    pocType = H264_ReadUE(rbsp, rbspSize, &bitPos);
+    if (pocType == 0) {
+        H264_ReadUE(rbsp, rbspSize, &bitPos);           /* log2_max_pic_order_cnt_lsb_minus4 */
+    } else if (pocType == 1) {
+        OMX_U32 cycle;
+
+        H264_ReadBits(rbsp, rbspSize, &bitPos, 1);      /* delta_pic_order_always_zero_flag */
+        H264_ReadSE(rbsp, rbspSize, &bitPos);           /* offset_for_non_ref_pic */
+        H264_ReadSE(rbsp, rbspSize, &bitPos);           /* offset_for_top_to_bottom_field */
+        cycle = H264_ReadUE(rbsp, rbspSize, &bitPos);
+        for (i = 0; (i < cycle) && (i < 256); i++)
+            H264_ReadSE(rbsp, rbspSize, &bitPos);
+    }
+    if (bitPos > (rbspSize << 3))
+        return -1;
+    /* POC type 2 means output order equals decoding order */
+    if (pocType == 2)
+        return 0;
+
+    H264_ReadUE(rbsp, rbspSize, &bitPos);               /* max_num_ref_frames */
+    H264_ReadBits(rbsp, rbspSize, &bitPos, 1);          /* gaps_in_frame_num_value_allowed_flag */
+    H264_ReadUE(rbsp, rbspSize, &bitPos);               /* pic_width_in_mbs_minus1 */
+    H264_ReadUE(rbsp, rbspSize, &bitPos);               /* pic_height_in_map_units_minus1 */
+    if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1) == 0)
+        H264_ReadBits(rbsp, rbspSize, &bitPos, 1);      /* mb_adaptive_frame_field_flag */
+    H264_ReadBits(rbsp, rbspSize, &bitPos, 1);          /* direct_8x8_inference_flag */
+    if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+        for (i = 0; i < 4; i++)
+            H264_ReadUE(rbsp, rbspSize, &bitPos);       /* frame_crop_*_offset */
+    }
+
+    if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+        OMX_U32 nalHrd, vclHrd;
+
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            if (H264_ReadBits(rbsp, rbspSize, &bitPos, 8) == 255)
+                H264_ReadBits(rbsp, rbspSize, &bitPos, 32); /* sar_width, sar_height */
+        }
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1))
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 1);  /* overscan_appropriate_flag */
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 4);  /* video_format, video_full_range_flag */
+            if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1))
+                H264_ReadBits(rbsp, rbspSize, &bitPos, 24); /* colour description */
+        }
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            H264_ReadUE(rbsp, rbspSize, &bitPos);       /* chroma_sample_loc_type_top_field */
+            H264_ReadUE(rbsp, rbspSize, &bitPos);       /* chroma_sample_loc_type_bottom_field */
+        }
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 32); /* num_units_in_tick */
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 32); /* time_scale */
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 1);  /* fixed_frame_rate_flag */
+        }
+        nalHrd = H264_ReadBits(rbsp, rbspSize, &bitPos, 1);
+        if (nalHrd)
+            H264_SkipHRD(rbsp, rbspSize, &bitPos);
+        vclHrd = H264_ReadBits(rbsp, rbspSize, &bitPos, 1);
+        if (vclHrd)
+            H264_SkipHRD(rbsp, rbspSize, &bitPos);
+        if (nalHrd || vclHrd)
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 1);  /* low_delay_hrd_flag */
+        H264_ReadBits(rbsp, rbspSize, &bitPos, 1);      /* pic_struct_present_flag */
+        if (H264_ReadBits(rbsp, rbspSize, &bitPos, 1)) {
+            H264_ReadBits(rbsp, rbspSize, &bitPos, 1);  /* motion_vectors_over_pic_boundaries_flag */
+            for (i = 0; i < 4; i++)
+                H264_ReadUE(rbsp, rbspSize, &bitPos);   /* max_bytes_per_pic_denom ... log2_max_mv_length_vertical */
+            if ((bitPos >> 3) < rbspSize) {
+                OMX_U32 reorderFrames = H264_ReadUE(rbsp, rbspSize, &bitPos);
+
+                if ((reorderFrames != H264_UE_INVALID) && (bitPos <= (rbspSize << 3)))
+                    return (OMX_S32)reorderFrames;
+                return -1;
+            }
+        }
+    }
+    if (bitPos > (rbspSize << 3))
+        return -1;
+
+    /* Baseline has no B slices, decoding order is output order in practice */
+    if (profileIdc == 66)
+        return 0;
+
+    return -1;
+}
+
+/* returns OMX_TRUE if the buffer starts a sequence other than the one MFC was opened with */
+static OMX_BOOL Check_H264_NewSequence(SEC_H264DEC_HANDLE *pH264Dec, OMX_U8 *pInputStream, OMX_U32 streamSize, OMX_U32 nFlags)
+{
+    OMX_U8  rbsp[H264_SPS_PARSE_SIZE_MAX];
+    OMX_U32 rbspSize = 0;
+    OMX_U32 i = 0;
+
+    /* only codec config and access units that open with an SPS are looked at */
+    if (!(nFlags & OMX_BUFFERFLAG_CODECCONFIG)) {
+        while ((i < streamSize) && (i < 3) && (pInputStream[i] == 0x00))
+            i++;
+        if ((i < 2) || ((i + 1) >= streamSize) ||
+            (pInputStream[i] != 0x01) || ((pInputStream[i + 1] & 0x1F) != 7))
+            return OMX_FALSE;
+    }
+
+    rbspSize = H264_GetSPS(pInputStream, streamSize, rbsp);
+    if (rbspSize < 4)
+        return OMX_FALSE;
+
+    if ((rbspSize == pH264Dec->hMFCH264Handle.configSPSSize) &&
+        (memcmp(rbsp, pH264Dec->hMFCH264Handle.configSPS, rbspSize) == 0))
+        return OMX_FALSE;
+
+    return OMX_TRUE;
+}
+
+/* returns OMX_TRUE if the access unit holds an IDR or an I slice */
+static OMX_BOOL Check_H264_IntraFrame(OMX_U8 *pInputStream, OMX_U32 streamSize)
+{
+    OMX_U32 preThreeByte = (OMX_U32)-1;
+    OMX_U32 i = 0;
+
+    for (i = 0; i < streamSize; i++) {
+        if ((preThreeByte & 0x00FFFFFF) == 0x00000001) {
+            int naluType = pInputStream[i] & 0x1F;
+
+            if (naluType == 5)
+                return OMX_TRUE;
+            if (naluType == 1) {
+                OMX_U32 bitPos = 0;
+                OMX_U32 sliceType = 0;
+
+                /* first_mb_in_slice, slice_type */
+                H264_ReadUE(pInputStream + i + 1, streamSize - i - 1, &bitPos);
+                sliceType = H264_ReadUE(pInputStream + i + 1, streamSize - i - 1, &bitPos);
+                if (sliceType == H264_UE_INVALID)
+                    return OMX_FALSE;
+                return ((sliceType % 5) == 2) ? OMX_TRUE : OMX_FALSE;
+            }
+        }
+        preThreeByte = (preThreeByte << 8) | pInputStream[i];
+    }
+
+    return OMX_FALSE;
+}
+
 OMX_ERRORTYPE SEC_MFC_H264Dec_GetParameter(
     OMX_IN OMX_HANDLETYPE hComponent,
     OMX_IN OMX_INDEXTYPE  nParamIndex,
@@ -461,6 +741,13 @@ OMX_ERRORTYPE SEC_MFC_H264Dec_SetParameter(
                 ret = OMX_ErrorUnsupportedSetting;
                 break;
             }
+
+            SEC_UpdateAdaptiveBufferSize(pOMXComponent);
+            SEC_UpdateThumbnailFrameSize(pOMXComponent,
+                ((SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle)->hMFCH264Handle.nThumbnailScale);
+        } else {
+            /* the client does not get to shrink adaptive buffers */
+            SEC_UpdateAdaptiveBufferSize(pOMXComponent);
         }
     }
         break;
@@ -589,6 +876,20 @@ OMX_ERRORTYPE SEC_MFC_H264Dec_GetConfig(
         pDstRectType->nWidth = pSrcRectType->nWidth;
     }
         break;
+    case OMX_IndexVendorThumbnailScale:
+    {
+        SEC_H264DEC_HANDLE *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
+
+        *((OMX_U32 *)pComponentConfigStructure) = pH264Dec->hMFCH264Handle.nThumbnailScale;
+    }
+        break;
+    case OMX_IndexVendorLowLatencyMode:
+    {
+        SEC_H264DEC_HANDLE *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
+
+        *((OMX_BOOL *)pComponentConfigStructure) = pH264Dec->hMFCH264Handle.bLowLatencyMode;
+    }
+        break;
     default:
         ret = SEC_OMX_GetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -643,6 +944,42 @@ OMX_ERRORTYPE SEC_MFC_H264Dec_SetConfig(
 
         pH264Dec->hMFCH264Handle.bThumbnailMode = *((OMX_BOOL *)pComponentConfigStructure);
 
+        ret = OMX_ErrorNone;
+    }
+        break;
+    case OMX_IndexVendorThumbnailScale:
+    {
+        SEC_H264DEC_HANDLE *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
+        OMX_U32             nScale = *((OMX_U32 *)pComponentConfigStructure);
+
+        if (pSECComponent->currentState != OMX_StateLoaded) {
+            ret = OMX_ErrorIncorrectStateOperation;
+            goto EXIT;
+        }
+        if ((nScale == 0) || (nScale > THUMBNAIL_SCALE_MAX) || (nScale & (nScale - 1))) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        pH264Dec->hMFCH264Handle.nThumbnailScale = nScale;
+        SEC_UpdateFrameSize(pOMXComponent);
+        SEC_UpdateThumbnailFrameSize(pOMXComponent, nScale);
+
+        ret = OMX_ErrorNone;
+    }
+        break;
+    case OMX_IndexVendorLowLatencyMode:
+    {
+        SEC_H264DEC_HANDLE *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
+
+        /* display delay is programmed once, before MFC init */
+        if (pH264Dec->hMFCH264Handle.bConfiguredMFC == OMX_TRUE) {
+            ret = OMX_ErrorIncorrectStateOperation;
+            goto EXIT;
+        }
+
+        pH264Dec->hMFCH264Handle.bLowLatencyMode = *((OMX_BOOL *)pComponentConfigStructure);
+
         ret = OMX_ErrorNone;
     }
         break;
@@ -697,10 +1034,19 @@ OMX_ERRORTYPE SEC_MFC_H264Dec_GetExtensionIndex(
         SEC_H264DEC_HANDLE *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
         *pIndexType = OMX_IndexVendorThumbnailMode;
         ret = OMX_ErrorNone;
+    } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_CONFIG_THUMBNAIL_SCALE) == 0) {
+        *pIndexType = OMX_IndexVendorThumbnailScale;
+        ret = OMX_ErrorNone;
+    } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_CONFIG_LOW_LATENCY) == 0) {
+        *pIndexType = OMX_IndexVendorLowLatencyMode;
+        ret = OMX_ErrorNone;
 #ifdef USE_ANDROID_EXTENSION
     } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_ENABLE_ANB) == 0) {
         *pIndexType = OMX_IndexParamEnableAndroidBuffers;
         ret = OMX_ErrorNone;
+    } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_PREPARE_ADAPTIVE_PLAYBACK) == 0) {
+        *pIndexType = OMX_IndexParamPrepareForAdaptivePlayback;
+        ret = OMX_ErrorNone;
     } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_GET_ANB) == 0) {
         *pIndexType = OMX_IndexParamGetAndroidNativeBuffer;
         ret = OMX_ErrorNone;
@@ -764,7 +1110,9 @@ OMX_ERRORTYPE SEC_MFC_DecodeThread(OMX_HANDLETYPE hComponent)
         SEC_OSAL_SemaphoreWait(pH264Dec->NBDecThread.hDecFrameStart);
 
         if (pH264Dec->NBDecThread.bExitDecodeThread == OMX_FALSE) {
+            OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
             pH264Dec->hMFCH264Handle.returnCodec = SsbSipMfcDecExe(pH264Dec->hMFCH264Handle.hMFCHandle, pH264Dec->NBDecThread.oneFrameSize);
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CODEC, nStartUs);
             SEC_OSAL_SemaphorePost(pH264Dec->NBDecThread.hDecFrameEnd);
         }
     }
@@ -789,6 +1137,7 @@ OMX_ERRORTYPE SEC_MFC_H264Dec_Init(OMX_COMPONENTTYPE *pOMXComponent)
 
     pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
     pH264Dec->hMFCH264Handle.bConfiguredMFC = OMX_FALSE;
+    pH264Dec->hMFCH264Handle.bThumbnailDone = OMX_FALSE;
     pSECComponent->bUseFlagEOF = OMX_FALSE;
     pSECComponent->bSaveFlagEOS = OMX_FALSE;
 
@@ -891,6 +1240,90 @@ EXIT:
     return ret;
 }
 
+/*
+ * Adaptive playback: a new sequence reopens the MFC instance instead of going
+ * through an output port reconfiguration. The output buffers belong to the
+ * client and are only written by the colour conversion, so they stay as they
+ * are. Pictures MFC still holds for reordering are dropped at the switch.
+ */
+static OMX_ERRORTYPE SEC_MFC_H264Dec_Reopen(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA *pInputData)
+{
+    OMX_ERRORTYPE          ret = OMX_ErrorNone;
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_H264DEC_HANDLE    *pH264Dec = (SEC_H264DEC_HANDLE *)pSECComponent->hCodecHandle;
+    SSBIP_MFC_BUFFER_TYPE  buf_type = CACHE;
+    OMX_PTR                hMFCHandle = NULL;
+    OMX_PTR                pStreamBuffer = NULL;
+    OMX_PTR                pStreamPhyBuffer = NULL;
+    OMX_PTR                pHeader = NULL;
+
+    FunctionIn();
+
+    SEC_OSAL_Log(SEC_LOG_TRACE, "new sequence header, reopen MFC");
+
+    if (pH264Dec->NBDecThread.bDecoderRun == OMX_TRUE) {
+        SEC_OSAL_SemaphoreWait(pH264Dec->NBDecThread.hDecFrameEnd);
+        pH264Dec->NBDecThread.bDecoderRun = OMX_FALSE;
+    }
+
+    /* the header sits in the input buffer of the old instance, which goes first to keep one instance around */
+    pHeader = SEC_OSAL_Malloc(pInputData->dataLen);
+    if (pHeader == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+    SEC_OSAL_Memcpy(pHeader, pInputData->dataBuffer, pInputData->dataLen);
+
+    SsbSipMfcDecClose(pH264Dec->hMFCH264Handle.hMFCHandle);
+    pH264Dec->hMFCH264Handle.hMFCHandle = NULL;
+    pH264Dec->hMFCH264Handle.pMFCStreamBuffer    = NULL;
+    pH264Dec->hMFCH264Handle.pMFCStreamPhyBuffer = NULL;
+    pH264Dec->hMFCH264Handle.bConfiguredMFC = OMX_FALSE;
+
+    hMFCHandle = (OMX_PTR)SsbSipMfcDecOpen(&buf_type);
+    if (hMFCHandle == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+    pStreamBuffer = SsbSipMfcDecGetInBuf(hMFCHandle, &pStreamPhyBuffer, DEFAULT_MFC_INPUT_BUFFER_SIZE * MFC_INPUT_BUFFER_NUM_MAX);
+    if (pStreamBuffer == NULL) {
+        SsbSipMfcDecClose(hMFCHandle);
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+    SEC_OSAL_Memcpy(pStreamBuffer, pHeader, pInputData->dataLen);
+    pH264Dec->hMFCH264Handle.hMFCHandle = hMFCHandle;
+
+    pH264Dec->MFCDecInputBuffer[0].VirAddr = pStreamBuffer;
+    pH264Dec->MFCDecInputBuffer[0].PhyAddr = pStreamPhyBuffer;
+    pH264Dec->MFCDecInputBuffer[0].dataSize = 0;
+    pH264Dec->MFCDecInputBuffer[1].VirAddr = (unsigned char *)pStreamBuffer + pH264Dec->MFCDecInputBuffer[0].bufferSize;
+    pH264Dec->MFCDecInputBuffer[1].PhyAddr = (unsigned char *)pStreamPhyBuffer + pH264Dec->MFCDecInputBuffer[0].bufferSize;
+    pH264Dec->MFCDecInputBuffer[1].dataSize = 0;
+    pH264Dec->indexInputBuffer = 0;
+
+    pH264Dec->hMFCH264Handle.pMFCStreamBuffer    = pH264Dec->MFCDecInputBuffer[0].VirAddr;
+    pH264Dec->hMFCH264Handle.pMFCStreamPhyBuffer = pH264Dec->MFCDecInputBuffer[0].PhyAddr;
+    pSECComponent->processData[INPUT_PORT_INDEX].dataBuffer = pH264Dec->MFCDecInputBuffer[0].VirAddr;
+    pSECComponent->processData[INPUT_PORT_INDEX].allocSize  = pH264Dec->MFCDecInputBuffer[0].bufferSize;
+
+    pH264Dec->hMFCH264Handle.returnCodec = MFC_RET_OK;
+    pH264Dec->bFirstFrame = OMX_TRUE;
+
+    SEC_OSAL_Memset(pSECComponent->timeStamp, -19771003, sizeof(OMX_TICKS) * MAX_TIMESTAMP);
+    SEC_OSAL_Memset(pSECComponent->nFlags, 0, sizeof(OMX_U32) * MAX_FLAGS);
+    pH264Dec->hMFCH264Handle.indexTimestamp = 0;
+    pSECComponent->getAllDelayBuffer = OMX_FALSE;
+
+EXIT:
+    if (pHeader != NULL)
+        SEC_OSAL_Free(pHeader);
+
+    FunctionOut();
+
+    return ret;
+}
+
 OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA *pInputData, SEC_OMX_DATA *pOutputData)
 {
     OMX_ERRORTYPE              ret = OMX_ErrorNone;
@@ -902,9 +1335,19 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
     int                        bufWidth = 0;
     int                        bufHeight = 0;
     OMX_BOOL                   outputDataValid = OMX_FALSE;
+    OMX_BOOL                   bReopened = OMX_FALSE;
 
     FunctionIn();
 
+    if ((pH264Dec->hMFCH264Handle.bConfiguredMFC == OMX_TRUE) &&
+        (pSECComponent->pSECPort[OUTPUT_PORT_INDEX].bAdaptivePlayback == OMX_TRUE) &&
+        (Check_H264_NewSequence(pH264Dec, pInputData->dataBuffer, oneFrameSize, pInputData->nFlags) == OMX_TRUE)) {
+        ret = SEC_MFC_H264Dec_Reopen(pOMXComponent, pInputData);
+        if (ret != OMX_ErrorNone)
+            goto EXIT;
+        bReopened = OMX_TRUE;
+    }
+
     if (pH264Dec->hMFCH264Handle.bConfiguredMFC == OMX_FALSE) {
         SSBSIP_MFC_CODEC_TYPE eCodecType = H264_DEC;
 
@@ -920,10 +1363,18 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
 
         /* Default number in the driver is optimized */
         if (pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_TRUE) {
-            setConfVal = 1;
+            /* thumbnail only needs the first picture, do not wait for reordering */
+            setConfVal = 0;
+            SsbSipMfcDecSetConfig(pH264Dec->hMFCH264Handle.hMFCHandle, MFC_DEC_SETCONF_DISPLAY_DELAY, &setConfVal);
+        } else if (pH264Dec->hMFCH264Handle.bLowLatencyMode == OMX_TRUE) {
+            /* hold back only as many frames as the stream can reorder */
+            setConfVal = H264_GetReorderDepth(pInputData->dataBuffer, oneFrameSize);
+            if ((setConfVal < 0) || (setConfVal > H264_DEFAULT_DISPLAY_DELAY))
+                setConfVal = H264_DEFAULT_DISPLAY_DELAY;
+            SEC_OSAL_Log(SEC_LOG_TRACE, "low latency mode, display delay : %d", setConfVal);
             SsbSipMfcDecSetConfig(pH264Dec->hMFCH264Handle.hMFCHandle, MFC_DEC_SETCONF_DISPLAY_DELAY, &setConfVal);
         } else {
-            setConfVal = 8;
+            setConfVal = H264_DEFAULT_DISPLAY_DELAY;
             SsbSipMfcDecSetConfig(pH264Dec->hMFCH264Handle.hMFCHandle, MFC_DEC_SETCONF_DISPLAY_DELAY, &setConfVal);
         }
 
@@ -950,11 +1401,32 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
             secOutputPort->cropRectangle.nLeft   = cropInfo.crop_left_offset;
             secOutputPort->cropRectangle.nWidth  = imgResol.width - cropInfo.crop_left_offset - cropInfo.crop_right_offset;
             secOutputPort->cropRectangle.nHeight = imgResol.height - cropInfo.crop_top_offset - cropInfo.crop_bottom_offset;
+            if (pH264Dec->hMFCH264Handle.nThumbnailScale > 1) {
+                secOutputPort->cropRectangle.nTop    /= pH264Dec->hMFCH264Handle.nThumbnailScale;
+                secOutputPort->cropRectangle.nLeft   /= pH264Dec->hMFCH264Handle.nThumbnailScale;
+                secOutputPort->cropRectangle.nWidth  /= pH264Dec->hMFCH264Handle.nThumbnailScale;
+                secOutputPort->cropRectangle.nHeight /= pH264Dec->hMFCH264Handle.nThumbnailScale;
+            }
 
             pH264Dec->hMFCH264Handle.bConfiguredMFC = OMX_TRUE;
+            pH264Dec->hMFCH264Handle.configSPSSize =
+                H264_GetSPS(pInputData->dataBuffer, oneFrameSize, pH264Dec->hMFCH264Handle.configSPS);
 
             /** Update Frame Size **/
-            if ((cropInfo.crop_left_offset != 0) || (cropInfo.crop_right_offset != 0) ||
+            if (SEC_CheckAdaptiveFrameSize(pOMXComponent, imgResol.width, imgResol.height) == OMX_TRUE) {
+                /* output buffers are sized for the maximum frame, only the geometry and crop change */
+                if ((secInputPort->portDefinition.format.video.nFrameWidth != imgResol.width) ||
+                    (secInputPort->portDefinition.format.video.nFrameHeight != imgResol.height) ||
+                    (cropInfo.crop_left_offset != 0) || (cropInfo.crop_right_offset != 0) ||
+                    (cropInfo.crop_top_offset != 0) || (cropInfo.crop_bottom_offset != 0)) {
+                    secInputPort->portDefinition.format.video.nFrameWidth = imgResol.width;
+                    secInputPort->portDefinition.format.video.nFrameHeight = imgResol.height;
+
+                    SEC_UpdateFrameSize(pOMXComponent);
+
+                    SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventPortSettingsChanged, OMX_DirOutput, OMX_IndexConfigCommonOutputCrop, NULL);
+                }
+            } else if ((cropInfo.crop_left_offset != 0) || (cropInfo.crop_right_offset != 0) ||
                 (cropInfo.crop_top_offset != 0) || (cropInfo.crop_bottom_offset != 0)) {
                 /* change width and height information */
                 secInputPort->portDefinition.format.video.nFrameWidth = imgResol.width;
@@ -963,15 +1435,10 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
                 secInputPort->portDefinition.format.video.nSliceHeight = ((imgResol.height + 15) & (~15));
 
                 SEC_UpdateFrameSize(pOMXComponent);
+                SEC_UpdateThumbnailFrameSize(pOMXComponent, pH264Dec->hMFCH264Handle.nThumbnailScale);
 
                 /** Send crop info call back */
-                (*(pSECComponent->pCallbacks->EventHandler))
-                      (pOMXComponent,
-                       pSECComponent->callbackData,
-                       OMX_EventPortSettingsChanged, /* The command was completed */
-                       OMX_DirOutput, /* This is the port index */
-                       OMX_IndexConfigCommonOutputCrop,
-                       NULL);
+                SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventPortSettingsChanged, OMX_DirOutput, OMX_IndexConfigCommonOutputCrop, NULL);
             } else if((secInputPort->portDefinition.format.video.nFrameWidth != imgResol.width) ||
                       (secInputPort->portDefinition.format.video.nFrameHeight != imgResol.height)) {
                 SEC_OSAL_Log(SEC_LOG_TRACE, "change width height information : OMX_EventPortSettingsChanged");
@@ -982,24 +1449,26 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
                 secInputPort->portDefinition.format.video.nSliceHeight = ((imgResol.height + 15) & (~15));
 
                 SEC_UpdateFrameSize(pOMXComponent);
+                SEC_UpdateThumbnailFrameSize(pOMXComponent, pH264Dec->hMFCH264Handle.nThumbnailScale);
 
                 /** Send Port Settings changed call back */
-                (*(pSECComponent->pCallbacks->EventHandler))
-                      (pOMXComponent,
-                       pSECComponent->callbackData,
-                       OMX_EventPortSettingsChanged, /* The command was completed */
-                       OMX_DirOutput, /* This is the port index */
-                       0,
-                       NULL);
+                SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventPortSettingsChanged, OMX_DirOutput, 0, NULL);
             }
 
 #ifdef ADD_SPS_PPS_I_FRAME
             ret = OMX_ErrorInputDataDecodeYet;
 #else
-            pOutputData->timeStamp = pInputData->timeStamp;
-            pOutputData->nFlags = pInputData->nFlags;
+            if ((bReopened == OMX_TRUE) &&
+                !(pInputData->nFlags & OMX_BUFFERFLAG_CODECCONFIG) &&
+                (Check_H264_IntraFrame(pInputData->dataBuffer, oneFrameSize) == OMX_TRUE)) {
+                /* init only took the headers of this access unit, decode it again for its picture */
+                ret = OMX_ErrorInputDataDecodeYet;
+            } else {
+                pOutputData->timeStamp = pInputData->timeStamp;
+                pOutputData->nFlags = pInputData->nFlags;
 
-            ret = OMX_ErrorNone;
+                ret = OMX_ErrorNone;
+            }
 #endif
             goto EXIT;
         } else {
@@ -1008,11 +1477,28 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
         }
     }
 
+    if ((pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_TRUE) &&
+        ((pH264Dec->hMFCH264Handle.bThumbnailDone == OMX_TRUE) ||
+         ((pH264Dec->bFirstFrame == OMX_TRUE) &&
+          !(pInputData->nFlags & (OMX_BUFFERFLAG_CODECCONFIG | OMX_BUFFERFLAG_EOS)) &&
+          (Check_H264_IntraFrame(pInputData->dataBuffer, oneFrameSize) == OMX_FALSE)))) {
+        /* Thumbnail: drop everything before the first intra picture and after its output */
+        pOutputData->timeStamp = pInputData->timeStamp;
+        pOutputData->nFlags = (pInputData->nFlags & (~OMX_BUFFERFLAG_EOS));
+        pOutputData->dataLen = 0;
+        ret = OMX_ErrorNone;
+        goto EXIT;
+    }
+
 #ifndef FULL_FRAME_SEARCH
     if ((pInputData->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) &&
         (pSECComponent->bUseFlagEOF == OMX_FALSE))
         pSECComponent->bUseFlagEOF = OMX_TRUE;
 #endif
+    /* Low latency: each input buffer is one access unit, do not wait for the next start code */
+    if ((pH264Dec->hMFCH264Handle.bLowLatencyMode == OMX_TRUE) &&
+        (pSECComponent->bUseFlagEOF == OMX_FALSE))
+        pSECComponent->bUseFlagEOF = OMX_TRUE;
 
     pSECComponent->timeStamp[pH264Dec->hMFCH264Handle.indexTimestamp] = pInputData->timeStamp;
     pSECComponent->nFlags[pH264Dec->hMFCH264Handle.indexTimestamp] = pInputData->nFlags;
@@ -1087,6 +1573,10 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
         pOutputData->timeStamp = pInputData->timeStamp;
         pOutputData->nFlags = pInputData->nFlags;
 
+        /* the frame handed to MFC did not decode */
+        if (pH264Dec->hMFCH264Handle.returnCodec != MFC_RET_OK)
+            SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
+
         if ((pSECComponent->bSaveFlagEOS == OMX_TRUE) ||
             (pSECComponent->getAllDelayBuffer == OMX_TRUE) ||
             (pInputData->nFlags & OMX_BUFFERFLAG_EOS)) {
@@ -1119,7 +1609,8 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
     }
 
     if ((Check_H264_StartCode(pInputData->dataBuffer, pInputData->dataLen) == OMX_TRUE) &&
-        ((pOutputData->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS)) {
+        ((pOutputData->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS) &&
+        ((pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_FALSE) || (outputDataValid == OMX_FALSE))) {
         SsbSipMfcDecSetConfig(pH264Dec->hMFCH264Handle.hMFCHandle, MFC_DEC_SETCONF_FRAME_TAG, &(pH264Dec->hMFCH264Handle.indexTimestamp));
         pH264Dec->hMFCH264Handle.indexTimestamp++;
         pH264Dec->hMFCH264Handle.indexTimestamp %= MAX_TIMESTAMP;
@@ -1163,6 +1654,8 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
         int actualWidth  = outputInfo.img_width;
         int actualHeight = outputInfo.img_height;
         int actualImageSize = imageSize;
+        OMX_U32 nStride = 0;
+        OMX_U32 nPlaneSize = 0;
 
         pOutputBuf[0] = (void *)pOutputData->dataBuffer;
         pOutputBuf[1] = (void *)pOutputData->dataBuffer + actualImageSize;
@@ -1175,7 +1668,7 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
             actualWidth  = (outputInfo.img_width + 15) & (~15);
             actualImageSize = actualWidth * actualHeight;
 
-            retANB = getVADDRfromANB (pOutputData->dataBuffer,
+            retANB = getVADDRfromANB(pOMXComponent, OUTPUT_PORT_INDEX, pOutputData->dataBuffer,
                             (OMX_U32)pSECInputPort->portDefinition.format.video.nFrameWidth,
                             (OMX_U32)pSECInputPort->portDefinition.format.video.nFrameHeight,
                             pVirAddrs);
@@ -1188,6 +1681,19 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
             pOutputBuf[1] = pVirAddrs[1];
         }
 #endif
+        /* adaptive playback buffers keep the layout of the maximum frame */
+        if ((pSECOutputPort->bAdaptivePlayback == OMX_TRUE) &&
+            (pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_FALSE) &&
+            (pSECOutputPort->portDefinition.format.video.nStride >= (OMX_U32)actualWidth) &&
+            (pSECOutputPort->portDefinition.format.video.nSliceHeight >= (OMX_U32)actualHeight)) {
+            nStride = pSECOutputPort->portDefinition.format.video.nStride;
+            nPlaneSize = nStride * pSECOutputPort->portDefinition.format.video.nSliceHeight;
+            if (pSECOutputPort->bUseAndroidNativeBuffer == OMX_FALSE) {
+                pOutputBuf[1] = (void *)pOutputData->dataBuffer + nPlaneSize;
+                pOutputBuf[2] = (void *)pOutputData->dataBuffer + ((nPlaneSize * 5) / 4);
+            }
+        }
+        OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
         if ((pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_FALSE) &&
             (pSECOutputPort->portDefinition.format.video.eColorFormat == OMX_SEC_COLOR_FormatNV12TPhysicalAddress))
         {
@@ -1198,6 +1704,50 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
             SEC_OSAL_Memcpy(pOutputBuf[0] + sizeof(frameSize) + (sizeof(void *) * 2), &(outputInfo.YVirAddr), sizeof(outputInfo.YVirAddr));
             SEC_OSAL_Memcpy(pOutputBuf[0] + sizeof(frameSize) + (sizeof(void *) * 3), &(outputInfo.CVirAddr), sizeof(outputInfo.CVirAddr));
             pOutputData->dataLen = (bufWidth * bufHeight * 3) / 2;
+        } else if ((pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_TRUE) &&
+                   (pH264Dec->hMFCH264Handle.nThumbnailScale > 1)) {
+            int scale = pH264Dec->hMFCH264Handle.nThumbnailScale;
+            int scaledImageSize = ((actualWidth / scale) & (~1)) * ((actualHeight / scale) & (~1));
+
+            switch (pSECOutputPort->portDefinition.format.video.eColorFormat) {
+            case OMX_COLOR_FormatYUV420Planar:
+            {
+                SEC_OSAL_Log(SEC_LOG_TRACE, "YUV420P thumbnail out, scale 1/%d", scale);
+                csc_tiled_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0],
+                    (unsigned char *)outputInfo.YVirAddr,
+                    actualWidth,
+                    actualHeight,
+                    scale);
+                csc_tiled_uv_to_linear_downscale_deinterleave(
+                    (unsigned char *)pOutputBuf[0] + scaledImageSize,
+                    (unsigned char *)pOutputBuf[0] + ((scaledImageSize * 5) / 4),
+                    (unsigned char *)outputInfo.CVirAddr,
+                    actualWidth,
+                    actualHeight >> 1,
+                    scale);
+            }
+                break;
+            case OMX_COLOR_FormatYUV420SemiPlanar:
+            default:
+            {
+                SEC_OSAL_Log(SEC_LOG_TRACE, "YUV420SP thumbnail out, scale 1/%d", scale);
+                csc_tiled_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0],
+                    (unsigned char *)outputInfo.YVirAddr,
+                    actualWidth,
+                    actualHeight,
+                    scale);
+                csc_tiled_uv_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0] + scaledImageSize,
+                    (unsigned char *)outputInfo.CVirAddr,
+                    actualWidth,
+                    actualHeight >> 1,
+                    scale);
+            }
+                break;
+            }
+            pOutputData->dataLen = scaledImageSize * 3 / 2;
         } else {
             switch (pSECOutputPort->portDefinition.format.video.eColorFormat) {
             case OMX_COLOR_FormatYUV420Planar:
@@ -1215,6 +1765,12 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
                     actualWidth,
                     actualHeight >> 1);
                 pOutputData->dataLen = actualImageSize * 3 / 2;
+                if (nStride != 0) {
+                    SEC_SpreadFrameRows(pOutputBuf[0], actualWidth, actualHeight, nStride);
+                    SEC_SpreadFrameRows(pOutputBuf[1], actualWidth >> 1, actualHeight >> 1, nStride >> 1);
+                    SEC_SpreadFrameRows(pOutputBuf[2], actualWidth >> 1, actualHeight >> 1, nStride >> 1);
+                    pOutputData->dataLen = nPlaneSize * 3 / 2;
+                }
             }
                 break;
             case OMX_COLOR_FormatYUV420SemiPlanar:
@@ -1233,14 +1789,25 @@ OMX_ERRORTYPE SEC_MFC_H264_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
                     actualWidth,
                     actualHeight >> 1);
                 pOutputData->dataLen = actualImageSize * 3 / 2;
+                if (nStride != 0) {
+                    SEC_SpreadFrameRows(pOutputBuf[0], actualWidth, actualHeight, nStride);
+                    SEC_SpreadFrameRows(pOutputBuf[1], actualWidth, actualHeight >> 1, nStride);
+                    pOutputData->dataLen = nPlaneSize * 3 / 2;
+                }
             }
                 break;
             }
         }
+        SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CSC, nStartUs);
 #ifdef USE_ANDROID_EXTENSION
         if (pSECOutputPort->bUseAndroidNativeBuffer == OMX_TRUE)
-            putVADDRtoANB(pOutputData->dataBuffer);
+            putVADDRtoANB(pOMXComponent, OUTPUT_PORT_INDEX, pOutputData->dataBuffer);
 #endif
+        if (pH264Dec->hMFCH264Handle.bThumbnailMode == OMX_TRUE) {
+            /* one picture is all the client asked for, end the stream here */
+            pOutputData->nFlags |= OMX_BUFFERFLAG_EOS;
+            pH264Dec->hMFCH264Handle.bThumbnailDone = OMX_TRUE;
+        }
     } else {
         pOutputData->dataLen = 0;
     }
@@ -1349,6 +1916,7 @@ OSCL_EXPORT_REF OMX_ERRORTYPE SEC_OMX_ComponentInit(OMX_HANDLETYPE hComponent, O
     }
     SEC_OSAL_Memset(pH264Dec, 0, sizeof(SEC_H264DEC_HANDLE));
     pSECComponent->hCodecHandle = (OMX_HANDLETYPE)pH264Dec;
+    pH264Dec->hMFCH264Handle.nThumbnailScale = 1;
 
     SEC_OSAL_Strcpy(pSECComponent->componentName, SEC_OMX_COMPONENT_H264_DEC);
     /* Set componentVersion */
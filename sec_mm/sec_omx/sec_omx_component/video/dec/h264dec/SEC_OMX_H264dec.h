@@ -31,6 +31,9 @@
 #include "OMX_Component.h"
 #include "OMX_Video.h"
 
+#define H264_DEFAULT_DISPLAY_DELAY   8
+#define H264_SPS_PARSE_SIZE_MAX      256
+#define H264_UE_INVALID              ((OMX_U32)-1)
 
 typedef struct _SEC_MFC_H264DEC_HANDLE
 {
@@ -40,7 +43,12 @@ typedef struct _SEC_MFC_H264DEC_HANDLE
     OMX_U32    indexTimestamp;
     OMX_BOOL bConfiguredMFC;
     OMX_BOOL bThumbnailMode;
+    OMX_U32  nThumbnailScale;
+    OMX_BOOL bThumbnailDone;
+    OMX_BOOL bLowLatencyMode;
     OMX_S32  returnCodec;
+    OMX_U8   configSPS[H264_SPS_PARSE_SIZE_MAX];
+    OMX_U32  configSPSSize;
 } SEC_MFC_H264DEC_HANDLE;
 
 typedef struct _SEC_H264DEC_HANDLE
@@ -36,6 +36,9 @@
 #include "SEC_OMX_Mpeg4dec.h"
 #include "SsbSipMfcApi.h"
 #include "color_space_convertor.h"
+#ifdef USE_ANDROID_EXTENSION
+#include "SEC_OSAL_Buffer.h"
+#endif
 
 #undef  SEC_LOG_TAG
 #define SEC_LOG_TAG    "SEC_MPEG4_DEC"
@@ -102,11 +105,10 @@ SEC_OMX_VIDEO_PROFILELEVEL supportedH263ProfileLevels[] = {
     {OMX_VIDEO_H263ProfileISWV2, OMX_VIDEO_H263Level60},
     {OMX_VIDEO_H263ProfileISWV2, OMX_VIDEO_H263Level70}};
 
-static OMX_HANDLETYPE ghMFCHandle = NULL;
-static OMX_BOOL gbFIMV1 = OMX_FALSE;
-
-static int Check_Mpeg4_Frame(OMX_U8 *pInputStream, OMX_U32 buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
+static int Check_Mpeg4_Frame(OMX_COMPONENTTYPE *pOMXComponent, OMX_U8 *pInputStream, OMX_U32 buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
 {
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_MPEG4_HANDLE      *pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
     int len, readStream;
     unsigned startCode;
     OMX_BOOL bFrameStart;
@@ -116,24 +118,24 @@ static int Check_Mpeg4_Frame(OMX_U8 *pInputStream, OMX_U32 buffSize, OMX_U32 fla
 
     if (flag & OMX_BUFFERFLAG_CODECCONFIG) {
         if (*pInputStream == 0x03) { /* FIMV1 */
-            if (ghMFCHandle != NULL) {
+            if (pMpeg4Dec->hMFCMpeg4Handle.hMFCHandle != NULL) {
                 BitmapInfoHhr *pInfoHeader;
                 SSBSIP_MFC_IMG_RESOLUTION imgResolution;
 
                 pInfoHeader = (BitmapInfoHhr *)(pInputStream + 1);
                 imgResolution.width = pInfoHeader->BiWidth;
                 imgResolution.height = pInfoHeader->BiHeight;
-                SsbSipMfcDecSetConfig(ghMFCHandle, MFC_DEC_SETCONF_FIMV1_WIDTH_HEIGHT, &imgResolution);
+                SsbSipMfcDecSetConfig(pMpeg4Dec->hMFCMpeg4Handle.hMFCHandle, MFC_DEC_SETCONF_FIMV1_WIDTH_HEIGHT, &imgResolution);
 
                 SEC_OSAL_Log(SEC_LOG_TRACE, "width(%d), height(%d)", imgResolution.width, imgResolution.height);
-                gbFIMV1 = OMX_TRUE;
+                pMpeg4Dec->hMFCMpeg4Handle.bFIMV1 = OMX_TRUE;
                 *pbEndOfFrame = OMX_TRUE;
                 return buffSize;
             }
         }
     }
 
-    if (gbFIMV1) {
+    if (pMpeg4Dec->hMFCMpeg4Handle.bFIMV1) {
         *pbEndOfFrame = OMX_TRUE;
         return buffSize;
     }
@@ -177,7 +179,7 @@ EXIT :
     return --len;
 }
 
-static int Check_H263_Frame(OMX_U8 *pInputStream, OMX_U32 buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
+static int Check_H263_Frame(OMX_COMPONENTTYPE *pOMXComponent, OMX_U8 *pInputStream, OMX_U32 buffSize, OMX_U32 flag, OMX_BOOL bPreviousFrameEOF, OMX_BOOL *pbEndOfFrame)
 {
     int len, readStream;
     unsigned startCode;
@@ -237,11 +239,11 @@ EXIT :
     return --len;
 }
 
-OMX_BOOL Check_Stream_PrefixCode(OMX_U8 *pInputStream, OMX_U32 streamSize, CODEC_TYPE codecType)
+OMX_BOOL Check_Stream_PrefixCode(OMX_U8 *pInputStream, OMX_U32 streamSize, SEC_MFC_MPEG4_HANDLE *pMFCMpeg4Handle)
 {
-    switch (codecType) {
+    switch (pMFCMpeg4Handle->codecType) {
     case CODEC_TYPE_MPEG4:
-        if (gbFIMV1) {
+        if (pMFCMpeg4Handle->bFIMV1) {
             return OMX_TRUE;
         } else {
             if (streamSize < 3) {
@@ -261,11 +263,42 @@ OMX_BOOL Check_Stream_PrefixCode(OMX_U8 *pInputStream, OMX_U32 streamSize, CODEC
         else
             return OMX_FALSE;
     default:
-        SEC_OSAL_Log(SEC_LOG_WARNING, "%s: undefined codec type (%d)", __FUNCTION__, codecType);
+        SEC_OSAL_Log(SEC_LOG_WARNING, "%s: undefined codec type (%d)", __FUNCTION__, pMFCMpeg4Handle->codecType);
         return OMX_FALSE;
     }
 }
 
+/* returns OMX_TRUE if the frame is an I-VOP or an INTRA picture */
+static OMX_BOOL Check_Stream_IntraFrame(OMX_U8 *pInputStream, OMX_U32 streamSize, SEC_MFC_MPEG4_HANDLE *pMFCMpeg4Handle)
+{
+    unsigned startCode = 0xFFFFFFFF;
+    OMX_U32  i = 0;
+
+    switch (pMFCMpeg4Handle->codecType) {
+    case CODEC_TYPE_MPEG4:
+        if (pMFCMpeg4Handle->bFIMV1)
+            return OMX_TRUE;
+
+        for (i = 0; i + 1 < streamSize; i++) {
+            startCode = (startCode << 8) | pInputStream[i];
+            /* vop_coding_type : 00 is I-VOP */
+            if (startCode == 0x1B6)
+                return ((pInputStream[i + 1] >> 6) == 0) ? OMX_TRUE : OMX_FALSE;
+        }
+        return OMX_FALSE;
+    case CODEC_TYPE_H263:
+        if (streamSize < 5)
+            return OMX_FALSE;
+        /* source format 7 is PLUSPTYPE, picture type is not at a fixed position */
+        if (((pInputStream[4] >> 2) & 0x07) == 0x07)
+            return OMX_TRUE;
+        /* picture coding type : 0 is INTRA */
+        return (((pInputStream[4] >> 1) & 0x01) == 0) ? OMX_TRUE : OMX_FALSE;
+    default:
+        return OMX_TRUE;
+    }
+}
+
 OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_GetParameter(
     OMX_IN    OMX_HANDLETYPE hComponent,
     OMX_IN    OMX_INDEXTYPE  nParamIndex,
@@ -619,6 +652,13 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_SetParameter(
                 ret = OMX_ErrorUnsupportedSetting;
                 break;
             }
+
+            SEC_UpdateAdaptiveBufferSize(pOMXComponent);
+            SEC_UpdateThumbnailFrameSize(pOMXComponent,
+                ((SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle)->hMFCMpeg4Handle.nThumbnailScale);
+        } else {
+            /* the client does not get to shrink adaptive buffers */
+            SEC_UpdateAdaptiveBufferSize(pOMXComponent);
         }
     }
         break;
@@ -733,6 +773,37 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_GetConfig(
     }
 
     switch (nIndex) {
+    case OMX_IndexConfigCommonOutputCrop:
+    {
+        SEC_MPEG4_HANDLE    *pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
+        OMX_CONFIG_RECTTYPE *pDstRectType = (OMX_CONFIG_RECTTYPE *)pComponentConfigStructure;
+        SEC_OMX_BASEPORT    *pSECPort = NULL;
+
+        if (pMpeg4Dec->hMFCMpeg4Handle.bConfiguredMFC == OMX_FALSE) {
+            ret = OMX_ErrorNotReady;
+            break;
+        }
+        if ((pDstRectType->nPortIndex != INPUT_PORT_INDEX) &&
+            (pDstRectType->nPortIndex != OUTPUT_PORT_INDEX)) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+
+        /* MPEG-4 has no cropping, the whole decoded frame is shown */
+        pSECPort = &pSECComponent->pSECPort[INPUT_PORT_INDEX];
+        pDstRectType->nTop    = 0;
+        pDstRectType->nLeft   = 0;
+        pDstRectType->nWidth  = pSECPort->portDefinition.format.video.nFrameWidth;
+        pDstRectType->nHeight = pSECPort->portDefinition.format.video.nFrameHeight;
+    }
+        break;
+    case OMX_IndexVendorThumbnailScale:
+    {
+        SEC_MPEG4_HANDLE *pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
+
+        *((OMX_U32 *)pComponentConfigStructure) = pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale;
+    }
+        break;
     default:
         ret = SEC_OMX_GetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -783,6 +854,25 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_SetConfig(
         pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode = *((OMX_BOOL *)pComponentConfigStructure);
     }
         break;
+    case OMX_IndexVendorThumbnailScale:
+    {
+        SEC_MPEG4_HANDLE *pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
+        OMX_U32           nScale = *((OMX_U32 *)pComponentConfigStructure);
+
+        if (pSECComponent->currentState != OMX_StateLoaded) {
+            ret = OMX_ErrorIncorrectStateOperation;
+            goto EXIT;
+        }
+        if ((nScale == 0) || (nScale > THUMBNAIL_SCALE_MAX) || (nScale & (nScale - 1))) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale = nScale;
+        SEC_UpdateFrameSize(pOMXComponent);
+        SEC_UpdateThumbnailFrameSize(pOMXComponent, nScale);
+    }
+        break;
     default:
         ret = SEC_OMX_SetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -834,10 +924,16 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_GetExtensionIndex(
         SEC_MPEG4_HANDLE *pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
         *pIndexType = OMX_IndexVendorThumbnailMode;
         ret = OMX_ErrorNone;
+    } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_CONFIG_THUMBNAIL_SCALE) == 0) {
+        *pIndexType = OMX_IndexVendorThumbnailScale;
+        ret = OMX_ErrorNone;
 #ifdef USE_ANDROID_EXTENSION
     } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_ENABLE_ANB) == 0) {
         *pIndexType = OMX_IndexParamEnableAndroidBuffers;
         ret = OMX_ErrorNone;
+    } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_PREPARE_ADAPTIVE_PLAYBACK) == 0) {
+        *pIndexType = OMX_IndexParamPrepareForAdaptivePlayback;
+        ret = OMX_ErrorNone;
     } else if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_GET_ANB) == 0) {
         *pIndexType = OMX_IndexParamGetAndroidNativeBuffer;
         ret = OMX_ErrorNone;
@@ -924,7 +1020,9 @@ OMX_ERRORTYPE SEC_MFC_DecodeThread(OMX_HANDLETYPE hComponent)
         SEC_OSAL_SemaphoreWait(pMpeg4Dec->NBDecThread.hDecFrameStart);
 
         if (pMpeg4Dec->NBDecThread.bExitDecodeThread == OMX_FALSE) {
+            OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
             pMpeg4Dec->hMFCMpeg4Handle.returnCodec = SsbSipMfcDecExe(pMpeg4Dec->hMFCMpeg4Handle.hMFCHandle, pMpeg4Dec->NBDecThread.oneFrameSize);
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CODEC, nStartUs);
             SEC_OSAL_SemaphorePost(pMpeg4Dec->NBDecThread.hDecFrameEnd);
         }
     }
@@ -950,6 +1048,8 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_Init(OMX_COMPONENTTYPE *pOMXComponent)
 
     pMpeg4Dec = (SEC_MPEG4_HANDLE *)pSECComponent->hCodecHandle;
     pMpeg4Dec->hMFCMpeg4Handle.bConfiguredMFC = OMX_FALSE;
+    pMpeg4Dec->hMFCMpeg4Handle.bThumbnailDone = OMX_FALSE;
+    pMpeg4Dec->hMFCMpeg4Handle.bFIMV1 = OMX_FALSE;
     pSECComponent->bUseFlagEOF = OMX_FALSE;
     pSECComponent->bSaveFlagEOS = OMX_FALSE;
 
@@ -960,7 +1060,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Dec_Init(OMX_COMPONENTTYPE *pOMXComponent)
         ret = OMX_ErrorInsufficientResources;
         goto EXIT;
     }
-    ghMFCHandle = pMpeg4Dec->hMFCMpeg4Handle.hMFCHandle = hMFCHandle;
+    pMpeg4Dec->hMFCMpeg4Handle.hMFCHandle = hMFCHandle;
 
     /* Allocate decoder's input buffer */
     pStreamBuffer = SsbSipMfcDecGetInBuf(hMFCHandle, &pStreamPhyBuffer, DEFAULT_MFC_INPUT_BUFFER_SIZE);
@@ -1072,7 +1172,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
     if (pMpeg4Dec->hMFCMpeg4Handle.bConfiguredMFC == OMX_FALSE) {
         SSBSIP_MFC_CODEC_TYPE MFCCodecType;
         if (pMpeg4Dec->hMFCMpeg4Handle.codecType == CODEC_TYPE_MPEG4) {
-            if (gbFIMV1)
+            if (pMpeg4Dec->hMFCMpeg4Handle.bFIMV1)
                 MFCCodecType = FIMV1_DEC;
             else
                 MFCCodecType = MPEG4_DEC;
@@ -1096,7 +1196,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         SsbSipMfcDecSetConfig(hMFCHandle, MFC_DEC_SETCONF_POST_ENABLE, &configValue);
 
         if (pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_TRUE) {
-            configValue = 1;    // the number that you want to delay
+            configValue = 0;    // the number that you want to delay
             SsbSipMfcDecSetConfig(hMFCHandle, MFC_DEC_SETCONF_DISPLAY_DELAY, &configValue);
         }
 
@@ -1114,22 +1214,22 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
             /** Update Frame Size **/
             if ((pInputPort->portDefinition.format.video.nFrameWidth != imgResol.width) ||
                 (pInputPort->portDefinition.format.video.nFrameHeight != imgResol.height)) {
-                /* change width and height information */
+                OMX_BOOL bFitAdaptive = SEC_CheckAdaptiveFrameSize(pOMXComponent, imgResol.width, imgResol.height);
+
+                /* change width and height information, adaptive buffers keep the stride of the maximum frame */
                 pInputPort->portDefinition.format.video.nFrameWidth = imgResol.width;
                 pInputPort->portDefinition.format.video.nFrameHeight = imgResol.height;
-                pInputPort->portDefinition.format.video.nStride      = ((imgResol.width + 15) & (~15));
-                pInputPort->portDefinition.format.video.nSliceHeight = ((imgResol.height + 15) & (~15));
+                if (bFitAdaptive == OMX_FALSE) {
+                    pInputPort->portDefinition.format.video.nStride      = ((imgResol.width + 15) & (~15));
+                    pInputPort->portDefinition.format.video.nSliceHeight = ((imgResol.height + 15) & (~15));
+                }
 
                 SEC_UpdateFrameSize(pOMXComponent);
+                SEC_UpdateThumbnailFrameSize(pOMXComponent, pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale);
 
-                /* Send Port Settings changed call back */
-                (*(pSECComponent->pCallbacks->EventHandler))
-                      (pOMXComponent,
-                       pSECComponent->callbackData,
-                       OMX_EventPortSettingsChanged, // The command was completed
-                       OMX_DirOutput, // This is the port index
-                       0,
-                       NULL);
+                /* Send Port Settings changed call back, only the crop when the buffers already fit */
+                SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventPortSettingsChanged, OMX_DirOutput,
+                                      (bFitAdaptive == OMX_TRUE) ? OMX_IndexConfigCommonOutputCrop : 0, NULL);
             }
 
             SEC_OSAL_Log(SEC_LOG_TRACE, "nFrameWidth(%d) nFrameHeight(%d), nStride(%d), nSliceHeight(%d)",
@@ -1153,6 +1253,19 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         }
     }
 
+    if ((pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_TRUE) &&
+        ((pMpeg4Dec->hMFCMpeg4Handle.bThumbnailDone == OMX_TRUE) ||
+         ((pMpeg4Dec->bFirstFrame == OMX_TRUE) &&
+          !(pInputData->nFlags & (OMX_BUFFERFLAG_CODECCONFIG | OMX_BUFFERFLAG_EOS)) &&
+          (Check_Stream_IntraFrame(pInputData->dataBuffer, oneFrameSize, &pMpeg4Dec->hMFCMpeg4Handle) == OMX_FALSE)))) {
+        /* Thumbnail: drop everything before the first intra picture and after its output */
+        pOutputData->timeStamp = pInputData->timeStamp;
+        pOutputData->nFlags = (pInputData->nFlags & (~OMX_BUFFERFLAG_EOS));
+        pOutputData->dataLen = 0;
+        ret = OMX_ErrorNone;
+        goto EXIT;
+    }
+
 #ifndef FULL_FRAME_SEARCH
     if ((pInputData->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) &&
         (pSECComponent->bUseFlagEOF == OMX_FALSE))
@@ -1232,6 +1345,10 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         pOutputData->timeStamp = pInputData->timeStamp;
         pOutputData->nFlags = pInputData->nFlags;
 
+        /* the frame handed to MFC did not decode */
+        if (pMpeg4Dec->hMFCMpeg4Handle.returnCodec != MFC_RET_OK)
+            SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
+
         if ((pSECComponent->bSaveFlagEOS == OMX_TRUE) ||
             (pSECComponent->getAllDelayBuffer == OMX_TRUE) ||
             (pInputData->nFlags & OMX_BUFFERFLAG_EOS)) {
@@ -1263,8 +1380,9 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         //pInputData->remainDataLen = oneFrameSize;
     }
 
-    if ((Check_Stream_PrefixCode(pInputData->dataBuffer, pInputData->dataLen, pMpeg4Dec->hMFCMpeg4Handle.codecType) == OMX_TRUE) &&
-        ((pOutputData->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS)) {
+    if ((Check_Stream_PrefixCode(pInputData->dataBuffer, pInputData->dataLen, &pMpeg4Dec->hMFCMpeg4Handle) == OMX_TRUE) &&
+        ((pOutputData->nFlags & OMX_BUFFERFLAG_EOS) != OMX_BUFFERFLAG_EOS) &&
+        ((pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_FALSE) || (outputDataValid == OMX_FALSE))) {
         SsbSipMfcDecSetConfig(hMFCHandle, MFC_DEC_SETCONF_FRAME_TAG, &(pMpeg4Dec->hMFCMpeg4Handle.indexTimestamp));
         pMpeg4Dec->hMFCMpeg4Handle.indexTimestamp++;
         pMpeg4Dec->hMFCMpeg4Handle.indexTimestamp %= MAX_TIMESTAMP;
@@ -1308,6 +1426,8 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         int actualWidth  = outputInfo.img_width;
         int actualHeight = outputInfo.img_height;
         int actualImageSize = imageSize;
+        OMX_U32 nStride = 0;
+        OMX_U32 nPlaneSize = 0;
 
         pOutputBuf[0] = (void *)pOutputData->dataBuffer;
         pOutputBuf[1] = (void *)pOutputData->dataBuffer + actualImageSize;
@@ -1320,7 +1440,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
             actualWidth  = (outputInfo.img_width + 15) & (~15);
             actualImageSize = actualWidth * actualHeight;
 
-             retANB = getVADDRfromANB(pOutputData->dataBuffer,
+             retANB = getVADDRfromANB(pOMXComponent, OUTPUT_PORT_INDEX, pOutputData->dataBuffer,
                             (OMX_U32)pSECInputPort->portDefinition.format.video.nFrameWidth,
                             (OMX_U32)pSECInputPort->portDefinition.format.video.nFrameHeight,
                             pVirAddrs);
@@ -1333,6 +1453,19 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
             pOutputBuf[1] = pVirAddrs[1];
         }
 #endif
+        /* adaptive playback buffers keep the layout of the maximum frame */
+        if ((pSECOutputPort->bAdaptivePlayback == OMX_TRUE) &&
+            (pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_FALSE) &&
+            (pSECOutputPort->portDefinition.format.video.nStride >= (OMX_U32)actualWidth) &&
+            (pSECOutputPort->portDefinition.format.video.nSliceHeight >= (OMX_U32)actualHeight)) {
+            nStride = pSECOutputPort->portDefinition.format.video.nStride;
+            nPlaneSize = nStride * pSECOutputPort->portDefinition.format.video.nSliceHeight;
+            if (pSECOutputPort->bUseAndroidNativeBuffer == OMX_FALSE) {
+                pOutputBuf[1] = (void *)pOutputData->dataBuffer + nPlaneSize;
+                pOutputBuf[2] = (void *)pOutputData->dataBuffer + ((nPlaneSize * 5) / 4);
+            }
+        }
+        OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
         if ((pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_FALSE) &&
             (pSECOutputPort->portDefinition.format.video.eColorFormat == OMX_SEC_COLOR_FormatNV12TPhysicalAddress))
         {
@@ -1343,6 +1476,50 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
             SEC_OSAL_Memcpy(pOutputBuf[0] + sizeof(frameSize) + (sizeof(void *) * 2), &(outputInfo.YVirAddr), sizeof(outputInfo.YVirAddr));
             SEC_OSAL_Memcpy(pOutputBuf[0] + sizeof(frameSize) + (sizeof(void *) * 3), &(outputInfo.CVirAddr), sizeof(outputInfo.CVirAddr));
             pOutputData->dataLen = (bufWidth * bufHeight * 3) / 2;
+        } else if ((pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_TRUE) &&
+                   (pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale > 1)) {
+            int scale = pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale;
+            int scaledImageSize = ((actualWidth / scale) & (~1)) * ((actualHeight / scale) & (~1));
+
+            switch (pSECOutputPort->portDefinition.format.video.eColorFormat) {
+            case OMX_COLOR_FormatYUV420Planar:
+            {
+                SEC_OSAL_Log(SEC_LOG_TRACE, "YUV420P thumbnail out, scale 1/%d", scale);
+                csc_tiled_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0],
+                    (unsigned char *)outputInfo.YVirAddr,
+                    actualWidth,
+                    actualHeight,
+                    scale);
+                csc_tiled_uv_to_linear_downscale_deinterleave(
+                    (unsigned char *)pOutputBuf[0] + scaledImageSize,
+                    (unsigned char *)pOutputBuf[0] + ((scaledImageSize * 5) / 4),
+                    (unsigned char *)outputInfo.CVirAddr,
+                    actualWidth,
+                    actualHeight >> 1,
+                    scale);
+            }
+                break;
+            case OMX_COLOR_FormatYUV420SemiPlanar:
+            default:
+            {
+                SEC_OSAL_Log(SEC_LOG_TRACE, "YUV420SP thumbnail out, scale 1/%d", scale);
+                csc_tiled_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0],
+                    (unsigned char *)outputInfo.YVirAddr,
+                    actualWidth,
+                    actualHeight,
+                    scale);
+                csc_tiled_uv_to_linear_downscale(
+                    (unsigned char *)pOutputBuf[0] + scaledImageSize,
+                    (unsigned char *)outputInfo.CVirAddr,
+                    actualWidth,
+                    actualHeight >> 1,
+                    scale);
+            }
+                break;
+            }
+            pOutputData->dataLen = scaledImageSize * 3 / 2;
         } else {
             switch (pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.eColorFormat) {
             case OMX_COLOR_FormatYUV420Planar:
@@ -1360,6 +1537,12 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
                     actualWidth,
                     actualHeight >> 1);
                 pOutputData->dataLen = actualImageSize * 3 / 2;
+                if (nStride != 0) {
+                    SEC_SpreadFrameRows(pOutputBuf[0], actualWidth, actualHeight, nStride);
+                    SEC_SpreadFrameRows(pOutputBuf[1], actualWidth >> 1, actualHeight >> 1, nStride >> 1);
+                    SEC_SpreadFrameRows(pOutputBuf[2], actualWidth >> 1, actualHeight >> 1, nStride >> 1);
+                    pOutputData->dataLen = nPlaneSize * 3 / 2;
+                }
             }
                 break;
             case OMX_COLOR_FormatYUV420SemiPlanar:
@@ -1378,14 +1561,25 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Decode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
                     actualWidth,
                     actualHeight >> 1);
                 pOutputData->dataLen = actualImageSize * 3 / 2;
+                if (nStride != 0) {
+                    SEC_SpreadFrameRows(pOutputBuf[0], actualWidth, actualHeight, nStride);
+                    SEC_SpreadFrameRows(pOutputBuf[1], actualWidth, actualHeight >> 1, nStride);
+                    pOutputData->dataLen = nPlaneSize * 3 / 2;
+                }
             }
                 break;
             }
         }
+        SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CSC, nStartUs);
 #ifdef USE_ANDROID_EXTENSION
         if (pSECOutputPort->bUseAndroidNativeBuffer == OMX_TRUE)
-            putVADDRtoANB(pOutputData->dataBuffer);
+            putVADDRtoANB(pOMXComponent, OUTPUT_PORT_INDEX, pOutputData->dataBuffer);
 #endif
+        if (pMpeg4Dec->hMFCMpeg4Handle.bThumbnailMode == OMX_TRUE) {
+            /* one picture is all the client asked for, end the stream here */
+            pOutputData->nFlags |= OMX_BUFFERFLAG_EOS;
+            pMpeg4Dec->hMFCMpeg4Handle.bThumbnailDone = OMX_TRUE;
+        }
     } else {
         pOutputData->dataLen = 0;
     }
@@ -1499,6 +1693,7 @@ OSCL_EXPORT_REF OMX_ERRORTYPE SEC_OMX_ComponentInit(OMX_HANDLETYPE hComponent, O
     }
     SEC_OSAL_Memset(pMpeg4Dec, 0, sizeof(SEC_MPEG4_HANDLE));
     pSECComponent->hCodecHandle = (OMX_HANDLETYPE)pMpeg4Dec;
+    pMpeg4Dec->hMFCMpeg4Handle.nThumbnailScale = 1;
     pMpeg4Dec->hMFCMpeg4Handle.codecType = codecType;
 
     if (codecType == CODEC_TYPE_MPEG4)
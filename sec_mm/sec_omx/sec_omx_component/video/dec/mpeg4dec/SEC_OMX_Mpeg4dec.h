@@ -63,7 +63,10 @@ typedef struct _SEC_MFC_MPEG4_HANDLE
     OMX_U32        indexTimestamp;
     OMX_BOOL       bConfiguredMFC;
     OMX_BOOL       bThumbnailMode;
+    OMX_U32        nThumbnailScale;
+    OMX_BOOL       bThumbnailDone;
     CODEC_TYPE     codecType;
+    OMX_BOOL       bFIMV1;
     OMX_S32        returnCodec;
 } SEC_MFC_MPEG4_HANDLE;
 
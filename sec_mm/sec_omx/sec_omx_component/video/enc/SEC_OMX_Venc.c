@@ -181,6 +181,7 @@ OMX_ERRORTYPE SEC_OMX_AllocateBuffer(
     SEC_OMX_BASEPORT      *pSECPort = NULL;
     OMX_BUFFERHEADERTYPE  *temp_bufferHeader = NULL;
     OMX_U8                *temp_buffer = NULL;
+    OMX_PTR                temp_phyAddr = NULL;
     int                    i = 0;
 
     FunctionIn();
@@ -217,15 +218,33 @@ OMX_ERRORTYPE SEC_OMX_AllocateBuffer(
         goto EXIT;
     }
 
-    temp_buffer = SEC_OSAL_Malloc(sizeof(OMX_U8) * nSizeBytes);
+    /*
+     * Output buffers taken from MFC memory let the encoder write the stream
+     * straight into them, see sec_mfc_allocateStreamBuffer.
+     */
+    if ((nPortIndex == OUTPUT_PORT_INDEX) && (pSECComponent->sec_mfc_allocateStreamBuffer != NULL) &&
+        (!CHECK_PORT_TUNNELED(pSECPort))) {
+        if (pSECComponent->sec_mfc_allocateStreamBuffer(pOMXComponent, nSizeBytes,
+                (OMX_PTR *)&temp_buffer, &temp_phyAddr) != OMX_ErrorNone) {
+            temp_buffer = NULL;
+            temp_phyAddr = NULL;
+        }
+    }
+
     if (temp_buffer == NULL) {
-        ret = OMX_ErrorInsufficientResources;
-        goto EXIT;
+        temp_buffer = SEC_OSAL_Malloc(sizeof(OMX_U8) * nSizeBytes);
+        if (temp_buffer == NULL) {
+            ret = OMX_ErrorInsufficientResources;
+            goto EXIT;
+        }
     }
 
     temp_bufferHeader = (OMX_BUFFERHEADERTYPE *)SEC_OSAL_Malloc(sizeof(OMX_BUFFERHEADERTYPE));
     if (temp_bufferHeader == NULL) {
-        SEC_OSAL_Free(temp_buffer);
+        if (temp_phyAddr != NULL)
+            pSECComponent->sec_mfc_freeStreamBuffer(pOMXComponent, temp_buffer);
+        else
+            SEC_OSAL_Free(temp_buffer);
         temp_buffer = NULL;
         ret = OMX_ErrorInsufficientResources;
         goto EXIT;
@@ -240,6 +259,7 @@ OMX_ERRORTYPE SEC_OMX_AllocateBuffer(
             temp_bufferHeader->pBuffer        = temp_buffer;
             temp_bufferHeader->nAllocLen        = nSizeBytes;
             temp_bufferHeader->pAppPrivate        = pAppPrivate;
+            temp_bufferHeader->pPlatformPrivate = temp_phyAddr;
             if (nPortIndex == INPUT_PORT_INDEX)
                 temp_bufferHeader->nInputPortIndex = INPUT_PORT_INDEX;
             else
@@ -258,7 +278,10 @@ OMX_ERRORTYPE SEC_OMX_AllocateBuffer(
     }
 
     SEC_OSAL_Free(temp_bufferHeader);
-    SEC_OSAL_Free(temp_buffer);
+    if (temp_phyAddr != NULL)
+        pSECComponent->sec_mfc_freeStreamBuffer(pOMXComponent, temp_buffer);
+    else
+        SEC_OSAL_Free(temp_buffer);
     ret = OMX_ErrorInsufficientResources;
 
 EXIT:
@@ -316,7 +339,10 @@ OMX_ERRORTYPE SEC_OMX_FreeBuffer(
         if (((pSECPort->bufferStateAllocate[i] | BUFFER_STATE_FREE) != 0) && (pSECPort->bufferHeader[i] != NULL)) {
             if (pSECPort->bufferHeader[i]->pBuffer == pBufferHdr->pBuffer) {
                 if (pSECPort->bufferStateAllocate[i] & BUFFER_STATE_ALLOCATED) {
-                    SEC_OSAL_Free(pSECPort->bufferHeader[i]->pBuffer);
+                    if (pSECPort->bufferHeader[i]->pPlatformPrivate != NULL)
+                        pSECComponent->sec_mfc_freeStreamBuffer(pOMXComponent, pSECPort->bufferHeader[i]->pBuffer);
+                    else
+                        SEC_OSAL_Free(pSECPort->bufferHeader[i]->pBuffer);
                     pSECPort->bufferHeader[i]->pBuffer = NULL;
                     pBufferHdr->pBuffer = NULL;
                 } else if (pSECPort->bufferStateAllocate[i] & BUFFER_STATE_ASSIGNED) {
@@ -426,10 +452,7 @@ static OMX_ERRORTYPE SEC_InputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
 
         if (bufferHeader->hMarkTargetComponent != NULL) {
             if (bufferHeader->hMarkTargetComponent == pOMXComponent) {
-                pSECComponent->pCallbacks->EventHandler(pOMXComponent,
-                                pSECComponent->callbackData,
-                                OMX_EventMark,
-                                0, 0, bufferHeader->pMarkData);
+                SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventMark, 0, 0, bufferHeader->pMarkData);
             } else {
                 pSECComponent->propagateMarkType.hMarkTargetComponent = bufferHeader->hMarkTargetComponent;
                 pSECComponent->propagateMarkType.pMarkData = bufferHeader->pMarkData;
@@ -440,7 +463,7 @@ static OMX_ERRORTYPE SEC_InputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
             OMX_FillThisBuffer(secOMXInputPort->tunneledComponent, bufferHeader);
         } else {
             bufferHeader->nFilledLen = 0;
-            pSECComponent->pCallbacks->EmptyBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
+            SEC_OMX_CallbackBufferDone(pOMXComponent, INPUT_PORT_INDEX, bufferHeader);
         }
     }
 
@@ -530,6 +553,11 @@ static OMX_ERRORTYPE SEC_OutputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
         bufferHeader->nFlags     = dataBuffer->nFlags;
         bufferHeader->nTimeStamp = dataBuffer->timeStamp;
 
+        if ((bufferHeader->nFilledLen > 0) &&
+            (bufferHeader->nFlags & OMX_BUFFERFLAG_ENDOFFRAME) &&
+            !(bufferHeader->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+            SEC_OMX_PerfFrameDone(pSECComponent, OMX_FALSE);
+
         if (pSECComponent->propagateMarkType.hMarkTargetComponent != NULL) {
             bufferHeader->hMarkTargetComponent = pSECComponent->propagateMarkType.hMarkTargetComponent;
             bufferHeader->pMarkData = pSECComponent->propagateMarkType.pMarkData;
@@ -538,17 +566,14 @@ static OMX_ERRORTYPE SEC_OutputBufferReturn(OMX_COMPONENTTYPE *pOMXComponent)
         }
 
         if (bufferHeader->nFlags & OMX_BUFFERFLAG_EOS) {
-            pSECComponent->pCallbacks->EventHandler(pOMXComponent,
-                            pSECComponent->callbackData,
-                            OMX_EventBufferFlag,
-                            OUTPUT_PORT_INDEX,
-                            bufferHeader->nFlags, NULL);
+            SEC_OMX_CallbackEvent(pOMXComponent, OMX_EventBufferFlag,
+                                  OUTPUT_PORT_INDEX, bufferHeader->nFlags, NULL);
         }
 
         if (CHECK_PORT_TUNNELED(secOMXOutputPort)) {
             OMX_EmptyThisBuffer(secOMXOutputPort->tunneledComponent, bufferHeader);
         } else {
-            pSECComponent->pCallbacks->FillBufferDone(pOMXComponent, pSECComponent->callbackData, bufferHeader);
+            SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, bufferHeader);
         }
     }
 
@@ -670,6 +695,7 @@ OMX_BOOL SEC_Preprocessor_InputData(OMX_COMPONENTTYPE *pOMXComponent)
     OMX_BOOL               flagEOS = OMX_FALSE;
     OMX_BOOL               flagEOF = OMX_FALSE;
     OMX_BOOL               previousFrameEOF = OMX_FALSE;
+    OMX_BOOL               bConverted = OMX_FALSE;
 
     if (inputUseBuffer->dataValid == OMX_TRUE) {
         checkInputStream = inputUseBuffer->bufferHeader->pBuffer + inputUseBuffer->usedDataLen;
@@ -762,6 +788,7 @@ OMX_BOOL SEC_Preprocessor_InputData(OMX_COMPONENTTYPE *pOMXComponent)
                     SEC_OSAL_Log(SEC_LOG_TRACE, "width:%d, height:%d, Ysize:%d", width, height, ALIGN_TO_8KB(ALIGN_TO_128B(width) * ALIGN_TO_32B(height)));
                     SEC_OSAL_Log(SEC_LOG_TRACE, "width:%d, height:%d, Csize:%d", width, height, ALIGN_TO_8KB(ALIGN_TO_128B(width) * ALIGN_TO_32B(height / 2)));
 
+                    OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
                     switch (pSECPort->portDefinition.format.video.eColorFormat) {
                     case OMX_COLOR_FormatYUV420Planar:
                         /* Real YUV420P Data */
@@ -778,6 +805,8 @@ OMX_BOOL SEC_Preprocessor_InputData(OMX_COMPONENTTYPE *pOMXComponent)
                         SEC_OSAL_Memcpy(inputData->specificBufferHeader.CVirAddr, checkInputStream + (width * height), (width * height / 2));
                         break;
                     }
+                    SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CSC, nStartUs);
+                    bConverted = OMX_TRUE;
                 }
             }
 
@@ -814,8 +843,14 @@ OMX_BOOL SEC_Preprocessor_InputData(OMX_COMPONENTTYPE *pOMXComponent)
             flagEOF = OMX_FALSE;
         }
 
+        /*
+         * The frame now lives in the MFC input buffer, which is double buffered
+         * against the one SsbSipMfcEncExe is reading on the NB encode thread.
+         * Hand the client buffer back right away so the source refills it while
+         * the previous frame is still in the hardware.
+         */
         if (inputUseBuffer->remainDataLen == 0) {
-            if(flagEOF == OMX_FALSE)
+            if ((flagEOF == OMX_FALSE) || (bConverted == OMX_TRUE))
                 SEC_InputBufferReturn(pOMXComponent);
         } else {
             inputUseBuffer->dataValid = OMX_TRUE;
@@ -844,6 +879,7 @@ OMX_BOOL SEC_Postprocess_OutputData(OMX_COMPONENTTYPE *pOMXComponent)
     SEC_OMX_DATABUFFER    *outputUseBuffer = &pSECComponent->secDataBuffer[OUTPUT_PORT_INDEX];
     SEC_OMX_DATA          *outputData = &pSECComponent->processData[OUTPUT_PORT_INDEX];
     OMX_U32                copySize = 0;
+    OMX_U32                sliceSize = 0;
 
     if (outputUseBuffer->dataValid == OMX_TRUE) {
         if (pSECComponent->checkTimeStamp.needCheckStartTimeStamp == OMX_TRUE) {
@@ -865,9 +901,36 @@ OMX_BOOL SEC_Postprocess_OutputData(OMX_COMPONENTTYPE *pOMXComponent)
             goto EXIT;
         }
 
-        if (outputData->remainDataLen <= (outputUseBuffer->allocSize - outputUseBuffer->dataLen)) {
+        sliceSize = outputData->remainDataLen;
+        if ((pSECComponent->sec_checkOutputSlice != NULL) && (outputData->remainDataLen > 0) &&
+            !(outputData->nFlags & OMX_BUFFERFLAG_CODECCONFIG))
+            sliceSize = pSECComponent->sec_checkOutputSlice(pOMXComponent,
+                            outputData->dataBuffer + outputData->usedDataLen, outputData->remainDataLen);
+
+        if ((sliceSize > 0) && (sliceSize < outputData->remainDataLen) &&
+            (sliceSize <= (outputUseBuffer->allocSize - outputUseBuffer->dataLen))) {
+            /* one slice per buffer, the last one of the frame carries ENDOFFRAME */
+            copySize = sliceSize;
+            SEC_OSAL_Memcpy((outputUseBuffer->bufferHeader->pBuffer + outputUseBuffer->dataLen),
+                    (outputData->dataBuffer + outputData->usedDataLen),
+                     copySize);
+
+            outputUseBuffer->dataLen += copySize;
+            outputUseBuffer->remainDataLen += copySize;
+            outputUseBuffer->nFlags = outputData->nFlags & ~(OMX_BUFFERFLAG_ENDOFFRAME | OMX_BUFFERFLAG_EOS);
+            outputUseBuffer->timeStamp = outputData->timeStamp;
+
+            ret = OMX_FALSE;
+
+            outputData->remainDataLen -= copySize;
+            outputData->usedDataLen += copySize;
+
+            SEC_OutputBufferReturn(pOMXComponent);
+        } else if (outputData->remainDataLen <= (outputUseBuffer->allocSize - outputUseBuffer->dataLen)) {
             copySize = outputData->remainDataLen;
-            if (copySize > 0)
+            /* the encoder may already have written the stream in place */
+            if ((copySize > 0) &&
+                ((outputData->dataBuffer + outputData->usedDataLen) != (outputUseBuffer->bufferHeader->pBuffer + outputUseBuffer->dataLen)))
                 SEC_OSAL_Memcpy((outputUseBuffer->bufferHeader->pBuffer + outputUseBuffer->dataLen),
                     (outputData->dataBuffer + outputData->usedDataLen),
                      copySize);
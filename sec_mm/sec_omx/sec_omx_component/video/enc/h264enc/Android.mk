@@ -27,4 +27,6 @@ LOCAL_C_INCLUDES := $(SEC_OMX_INC)/khronos \
 
 LOCAL_C_INCLUDES += $(SEC_OMX_TOP)/sec_codecs/video/mfc_c110/include
 
+SEC_OMX_REGISTRY_LIBS += $(LOCAL_MODULE):$(LOCAL_PATH)/library_register.h
+
 include $(BUILD_SHARED_LIBRARY)
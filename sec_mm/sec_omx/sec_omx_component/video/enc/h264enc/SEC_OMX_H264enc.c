@@ -146,6 +146,35 @@ OMX_U8 *FindDelimiter(OMX_U8 *pBuffer, OMX_U32 size)
     return NULL;
 }
 
+/* Size of the first slice NAL in the stream, with any non-VCL NALs before it */
+OMX_U32 SEC_MFC_H264Enc_CheckOutputSlice(OMX_COMPONENTTYPE *pOMXComponent, OMX_U8 *pOutputStream, OMX_U32 streamSize)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_H264ENC_HANDLE    *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_U8                *pNal = pOutputStream;
+    OMX_U8                *pNext = NULL;
+    OMX_U32                nalType = 0;
+    OMX_U32                remainSize = 0;
+
+    if (pH264Enc->hMFCH264Handle.sliceOutput.bEnable != OMX_TRUE)
+        return streamSize;
+
+    while (1) {
+        remainSize = streamSize - (OMX_U32)(pNal + 4 - pOutputStream);
+        if ((OMX_S32)remainSize < 5)
+            return streamSize;
+
+        nalType = pNal[4] & 0x1F;
+        pNext = FindDelimiter(pNal + 4, remainSize);
+        if (pNext == NULL)
+            return streamSize;
+        /* coded slice, IDR or not, ends the unit */
+        if ((nalType == 1) || (nalType == 5))
+            return (OMX_U32)(pNext - pOutputStream);
+        pNal = pNext;
+    }
+}
+
 void H264PrintParams(SSBSIP_MFC_ENC_H264_PARAM h264Arg)
 {
     SEC_OSAL_Log(SEC_LOG_TRACE, "SourceWidth             : %d\n", h264Arg.SourceWidth);
@@ -231,6 +260,16 @@ void Set_H264ENC_Param(SSBSIP_MFC_ENC_H264_PARAM *pH264Arg, SEC_OMX_BASECOMPONEN
     pH264Arg->StaticDisable   = 1;
     pH264Arg->ActivityDisable = 1;
 
+    if (pH264Enc->hMFCH264Handle.sliceOutput.bEnable == OMX_TRUE) {
+        if (pH264Enc->hMFCH264Handle.sliceOutput.nSliceMBs > 0) {
+            pH264Arg->SliceMode     = 1;    // 1: MB count per slice
+            pH264Arg->SliceArgument = pH264Enc->hMFCH264Handle.sliceOutput.nSliceMBs;
+        } else {
+            pH264Arg->SliceMode     = 2;    // 2: bytes per slice
+            pH264Arg->SliceArgument = pH264Enc->hMFCH264Handle.sliceOutput.nSliceBytes;
+        }
+    }
+
     switch ((SEC_OMX_COLOR_FORMATTYPE)pSECInputPort->portDefinition.format.video.eColorFormat) {
     case OMX_COLOR_FormatYUV420SemiPlanar:
         pH264Arg->FrameMap = NV12_LINEAR;
@@ -421,6 +460,27 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_GetParameter(
         pDstErrorCorrectionType->bEnableRVLC = pSrcErrorCorrectionType->bEnableRVLC;
     }
         break;
+    case OMX_IndexVendorSliceOutput:
+    {
+        SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE *pSliceOutput = (SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE *)pComponentParameterStructure;
+        SEC_H264ENC_HANDLE                  *pH264Enc = NULL;
+
+        ret = SEC_OMX_Check_SizeVersion(pSliceOutput, sizeof(SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE));
+        if (ret != OMX_ErrorNone) {
+            goto EXIT;
+        }
+
+        if (pSliceOutput->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+
+        pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+        pSliceOutput->bEnable = pH264Enc->hMFCH264Handle.sliceOutput.bEnable;
+        pSliceOutput->nSliceMBs = pH264Enc->hMFCH264Handle.sliceOutput.nSliceMBs;
+        pSliceOutput->nSliceBytes = pH264Enc->hMFCH264Handle.sliceOutput.nSliceBytes;
+    }
+        break;
     default:
         ret = SEC_OMX_VideoEncodeGetParameter(hComponent, nParamIndex, pComponentParameterStructure);
         break;
@@ -556,6 +616,39 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_SetParameter(
         pDstErrorCorrectionType->bEnableRVLC = pSrcErrorCorrectionType->bEnableRVLC;
     }
         break;
+    case OMX_IndexVendorSliceOutput:
+    {
+        SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE *pSliceOutput = (SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE *)pComponentParameterStructure;
+        SEC_H264ENC_HANDLE                  *pH264Enc = NULL;
+
+        ret = SEC_OMX_Check_SizeVersion(pSliceOutput, sizeof(SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE));
+        if (ret != OMX_ErrorNone) {
+            goto EXIT;
+        }
+
+        if (pSliceOutput->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+
+        if ((pSliceOutput->bEnable == OMX_TRUE) &&
+            (pSliceOutput->nSliceMBs == 0) && (pSliceOutput->nSliceBytes == 0)) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        /* the slice mode is fixed once MFC is initialized */
+        pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+        if (pH264Enc->hMFCH264Handle.bConfiguredMFC == OMX_TRUE) {
+            ret = OMX_ErrorIncorrectStateOperation;
+            goto EXIT;
+        }
+
+        pH264Enc->hMFCH264Handle.sliceOutput.bEnable = pSliceOutput->bEnable;
+        pH264Enc->hMFCH264Handle.sliceOutput.nSliceMBs = pSliceOutput->nSliceMBs;
+        pH264Enc->hMFCH264Handle.sliceOutput.nSliceBytes = pSliceOutput->nSliceBytes;
+    }
+        break;
     default:
         ret = SEC_OMX_VideoEncodeSetParameter(hComponent, nIndex, pComponentParameterStructure);
         break;
@@ -574,6 +667,7 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_GetConfig(
     OMX_ERRORTYPE           ret = OMX_ErrorNone;
     OMX_COMPONENTTYPE     *pOMXComponent = NULL;
     SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_H264ENC_HANDLE    *pH264Enc = NULL;
 
     FunctionIn();
 
@@ -602,7 +696,42 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_GetConfig(
         goto EXIT;
     }
 
+    pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+
     switch (nIndex) {
+    case OMX_IndexConfigVideoBitrate:
+    {
+        OMX_VIDEO_CONFIG_BITRATETYPE *pConfigBitrate = (OMX_VIDEO_CONFIG_BITRATETYPE *)pComponentConfigStructure;
+
+        if (pConfigBitrate->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pConfigBitrate->nEncodeBitrate = pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate;
+    }
+        break;
+    case OMX_IndexConfigVideoFramerate:
+    {
+        OMX_CONFIG_FRAMERATETYPE *pConfigFramerate = (OMX_CONFIG_FRAMERATETYPE *)pComponentConfigStructure;
+
+        if (pConfigFramerate->nPortIndex >= ALL_PORT_NUM) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pConfigFramerate->xEncodeFramerate = pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate;
+    }
+        break;
+    case OMX_IndexConfigVideoIntraVOPRefresh:
+    {
+        OMX_CONFIG_INTRAREFRESHVOPTYPE *pIntraRefresh = (OMX_CONFIG_INTRAREFRESHVOPTYPE *)pComponentConfigStructure;
+
+        if (pIntraRefresh->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pIntraRefresh->IntraRefreshVOP = pH264Enc->hMFCH264Handle.bIntraRefresh;
+    }
+        break;
     default:
         ret = SEC_OMX_GetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -622,6 +751,7 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_SetConfig(
     OMX_ERRORTYPE          ret = OMX_ErrorNone;
     OMX_COMPONENTTYPE     *pOMXComponent = NULL;
     SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_H264ENC_HANDLE    *pH264Enc = NULL;
 
     FunctionIn();
 
@@ -645,7 +775,56 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_SetConfig(
         goto EXIT;
     }
 
+    pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+
     switch (nIndex) {
+    case OMX_IndexConfigVideoBitrate:
+    {
+        OMX_VIDEO_CONFIG_BITRATETYPE *pConfigBitrate = (OMX_VIDEO_CONFIG_BITRATETYPE *)pComponentConfigStructure;
+
+        if (pConfigBitrate->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        if (pConfigBitrate->nEncodeBitrate == 0) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate = pConfigBitrate->nEncodeBitrate;
+        pH264Enc->hMFCH264Handle.bBitrateChanged = OMX_TRUE;
+    }
+        break;
+    case OMX_IndexConfigVideoFramerate:
+    {
+        OMX_CONFIG_FRAMERATETYPE *pConfigFramerate = (OMX_CONFIG_FRAMERATETYPE *)pComponentConfigStructure;
+
+        if (pConfigFramerate->nPortIndex >= ALL_PORT_NUM) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        if ((pConfigFramerate->xEncodeFramerate >> 16) == 0) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        /* the encoder takes its rate from the input port, see Set_*_Param */
+        pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate = pConfigFramerate->xEncodeFramerate;
+        pH264Enc->hMFCH264Handle.bFramerateChanged = OMX_TRUE;
+    }
+        break;
+    case OMX_IndexConfigVideoIntraVOPRefresh:
+    {
+        OMX_CONFIG_INTRAREFRESHVOPTYPE *pIntraRefresh = (OMX_CONFIG_INTRAREFRESHVOPTYPE *)pComponentConfigStructure;
+
+        if (pIntraRefresh->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+
+        pH264Enc->hMFCH264Handle.bIntraRefresh = pIntraRefresh->IntraRefreshVOP;
+    }
+        break;
     default:
         ret = SEC_OMX_SetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -697,12 +876,14 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_GetExtensionIndex(
     if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_STORE_METADATA_BUFFER) == 0) {
         *pIndexType = OMX_IndexParamStoreMetaDataBuffer;
         ret = OMX_ErrorNone;
+    } else
+#endif
+    if (SEC_OSAL_Strcmp(cParameterName, SEC_INDEX_PARAM_SLICE_OUTPUT) == 0) {
+        *pIndexType = OMX_IndexVendorSliceOutput;
+        ret = OMX_ErrorNone;
     } else {
         ret = SEC_OMX_GetExtensionIndex(hComponent, cParameterName, pIndexType);
     }
-#else
-    ret = SEC_OMX_GetExtensionIndex(hComponent, cParameterName, pIndexType);
-#endif
 
 EXIT:
     FunctionOut();
@@ -756,7 +937,9 @@ OMX_ERRORTYPE SEC_MFC_EncodeThread(OMX_HANDLETYPE hComponent)
         SEC_OSAL_SemaphoreWait(pH264Enc->NBEncThread.hEncFrameStart);
 
         if (pH264Enc->NBEncThread.bExitEncodeThread == OMX_FALSE) {
+            OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
             pH264Enc->hMFCH264Handle.returnCodec = SsbSipMfcEncExe(pH264Enc->hMFCH264Handle.hMFCHandle);
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CODEC, nStartUs);
             SEC_OSAL_SemaphorePost(pH264Enc->NBEncThread.hEncFrameEnd);
         }
     }
@@ -768,6 +951,148 @@ EXIT:
     return ret;
 }
 
+static OMX_PTR SEC_MFC_H264Enc_Open(SEC_H264ENC_HANDLE *pH264Enc)
+{
+    SSBIP_MFC_BUFFER_TYPE buf_type = CACHE;
+
+    /* MFC(Multi Function Codec) encoder and CMM(Codec Memory Management) driver open */
+    if (pH264Enc->hMFCH264Handle.hMFCHandle == NULL)
+        pH264Enc->hMFCH264Handle.hMFCHandle = (OMX_PTR)SsbSipMfcEncOpen(&buf_type);
+
+    return pH264Enc->hMFCH264Handle.hMFCHandle;
+}
+
+/* Output buffers in MFC memory, MFC encodes straight into them */
+OMX_ERRORTYPE SEC_MFC_H264Enc_AllocateStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nSize, OMX_PTR *ppVirAddr, OMX_PTR *ppPhyAddr)
+{
+    OMX_ERRORTYPE          ret = OMX_ErrorNone;
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_BASEPORT      *pSECOutputPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+    SEC_H264ENC_HANDLE    *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_PTR                hMFCHandle = NULL;
+
+    FunctionIn();
+
+    /* Buffers are allocated before SEC_MFC_H264Enc_Init, so open MFC here */
+    hMFCHandle = SEC_MFC_H264Enc_Open(pH264Enc);
+    if (hMFCHandle == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+
+    if (SsbSipMfcEncSetSize(hMFCHandle, H264_ENC,
+                            pSECOutputPort->portDefinition.format.video.nFrameWidth,
+                            pSECOutputPort->portDefinition.format.video.nFrameHeight) != MFC_RET_OK) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    *ppVirAddr = SsbSipMfcEncAllocOutBuf(hMFCHandle, ppPhyAddr, nSize);
+    if (*ppVirAddr == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+
+EXIT:
+    FunctionOut();
+
+    return ret;
+}
+
+OMX_ERRORTYPE SEC_MFC_H264Enc_FreeStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent, OMX_PTR pVirAddr)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_H264ENC_HANDLE    *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+
+    /* Once MFC is closed its memory is already gone */
+    if ((pH264Enc != NULL) && (pH264Enc->hMFCH264Handle.hMFCHandle != NULL))
+        SsbSipMfcEncFreeOutBuf(pH264Enc->hMFCH264Handle.hMFCHandle, pVirAddr);
+
+    return OMX_ErrorNone;
+}
+
+/* Gives back the output buffer MFC holds, called when the output port is flushed */
+OMX_ERRORTYPE SEC_MFC_H264Enc_ReleaseStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_H264ENC_HANDLE    *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_BUFFERHEADERTYPE  *pBufferHeader = NULL;
+
+    FunctionIn();
+
+    if ((pH264Enc == NULL) || (pH264Enc->pStreamBuffer == NULL))
+        goto EXIT;
+
+    /* the frame still being encoded is dropped along with the flush */
+    if (pH264Enc->NBEncThread.bEncoderRun != OMX_FALSE) {
+        SEC_OSAL_SemaphoreWait(pH264Enc->NBEncThread.hEncFrameEnd);
+        pH264Enc->NBEncThread.bEncoderRun = OMX_FALSE;
+        pH264Enc->bFirstFrame = OMX_TRUE;
+        SEC_OSAL_Log(SEC_LOG_WARNING, "%s: frame in MFC dropped by the flush", __FUNCTION__);
+        SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
+    }
+    SsbSipMfcEncSetOutBuf(pH264Enc->hMFCH264Handle.hMFCHandle, NULL, NULL, 0);
+
+    pBufferHeader = pH264Enc->pStreamBuffer;
+    pH264Enc->pStreamBuffer = NULL;
+
+    pBufferHeader->nFilledLen = 0;
+    pBufferHeader->nOffset = 0;
+    pBufferHeader->nFlags = 0;
+    SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, pBufferHeader);
+
+EXIT:
+    FunctionOut();
+
+    return OMX_ErrorNone;
+}
+
+/*
+ * Picks the stream buffer for the next MFC run. A client buffer from MFC
+ * memory is kept by the component while MFC writes into it and the one kept
+ * for the previous run, which now holds that frame, is handed to
+ * SEC_Postprocess_OutputData in its place, so no copy is needed.
+ */
+static void SEC_MFC_H264Enc_SetStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_H264ENC_HANDLE    *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+    SEC_OMX_DATABUFFER    *outputUseBuffer = &pSECComponent->secDataBuffer[OUTPUT_PORT_INDEX];
+    OMX_BUFFERHEADERTYPE  *pBufferHeader = outputUseBuffer->bufferHeader;
+
+    /* slices are split over several buffers, so they are always copied */
+    if ((outputUseBuffer->dataValid != OMX_TRUE) || (pBufferHeader == NULL) ||
+        (outputUseBuffer->dataLen != 0) || (pH264Enc->hMFCH264Handle.sliceOutput.bEnable == OMX_TRUE)) {
+        /* the kept buffer holds the frame not delivered yet, MFC must not reuse it */
+        if (pH264Enc->pStreamBuffer != NULL)
+            SsbSipMfcEncSetOutBuf(pH264Enc->hMFCH264Handle.hMFCHandle, NULL, NULL, 0);
+        return;
+    }
+
+    if (pBufferHeader->pPlatformPrivate != NULL) {
+        if (pH264Enc->pStreamBuffer != NULL)
+            outputUseBuffer->bufferHeader = pH264Enc->pStreamBuffer;
+        else
+            pSECComponent->sec_BufferReset(pOMXComponent, OUTPUT_PORT_INDEX);
+
+        pH264Enc->pStreamBuffer = pBufferHeader;
+        SsbSipMfcEncSetOutBuf(pH264Enc->hMFCH264Handle.hMFCHandle, pBufferHeader->pPlatformPrivate,
+                              pBufferHeader->pBuffer, pBufferHeader->nAllocLen);
+    } else {
+        /* client memory, back to the MFC stream buffer and a copy */
+        SsbSipMfcEncSetOutBuf(pH264Enc->hMFCH264Handle.hMFCHandle, NULL, NULL, 0);
+        if (pH264Enc->pStreamBuffer != NULL) {
+            outputUseBuffer->bufferHeader = pH264Enc->pStreamBuffer;
+            pH264Enc->pStreamBuffer = NULL;
+
+            pBufferHeader->nFilledLen = 0;
+            pBufferHeader->nOffset = 0;
+            pBufferHeader->nFlags = 0;
+            SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, pBufferHeader);
+        }
+    }
+}
+
 /* MFC Init */
 OMX_ERRORTYPE SEC_MFC_H264Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
 {
@@ -786,14 +1111,12 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
     pSECComponent->bUseFlagEOF = OMX_FALSE;
     pSECComponent->bSaveFlagEOS = OMX_FALSE;
 
-    /* MFC(Multi Function Codec) encoder and CMM(Codec Memory Management) driver open */
-    SSBIP_MFC_BUFFER_TYPE buf_type = CACHE;
-    hMFCHandle = (OMX_PTR)SsbSipMfcEncOpen(&buf_type);
+    /* Already open when the output buffers came from MFC memory */
+    hMFCHandle = SEC_MFC_H264Enc_Open(pH264Enc);
     if (hMFCHandle == NULL) {
         ret = OMX_ErrorInsufficientResources;
         goto EXIT;
     }
-    pH264Enc->hMFCH264Handle.hMFCHandle = hMFCHandle;
 
     SsbSipMfcEncSetSize(hMFCHandle, H264_ENC,
                         pSECOutputPort->portDefinition.format.video.nFrameWidth,
@@ -841,6 +1164,7 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
 
     pH264Enc->indexInputBuffer = 0;
     pH264Enc->bFirstFrame = OMX_TRUE;
+    pH264Enc->pStreamBuffer = NULL;
 
     pH264Enc->NBEncThread.bExitEncodeThread = OMX_FALSE;
     pH264Enc->NBEncThread.bEncoderRun = OMX_FALSE;
@@ -896,6 +1220,7 @@ OMX_ERRORTYPE SEC_MFC_H264Enc_Terminate(OMX_COMPONENTTYPE *pOMXComponent)
         SsbSipMfcEncClose(hMFCHandle);
         hMFCHandle = pH264Enc->hMFCH264Handle.hMFCHandle = NULL;
     }
+    pH264Enc->pStreamBuffer = NULL;
 
 EXIT:
     FunctionOut();
@@ -903,6 +1228,35 @@ EXIT:
     return ret;
 }
 
+/* Pushes rate and intra refresh changes from SetConfig to MFC while it is idle */
+static void SEC_MFC_H264Enc_ApplyConfig(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    SEC_H264ENC_HANDLE *pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_HANDLETYPE hMFCHandle = pH264Enc->hMFCH264Handle.hMFCHandle;
+    int setConfVal = 0;
+
+    if (pH264Enc->hMFCH264Handle.bBitrateChanged == OMX_TRUE) {
+        setConfVal = pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_CHANGE_BIT_RATE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: bitrate change to %d failed", __FUNCTION__, setConfVal);
+        pH264Enc->hMFCH264Handle.bBitrateChanged = OMX_FALSE;
+    }
+
+    if (pH264Enc->hMFCH264Handle.bFramerateChanged == OMX_TRUE) {
+        setConfVal = (pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate) >> 16;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_CHANGE_FRAME_RATE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: frame rate change to %d failed", __FUNCTION__, setConfVal);
+        pH264Enc->hMFCH264Handle.bFramerateChanged = OMX_FALSE;
+    }
+
+    if (pH264Enc->hMFCH264Handle.bIntraRefresh == OMX_TRUE) {
+        setConfVal = I_FRAME;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_FRAME_TYPE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: forcing I frame failed", __FUNCTION__);
+        pH264Enc->hMFCH264Handle.bIntraRefresh = OMX_FALSE;
+    }
+}
+
 OMX_ERRORTYPE SEC_MFC_H264_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA *pInputData, SEC_OMX_DATA *pOutputData)
 {
     OMX_ERRORTYPE              ret = OMX_ErrorNone;
@@ -955,6 +1309,10 @@ OMX_ERRORTYPE SEC_MFC_H264_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
         pOutputData->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
 
         pH264Enc->hMFCH264Handle.bConfiguredMFC = OMX_TRUE;
+        /* SsbSipMfcEncInit took the current port settings */
+        pH264Enc->hMFCH264Handle.bBitrateChanged = OMX_FALSE;
+        pH264Enc->hMFCH264Handle.bFramerateChanged = OMX_FALSE;
+        pH264Enc->hMFCH264Handle.bIntraRefresh = OMX_FALSE;
 
         ret = OMX_ErrorInputDataEncodeYet;
         goto EXIT;
@@ -1059,9 +1417,13 @@ OMX_ERRORTYPE SEC_MFC_H264_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
     }
     if (pH264Enc->hMFCH264Handle.returnCodec != MFC_RET_OK) {
         SEC_OSAL_Log(SEC_LOG_ERROR, "In %s : SsbSipMfcEncExe Failed!!!\n", __func__);
+        SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
         ret = OMX_ErrorUndefined;
     }
 
+    if (pH264Enc->NBEncThread.bEncoderRun == OMX_FALSE)
+        SEC_MFC_H264Enc_ApplyConfig(pSECComponent);
+
     pH264Enc->hMFCH264Handle.returnCodec = SsbSipMfcEncSetInBuf(pH264Enc->hMFCH264Handle.hMFCHandle, pInputInfo);
     if (pH264Enc->hMFCH264Handle.returnCodec != MFC_RET_OK) {
         SEC_OSAL_Log(SEC_LOG_TRACE, "Error : SsbSipMfcEncSetInBuf() \n");
@@ -1078,6 +1440,7 @@ OMX_ERRORTYPE SEC_MFC_H264_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA
         pSECComponent->processData[INPUT_PORT_INDEX].specificBufferHeader.CSize = pH264Enc->MFCEncInputBuffer[pH264Enc->indexInputBuffer].CBufferSize;
     }
 
+    SEC_MFC_H264Enc_SetStreamBuffer(pOMXComponent);
     SsbSipMfcEncSetConfig(pH264Enc->hMFCH264Handle.hMFCHandle, MFC_ENC_SETCONF_FRAME_TAG, &(pH264Enc->hMFCH264Handle.indexTimestamp));
 
     /* mfc encode start */
@@ -1244,6 +1607,9 @@ OSCL_EXPORT_REF OMX_ERRORTYPE SEC_OMX_ComponentInit(OMX_HANDLETYPE hComponent, O
         pH264Enc->AVCComponent[i].eProfile   = OMX_VIDEO_AVCProfileBaseline;
         pH264Enc->AVCComponent[i].eLevel     = OMX_VIDEO_AVCLevel31;
     }
+    INIT_SET_SIZE_VERSION(&pH264Enc->hMFCH264Handle.sliceOutput, SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE);
+    pH264Enc->hMFCH264Handle.sliceOutput.nPortIndex = OUTPUT_PORT_INDEX;
+    pH264Enc->hMFCH264Handle.sliceOutput.bEnable    = OMX_FALSE;
 
     pOMXComponent->GetParameter      = &SEC_MFC_H264Enc_GetParameter;
     pOMXComponent->SetParameter      = &SEC_MFC_H264Enc_SetParameter;
@@ -1256,7 +1622,11 @@ OSCL_EXPORT_REF OMX_ERRORTYPE SEC_OMX_ComponentInit(OMX_HANDLETYPE hComponent, O
     pSECComponent->sec_mfc_componentInit      = &SEC_MFC_H264Enc_Init;
     pSECComponent->sec_mfc_componentTerminate = &SEC_MFC_H264Enc_Terminate;
     pSECComponent->sec_mfc_bufferProcess      = &SEC_MFC_H264Enc_bufferProcess;
+    pSECComponent->sec_mfc_allocateStreamBuffer = &SEC_MFC_H264Enc_AllocateStreamBuffer;
+    pSECComponent->sec_mfc_freeStreamBuffer     = &SEC_MFC_H264Enc_FreeStreamBuffer;
+    pSECComponent->sec_mfc_releaseStreamBuffer  = &SEC_MFC_H264Enc_ReleaseStreamBuffer;
     pSECComponent->sec_checkInputFrame        = NULL;
+    pSECComponent->sec_checkOutputSlice       = &SEC_MFC_H264Enc_CheckOutputSlice;
 
     pSECComponent->currentState = OMX_StateLoaded;
 
@@ -1289,6 +1659,11 @@ OMX_ERRORTYPE SEC_OMX_ComponentDeinit(OMX_HANDLETYPE hComponent)
 
     pH264Enc = (SEC_H264ENC_HANDLE *)pSECComponent->hCodecHandle;
     if (pH264Enc != NULL) {
+        /* opened for output buffers but never initialized */
+        if (pH264Enc->hMFCH264Handle.hMFCHandle != NULL) {
+            SsbSipMfcEncClose(pH264Enc->hMFCH264Handle.hMFCHandle);
+            pH264Enc->hMFCH264Handle.hMFCHandle = NULL;
+        }
         SEC_OSAL_Free(pH264Enc);
         pH264Enc = pSECComponent->hCodecHandle = NULL;
     }
@@ -51,6 +51,14 @@ typedef struct _SEC_MFC_H264ENC_HANDLE
     OMX_BOOL bConfiguredMFC;
     EXTRA_DATA headerData;
     OMX_S32 returnCodec;
+
+    /* runtime changes, applied before the next frame is queued to MFC */
+    OMX_BOOL bBitrateChanged;
+    OMX_BOOL bFramerateChanged;
+    OMX_BOOL bIntraRefresh;
+
+    /* OMX.SEC.index.SliceOutput, taken by SsbSipMfcEncInit */
+    SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE sliceOutput;
 } SEC_MFC_H264ENC_HANDLE;
 
 typedef struct _SEC_H264ENC_HANDLE
@@ -67,6 +75,9 @@ typedef struct _SEC_H264ENC_HANDLE
     OMX_BOOL bFirstFrame;
     MFC_ENC_INPUT_BUFFER MFCEncInputBuffer[MFC_INPUT_BUFFER_NUM_MAX];
     OMX_U32  indexInputBuffer;
+
+    /* Output buffer MFC is encoding into, owned by the component until collected */
+    OMX_BUFFERHEADERTYPE *pStreamBuffer;
 } SEC_H264ENC_HANDLE;
 
 #ifdef __cplusplus
@@ -720,6 +720,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_GetConfig(
     OMX_ERRORTYPE           ret = OMX_ErrorNone;
     OMX_COMPONENTTYPE     *pOMXComponent = NULL;
     SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = NULL;
 
     FunctionIn();
 
@@ -748,7 +749,42 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_GetConfig(
         goto EXIT;
     }
 
+    pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+
     switch (nIndex) {
+    case OMX_IndexConfigVideoBitrate:
+    {
+        OMX_VIDEO_CONFIG_BITRATETYPE *pConfigBitrate = (OMX_VIDEO_CONFIG_BITRATETYPE *)pComponentConfigStructure;
+
+        if (pConfigBitrate->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pConfigBitrate->nEncodeBitrate = pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate;
+    }
+        break;
+    case OMX_IndexConfigVideoFramerate:
+    {
+        OMX_CONFIG_FRAMERATETYPE *pConfigFramerate = (OMX_CONFIG_FRAMERATETYPE *)pComponentConfigStructure;
+
+        if (pConfigFramerate->nPortIndex >= ALL_PORT_NUM) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pConfigFramerate->xEncodeFramerate = pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate;
+    }
+        break;
+    case OMX_IndexConfigVideoIntraVOPRefresh:
+    {
+        OMX_CONFIG_INTRAREFRESHVOPTYPE *pIntraRefresh = (OMX_CONFIG_INTRAREFRESHVOPTYPE *)pComponentConfigStructure;
+
+        if (pIntraRefresh->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        pIntraRefresh->IntraRefreshVOP = pMpeg4Enc->hMFCMpeg4Handle.bIntraRefresh;
+    }
+        break;
     default:
         ret = SEC_OMX_GetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -768,6 +804,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_SetConfig(
     OMX_ERRORTYPE           ret = OMX_ErrorNone;
     OMX_COMPONENTTYPE     *pOMXComponent = NULL;
     SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = NULL;
 
     FunctionIn();
 
@@ -791,7 +828,56 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_SetConfig(
         goto EXIT;
     }
 
+    pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+
     switch (nIndex) {
+    case OMX_IndexConfigVideoBitrate:
+    {
+        OMX_VIDEO_CONFIG_BITRATETYPE *pConfigBitrate = (OMX_VIDEO_CONFIG_BITRATETYPE *)pComponentConfigStructure;
+
+        if (pConfigBitrate->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        if (pConfigBitrate->nEncodeBitrate == 0) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate = pConfigBitrate->nEncodeBitrate;
+        pMpeg4Enc->hMFCMpeg4Handle.bBitrateChanged = OMX_TRUE;
+    }
+        break;
+    case OMX_IndexConfigVideoFramerate:
+    {
+        OMX_CONFIG_FRAMERATETYPE *pConfigFramerate = (OMX_CONFIG_FRAMERATETYPE *)pComponentConfigStructure;
+
+        if (pConfigFramerate->nPortIndex >= ALL_PORT_NUM) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+        if ((pConfigFramerate->xEncodeFramerate >> 16) == 0) {
+            ret = OMX_ErrorBadParameter;
+            goto EXIT;
+        }
+
+        /* the encoder takes its rate from the input port, see Set_*_Param */
+        pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate = pConfigFramerate->xEncodeFramerate;
+        pMpeg4Enc->hMFCMpeg4Handle.bFramerateChanged = OMX_TRUE;
+    }
+        break;
+    case OMX_IndexConfigVideoIntraVOPRefresh:
+    {
+        OMX_CONFIG_INTRAREFRESHVOPTYPE *pIntraRefresh = (OMX_CONFIG_INTRAREFRESHVOPTYPE *)pComponentConfigStructure;
+
+        if (pIntraRefresh->nPortIndex != OUTPUT_PORT_INDEX) {
+            ret = OMX_ErrorBadPortIndex;
+            goto EXIT;
+        }
+
+        pMpeg4Enc->hMFCMpeg4Handle.bIntraRefresh = pIntraRefresh->IntraRefreshVOP;
+    }
+        break;
     default:
         ret = SEC_OMX_SetConfig(hComponent, nIndex, pComponentConfigStructure);
         break;
@@ -925,7 +1011,9 @@ OMX_ERRORTYPE SEC_MFC_EncodeThread(OMX_HANDLETYPE hComponent)
         SEC_OSAL_SemaphoreWait(pMpeg4Enc->NBEncThread.hEncFrameStart);
 
         if (pMpeg4Enc->NBEncThread.bExitEncodeThread == OMX_FALSE) {
+            OMX_U64 nStartUs = SEC_OMX_PerfTimerStart();
             pMpeg4Enc->hMFCMpeg4Handle.returnCodec = SsbSipMfcEncExe(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle);
+            SEC_OMX_PerfTimerStop(pSECComponent, SEC_OMX_PERF_TIMER_CODEC, nStartUs);
             SEC_OSAL_SemaphorePost(pMpeg4Enc->NBEncThread.hEncFrameEnd);
         }
     }
@@ -937,6 +1025,148 @@ EXIT:
     return ret;
 }
 
+static OMX_PTR SEC_MFC_Mpeg4Enc_Open(SEC_MPEG4ENC_HANDLE *pMpeg4Enc)
+{
+    SSBIP_MFC_BUFFER_TYPE buf_type = CACHE;
+
+    /* MFC(Multi Format Codec) encoder and CMM(Codec Memory Management) driver open */
+    if (pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle == NULL)
+        pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle = (OMX_PTR)SsbSipMfcEncOpen(&buf_type);
+
+    return pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle;
+}
+
+/* Output buffers in MFC memory, MFC encodes straight into them */
+OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_AllocateStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent, OMX_U32 nSize, OMX_PTR *ppVirAddr, OMX_PTR *ppPhyAddr)
+{
+    OMX_ERRORTYPE          ret = OMX_ErrorNone;
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_OMX_BASEPORT      *pSECOutputPort = &pSECComponent->pSECPort[OUTPUT_PORT_INDEX];
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_PTR                hMFCHandle = NULL;
+
+    FunctionIn();
+
+    /* Buffers are allocated before SEC_MFC_Mpeg4Enc_Init, so open MFC here */
+    hMFCHandle = SEC_MFC_Mpeg4Enc_Open(pMpeg4Enc);
+    if (hMFCHandle == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+
+    if (SsbSipMfcEncSetSize(hMFCHandle,
+                            (pMpeg4Enc->hMFCMpeg4Handle.codecType == CODEC_TYPE_MPEG4) ? MPEG4_ENC : H263_ENC,
+                            pSECOutputPort->portDefinition.format.video.nFrameWidth,
+                            pSECOutputPort->portDefinition.format.video.nFrameHeight) != MFC_RET_OK) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    *ppVirAddr = SsbSipMfcEncAllocOutBuf(hMFCHandle, ppPhyAddr, nSize);
+    if (*ppVirAddr == NULL) {
+        ret = OMX_ErrorInsufficientResources;
+        goto EXIT;
+    }
+
+EXIT:
+    FunctionOut();
+
+    return ret;
+}
+
+OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_FreeStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent, OMX_PTR pVirAddr)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+
+    /* Once MFC is closed its memory is already gone */
+    if ((pMpeg4Enc != NULL) && (pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle != NULL))
+        SsbSipMfcEncFreeOutBuf(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle, pVirAddr);
+
+    return OMX_ErrorNone;
+}
+
+/* Gives back the output buffer MFC holds, called when the output port is flushed */
+OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_ReleaseStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_BUFFERHEADERTYPE  *pBufferHeader = NULL;
+
+    FunctionIn();
+
+    if ((pMpeg4Enc == NULL) || (pMpeg4Enc->pStreamBuffer == NULL))
+        goto EXIT;
+
+    /* the frame still being encoded is dropped along with the flush */
+    if (pMpeg4Enc->NBEncThread.bEncoderRun != OMX_FALSE) {
+        SEC_OSAL_SemaphoreWait(pMpeg4Enc->NBEncThread.hEncFrameEnd);
+        pMpeg4Enc->NBEncThread.bEncoderRun = OMX_FALSE;
+        pMpeg4Enc->bFirstFrame = OMX_TRUE;
+        SEC_OSAL_Log(SEC_LOG_WARNING, "%s: frame in MFC dropped by the flush", __FUNCTION__);
+        SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
+    }
+    SsbSipMfcEncSetOutBuf(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle, NULL, NULL, 0);
+
+    pBufferHeader = pMpeg4Enc->pStreamBuffer;
+    pMpeg4Enc->pStreamBuffer = NULL;
+
+    pBufferHeader->nFilledLen = 0;
+    pBufferHeader->nOffset = 0;
+    pBufferHeader->nFlags = 0;
+    SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, pBufferHeader);
+
+EXIT:
+    FunctionOut();
+
+    return OMX_ErrorNone;
+}
+
+/*
+ * Picks the stream buffer for the next MFC run. A client buffer from MFC
+ * memory is kept by the component while MFC writes into it and the one kept
+ * for the previous run, which now holds that frame, is handed to
+ * SEC_Postprocess_OutputData in its place, so no copy is needed.
+ */
+static void SEC_MFC_Mpeg4Enc_SetStreamBuffer(OMX_COMPONENTTYPE *pOMXComponent)
+{
+    SEC_OMX_BASECOMPONENT *pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    SEC_MPEG4ENC_HANDLE   *pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+    SEC_OMX_DATABUFFER    *outputUseBuffer = &pSECComponent->secDataBuffer[OUTPUT_PORT_INDEX];
+    OMX_BUFFERHEADERTYPE  *pBufferHeader = outputUseBuffer->bufferHeader;
+
+    if ((outputUseBuffer->dataValid != OMX_TRUE) || (pBufferHeader == NULL) ||
+        (outputUseBuffer->dataLen != 0)) {
+        /* the kept buffer holds the frame not delivered yet, MFC must not reuse it */
+        if (pMpeg4Enc->pStreamBuffer != NULL)
+            SsbSipMfcEncSetOutBuf(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle, NULL, NULL, 0);
+        return;
+    }
+
+    if (pBufferHeader->pPlatformPrivate != NULL) {
+        if (pMpeg4Enc->pStreamBuffer != NULL)
+            outputUseBuffer->bufferHeader = pMpeg4Enc->pStreamBuffer;
+        else
+            pSECComponent->sec_BufferReset(pOMXComponent, OUTPUT_PORT_INDEX);
+
+        pMpeg4Enc->pStreamBuffer = pBufferHeader;
+        SsbSipMfcEncSetOutBuf(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle, pBufferHeader->pPlatformPrivate,
+                              pBufferHeader->pBuffer, pBufferHeader->nAllocLen);
+    } else {
+        /* client memory, back to the MFC stream buffer and a copy */
+        SsbSipMfcEncSetOutBuf(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle, NULL, NULL, 0);
+        if (pMpeg4Enc->pStreamBuffer != NULL) {
+            outputUseBuffer->bufferHeader = pMpeg4Enc->pStreamBuffer;
+            pMpeg4Enc->pStreamBuffer = NULL;
+
+            pBufferHeader->nFilledLen = 0;
+            pBufferHeader->nOffset = 0;
+            pBufferHeader->nFlags = 0;
+            SEC_OMX_CallbackBufferDone(pOMXComponent, OUTPUT_PORT_INDEX, pBufferHeader);
+        }
+    }
+}
+
 /* MFC Init */
 OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
 {
@@ -956,14 +1186,12 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
     pSECComponent->bUseFlagEOF = OMX_FALSE;
     pSECComponent->bSaveFlagEOS = OMX_FALSE;
 
-    /* MFC(Multi Format Codec) encoder and CMM(Codec Memory Management) driver open */
-    SSBIP_MFC_BUFFER_TYPE buf_type = CACHE;
-    hMFCHandle = (OMX_PTR)SsbSipMfcEncOpen(&buf_type);
+    /* Already open when the output buffers came from MFC memory */
+    hMFCHandle = SEC_MFC_Mpeg4Enc_Open(pMpeg4Enc);
     if (hMFCHandle == NULL) {
         ret = OMX_ErrorInsufficientResources;
         goto EXIT;
     }
-    pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle = hMFCHandle;
 
     /* set MFC ENC VIDEO PARAM and initialize MFC encoder instance */
     if (pMpeg4Enc->hMFCMpeg4Handle.codecType == CODEC_TYPE_MPEG4) {
@@ -1019,6 +1247,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_Init(OMX_COMPONENTTYPE *pOMXComponent)
 
     pMpeg4Enc->indexInputBuffer = 0;
     pMpeg4Enc->bFirstFrame = OMX_TRUE;
+    pMpeg4Enc->pStreamBuffer = NULL;
 
     pMpeg4Enc->NBEncThread.bExitEncodeThread = OMX_FALSE;
     pMpeg4Enc->NBEncThread.bEncoderRun = OMX_FALSE;
@@ -1074,6 +1303,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4Enc_Terminate(OMX_COMPONENTTYPE *pOMXComponent)
         SsbSipMfcEncClose(hMFCHandle);
         pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle = NULL;
     }
+    pMpeg4Enc->pStreamBuffer = NULL;
 
 EXIT:
     FunctionOut();
@@ -1081,6 +1311,35 @@ EXIT:
     return ret;
 }
 
+/* Pushes rate and intra refresh changes from SetConfig to MFC while it is idle */
+static void SEC_MFC_Mpeg4Enc_ApplyConfig(SEC_OMX_BASECOMPONENT *pSECComponent)
+{
+    SEC_MPEG4ENC_HANDLE *pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
+    OMX_HANDLETYPE hMFCHandle = pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle;
+    int setConfVal = 0;
+
+    if (pMpeg4Enc->hMFCMpeg4Handle.bBitrateChanged == OMX_TRUE) {
+        setConfVal = pSECComponent->pSECPort[OUTPUT_PORT_INDEX].portDefinition.format.video.nBitrate;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_CHANGE_BIT_RATE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: bitrate change to %d failed", __FUNCTION__, setConfVal);
+        pMpeg4Enc->hMFCMpeg4Handle.bBitrateChanged = OMX_FALSE;
+    }
+
+    if (pMpeg4Enc->hMFCMpeg4Handle.bFramerateChanged == OMX_TRUE) {
+        setConfVal = (pSECComponent->pSECPort[INPUT_PORT_INDEX].portDefinition.format.video.xFramerate) >> 16;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_CHANGE_FRAME_RATE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: frame rate change to %d failed", __FUNCTION__, setConfVal);
+        pMpeg4Enc->hMFCMpeg4Handle.bFramerateChanged = OMX_FALSE;
+    }
+
+    if (pMpeg4Enc->hMFCMpeg4Handle.bIntraRefresh == OMX_TRUE) {
+        setConfVal = I_FRAME;
+        if (SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_FRAME_TYPE, &setConfVal) != MFC_RET_OK)
+            SEC_OSAL_Log(SEC_LOG_ERROR, "%s: forcing I frame failed", __FUNCTION__);
+        pMpeg4Enc->hMFCMpeg4Handle.bIntraRefresh = OMX_FALSE;
+    }
+}
+
 OMX_ERRORTYPE SEC_MFC_Mpeg4_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DATA *pInputData, SEC_OMX_DATA *pOutputData)
 {
     OMX_ERRORTYPE              ret = OMX_ErrorNone;
@@ -1125,6 +1384,10 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         pOutputData->nFlags |= OMX_BUFFERFLAG_ENDOFFRAME;
 
         pMpeg4Enc->hMFCMpeg4Handle.bConfiguredMFC = OMX_TRUE;
+        /* SsbSipMfcEncInit took the current port settings */
+        pMpeg4Enc->hMFCMpeg4Handle.bBitrateChanged = OMX_FALSE;
+        pMpeg4Enc->hMFCMpeg4Handle.bFramerateChanged = OMX_FALSE;
+        pMpeg4Enc->hMFCMpeg4Handle.bIntraRefresh = OMX_FALSE;
 
         ret = OMX_ErrorInputDataEncodeYet;
         goto EXIT;
@@ -1227,9 +1490,13 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
     }
     if (pMpeg4Enc->hMFCMpeg4Handle.returnCodec != MFC_RET_OK) {
         SEC_OSAL_Log(SEC_LOG_ERROR, "%s: SsbSipMfcEncExe failed, ret:%d", __FUNCTION__, pMpeg4Enc->hMFCMpeg4Handle.returnCodec);
+        SEC_OMX_PerfFrameDone(pSECComponent, OMX_TRUE);
         ret = OMX_ErrorUndefined;
     }
 
+    if (pMpeg4Enc->NBEncThread.bEncoderRun == OMX_FALSE)
+        SEC_MFC_Mpeg4Enc_ApplyConfig(pSECComponent);
+
     pMpeg4Enc->hMFCMpeg4Handle.returnCodec = SsbSipMfcEncSetInBuf(hMFCHandle, pInputInfo);
     if (pMpeg4Enc->hMFCMpeg4Handle.returnCodec != MFC_RET_OK) {
         SEC_OSAL_Log(SEC_LOG_ERROR, "%s: SsbSipMfcEncSetInBuf failed, ret:%d", __FUNCTION__, pMpeg4Enc->hMFCMpeg4Handle.returnCodec);
@@ -1246,6 +1513,7 @@ OMX_ERRORTYPE SEC_MFC_Mpeg4_Encode(OMX_COMPONENTTYPE *pOMXComponent, SEC_OMX_DAT
         pSECComponent->processData[INPUT_PORT_INDEX].specificBufferHeader.CSize = pMpeg4Enc->MFCEncInputBuffer[pMpeg4Enc->indexInputBuffer].CBufferSize;
     }
 
+    SEC_MFC_Mpeg4Enc_SetStreamBuffer(pOMXComponent);
     SsbSipMfcEncSetConfig(hMFCHandle, MFC_ENC_SETCONF_FRAME_TAG, &(pMpeg4Enc->hMFCMpeg4Handle.indexTimestamp));
 
     /* mfc encode start */
@@ -1465,6 +1733,9 @@ OSCL_EXPORT_REF OMX_ERRORTYPE SEC_OMX_ComponentInit(OMX_HANDLETYPE hComponent, O
     pSECComponent->sec_mfc_componentInit      = &SEC_MFC_Mpeg4Enc_Init;
     pSECComponent->sec_mfc_componentTerminate = &SEC_MFC_Mpeg4Enc_Terminate;
     pSECComponent->sec_mfc_bufferProcess      = &SEC_MFC_Mpeg4Enc_bufferProcess;
+    pSECComponent->sec_mfc_allocateStreamBuffer = &SEC_MFC_Mpeg4Enc_AllocateStreamBuffer;
+    pSECComponent->sec_mfc_freeStreamBuffer     = &SEC_MFC_Mpeg4Enc_FreeStreamBuffer;
+    pSECComponent->sec_mfc_releaseStreamBuffer  = &SEC_MFC_Mpeg4Enc_ReleaseStreamBuffer;
     pSECComponent->sec_checkInputFrame        = NULL;
 
     pSECComponent->currentState = OMX_StateLoaded;
@@ -1498,6 +1769,11 @@ OMX_ERRORTYPE SEC_OMX_ComponentDeinit(OMX_HANDLETYPE hComponent)
 
     pMpeg4Enc = (SEC_MPEG4ENC_HANDLE *)pSECComponent->hCodecHandle;
     if (pMpeg4Enc != NULL) {
+        /* opened for output buffers but never initialized */
+        if (pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle != NULL) {
+            SsbSipMfcEncClose(pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle);
+            pMpeg4Enc->hMFCMpeg4Handle.hMFCHandle = NULL;
+        }
         SEC_OSAL_Free(pMpeg4Enc);
         pMpeg4Enc = pSECComponent->hCodecHandle = NULL;
     }
@@ -48,6 +48,11 @@ typedef struct _SEC_MFC_MPEG4ENC_HANDLE
     OMX_BOOL                   bConfiguredMFC;
     CODEC_TYPE                 codecType;
     OMX_S32                    returnCodec;
+
+    /* runtime changes, applied before the next frame is queued to MFC */
+    OMX_BOOL                   bBitrateChanged;
+    OMX_BOOL                   bFramerateChanged;
+    OMX_BOOL                   bIntraRefresh;
 } SEC_MFC_MPEG4ENC_HANDLE;
 
 typedef struct _SEC_MPEG4ENC_HANDLE
@@ -65,6 +70,9 @@ typedef struct _SEC_MPEG4ENC_HANDLE
     OMX_BOOL bFirstFrame;
     MFC_ENC_INPUT_BUFFER MFCEncInputBuffer[MFC_INPUT_BUFFER_NUM_MAX];
     OMX_U32  indexInputBuffer;
+
+    /* Output buffer MFC is encoding into, owned by the component until collected */
+    OMX_BUFFERHEADERTYPE *pStreamBuffer;
 } SEC_MPEG4ENC_HANDLE;
 
 
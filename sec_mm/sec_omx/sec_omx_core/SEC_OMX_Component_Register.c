@@ -47,21 +47,148 @@
 
 #define REGISTRY_FILENAME "secomxregistry"
 
+/*
+ * secomxregistry lines:
+ *   <library> <component name> <role>[,<role>...]
+ * The build generates them from each component's library_register.h, see
+ * secomxregistry.mk. A line holding only <library> is registered by loading
+ * the library and asking it, which costs a dlopen per codec at SEC_OMX_Init.
+ */
+#define REGISTRY_DELIMITER      " \t\r\n"
+#define REGISTRY_ROLE_DELIMITER ","
+
+/* power of two, sized for a load factor below one half */
+#define REGISTRY_NAME_HASH_SIZE 64
+#define REGISTRY_ROLE_HASH_SIZE 512
+
+/* entries are (index + 1), 0 marks an empty slot */
+static OMX_U32 gNameHash[REGISTRY_NAME_HASH_SIZE];
+static OMX_U32 gRoleHash[REGISTRY_ROLE_HASH_SIZE];
+
+
+static OMX_U32 SEC_OMX_Registry_Hash(const char *str)
+{
+    OMX_U32 hash = 5381;
+
+    while (*str)
+        hash = ((hash << 5) + hash) + (unsigned char)(*str++);
+
+    return hash;
+}
+
+static void SEC_OMX_Registry_BuildHash(SEC_OMX_COMPONENT_REGLIST *componentList, OMX_U32 compNum)
+{
+    OMX_U32 i = 0, j = 0, slot = 0;
+
+    SEC_OSAL_Memset(gNameHash, 0, sizeof(gNameHash));
+    SEC_OSAL_Memset(gRoleHash, 0, sizeof(gRoleHash));
+
+    for (i = 0; i < compNum; i++) {
+        slot = SEC_OMX_Registry_Hash((char *)componentList[i].component.componentName) & (REGISTRY_NAME_HASH_SIZE - 1);
+        while (gNameHash[slot] != 0)
+            slot = (slot + 1) & (REGISTRY_NAME_HASH_SIZE - 1);
+        gNameHash[slot] = i + 1;
+
+        for (j = 0; j < componentList[i].component.totalRoleNum; j++) {
+            slot = SEC_OMX_Registry_Hash((char *)componentList[i].component.roles[j]) & (REGISTRY_ROLE_HASH_SIZE - 1);
+            while (gRoleHash[slot] != 0)
+                slot = (slot + 1) & (REGISTRY_ROLE_HASH_SIZE - 1);
+            gRoleHash[slot] = ((i << 8) | j) + 1;
+        }
+    }
+}
+
+static OMX_ERRORTYPE SEC_OMX_Registry_AddManifestEntry(SEC_OMX_COMPONENT_REGLIST *entry, char *libName, char *componentName, char *roles)
+{
+    OMX_ERRORTYPE ret = OMX_ErrorNone;
+    char         *role = NULL;
+    char         *savePtr = NULL;
+
+    if ((SEC_OSAL_Strlen(libName) >= MAX_OMX_COMPONENT_LIBNAME_SIZE) ||
+        (SEC_OSAL_Strlen(componentName) >= MAX_OMX_COMPONENT_NAME_SIZE)) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+
+    SEC_OSAL_Strcpy(entry->libName, libName);
+    SEC_OSAL_Strcpy(entry->component.componentName, componentName);
+    entry->component.totalRoleNum = 0;
+
+    if (roles == NULL)
+        goto EXIT;
+
+    for (role = strtok_r(roles, REGISTRY_ROLE_DELIMITER, &savePtr);
+         (role != NULL) && (entry->component.totalRoleNum < MAX_OMX_COMPONENT_ROLE_NUM);
+         role = strtok_r(NULL, REGISTRY_ROLE_DELIMITER, &savePtr)) {
+        if (SEC_OSAL_Strlen(role) >= MAX_OMX_COMPONENT_ROLE_SIZE)
+            continue;
+        SEC_OSAL_Strcpy(entry->component.roles[entry->component.totalRoleNum], role);
+        entry->component.totalRoleNum++;
+    }
+
+EXIT:
+    return ret;
+}
+
+static int SEC_OMX_Registry_AddLibrary(SEC_OMX_COMPONENT_REGLIST *componentList, int totalCompNum, char *libName)
+{
+    int            componentNum = 0;
+    OMX_HANDLETYPE soHandle;
+    const char    *errorMsg;
+    int (*SEC_OMX_COMPONENT_Library_Register)(SECRegisterComponentType **secComponents);
+    SECRegisterComponentType **secComponentsTemp;
+
+    if ((soHandle = SEC_OSAL_dlopen(libName, RTLD_NOW)) != NULL) {
+        SEC_OSAL_dlerror();    /* clear error*/
+        if ((SEC_OMX_COMPONENT_Library_Register = SEC_OSAL_dlsym(soHandle, "SEC_OMX_COMPONENT_Library_Register")) != NULL) {
+            int i = 0, j = 0;
+
+            componentNum = (*SEC_OMX_COMPONENT_Library_Register)(NULL);
+            secComponentsTemp = (SECRegisterComponentType **)SEC_OSAL_Malloc(sizeof(SECRegisterComponentType*) * componentNum);
+            for (i = 0; i < componentNum; i++) {
+                secComponentsTemp[i] = SEC_OSAL_Malloc(sizeof(SECRegisterComponentType));
+                SEC_OSAL_Memset(secComponentsTemp[i], 0, sizeof(SECRegisterComponentType));
+            }
+            (*SEC_OMX_COMPONENT_Library_Register)(secComponentsTemp);
+
+            for (i = 0; (i < componentNum) && (totalCompNum < MAX_OMX_COMPONENT_NUM); i++) {
+                SEC_OSAL_Strcpy(componentList[totalCompNum].component.componentName, secComponentsTemp[i]->componentName);
+                for (j = 0; j < secComponentsTemp[i]->totalRoleNum; j++)
+                    SEC_OSAL_Strcpy(componentList[totalCompNum].component.roles[j], secComponentsTemp[i]->roles[j]);
+                componentList[totalCompNum].component.totalRoleNum = secComponentsTemp[i]->totalRoleNum;
+
+                SEC_OSAL_Strcpy(componentList[totalCompNum].libName, libName);
+
+                totalCompNum++;
+            }
+            for (i = 0; i < componentNum; i++) {
+                SEC_OSAL_Free(secComponentsTemp[i]);
+            }
+
+            SEC_OSAL_Free(secComponentsTemp);
+        } else {
+            if ((errorMsg = SEC_OSAL_dlerror()) != NULL)
+                SEC_OSAL_Log(SEC_LOG_WARNING, "dlsym failed: %s", errorMsg);
+        }
+        SEC_OSAL_dlclose(soHandle);
+    } else {
+        SEC_OSAL_Log(SEC_LOG_WARNING, "dlopen failed: %s", SEC_OSAL_dlerror());
+    }
+
+    return totalCompNum;
+}
 
 OMX_ERRORTYPE SEC_OMX_Component_Register(SEC_OMX_COMPONENT_REGLIST **compList, OMX_U32 *compNum)
 {
     OMX_ERRORTYPE  ret = OMX_ErrorNone;
-    int            componentNum = 0, roleNum = 0, totalCompNum = 0;
+    int            totalCompNum = 0;
     int            read;
     char          *omxregistryfile = NULL;
     char          *line = NULL;
-    char          *libName;
+    char          *libName, *componentName, *roles;
+    char          *savePtr = NULL;
     FILE          *omxregistryfp;
     size_t         len;
-    OMX_HANDLETYPE soHandle;
-    const char    *errorMsg;
-    int (*SEC_OMX_COMPONENT_Library_Register)(SECRegisterComponentType **secComponents);
-    SECRegisterComponentType **secComponentsTemp;
     SEC_OMX_COMPONENT_REGLIST *componentList;
 
     FunctionIn();
@@ -71,69 +198,43 @@ OMX_ERRORTYPE SEC_OMX_Component_Register(SEC_OMX_COMPONENT_REGLIST **compList, O
     SEC_OSAL_Strcat(omxregistryfile, REGISTRY_FILENAME);
 
     omxregistryfp = fopen(omxregistryfile, "r");
+    SEC_OSAL_Free(omxregistryfile);
     if (omxregistryfp == NULL) {
         ret = OMX_ErrorUndefined;
         goto EXIT;
     }
-    SEC_OSAL_Free(omxregistryfile);
 
     fseek(omxregistryfp, 0, 0);
     componentList = (SEC_OMX_COMPONENT_REGLIST *)SEC_OSAL_Malloc(sizeof(SEC_OMX_COMPONENT_REGLIST) * MAX_OMX_COMPONENT_NUM);
     SEC_OSAL_Memset(componentList, 0, sizeof(SEC_OMX_COMPONENT_REGLIST) * MAX_OMX_COMPONENT_NUM);
-    libName = SEC_OSAL_Malloc(MAX_OMX_COMPONENT_LIBNAME_SIZE);
-
-    while ((read = getline(&line, &len, omxregistryfp)) != -1) {
-        if ((*line == 'l') && (*(line + 1) == 'i') && (*(line + 2) == 'b') &&
-            (*(line + 3) == 'O') && (*(line + 4) == 'M') && (*(line + 5) == 'X')) {
-            SEC_OSAL_Memset(libName, 0, MAX_OMX_COMPONENT_LIBNAME_SIZE);
-            SEC_OSAL_Strncpy(libName, line, SEC_OSAL_Strlen(line)-1);
-            SEC_OSAL_Log(SEC_LOG_TRACE, "libName : %s", libName);
-
-            if ((soHandle = SEC_OSAL_dlopen(libName, RTLD_NOW)) != NULL) {
-                SEC_OSAL_dlerror();    /* clear error*/
-                if ((SEC_OMX_COMPONENT_Library_Register = SEC_OSAL_dlsym(soHandle, "SEC_OMX_COMPONENT_Library_Register")) != NULL) {
-                    int i = 0, j = 0;
-
-                    componentNum = (*SEC_OMX_COMPONENT_Library_Register)(NULL);
-                    secComponentsTemp = (SECRegisterComponentType **)SEC_OSAL_Malloc(sizeof(SECRegisterComponentType*) * componentNum);
-                    for (i = 0; i < componentNum; i++) {
-                        secComponentsTemp[i] = SEC_OSAL_Malloc(sizeof(SECRegisterComponentType));
-                        SEC_OSAL_Memset(secComponentsTemp[i], 0, sizeof(SECRegisterComponentType));
-                    }
-                    (*SEC_OMX_COMPONENT_Library_Register)(secComponentsTemp);
-
-                    for (i = 0; i < componentNum; i++) {
-                        SEC_OSAL_Strcpy(componentList[totalCompNum].component.componentName, secComponentsTemp[i]->componentName);
-                        for (j = 0; j < secComponentsTemp[i]->totalRoleNum; j++)
-                            SEC_OSAL_Strcpy(componentList[totalCompNum].component.roles[j], secComponentsTemp[i]->roles[j]);
-                        componentList[totalCompNum].component.totalRoleNum = secComponentsTemp[i]->totalRoleNum;
-
-                        SEC_OSAL_Strcpy(componentList[totalCompNum].libName, libName);
-
-                        totalCompNum++;
-                    }
-                    for (i = 0; i < componentNum; i++) {
-                        SEC_OSAL_Free(secComponentsTemp[i]);
-                    }
-
-                    SEC_OSAL_Free(secComponentsTemp);
-                } else {
-                    if ((errorMsg = SEC_OSAL_dlerror()) != NULL)
-                        SEC_OSAL_Log(SEC_LOG_WARNING, "dlsym failed: %s", errorMsg);
-                }
-                SEC_OSAL_dlclose(soHandle);
-            } else {
-                SEC_OSAL_Log(SEC_LOG_WARNING, "dlopen failed: %s", SEC_OSAL_dlerror());
-            }
-        } else {
+
+    while (((read = getline(&line, &len, omxregistryfp)) != -1) &&
+           (totalCompNum < MAX_OMX_COMPONENT_NUM)) {
+        libName = strtok_r(line, REGISTRY_DELIMITER, &savePtr);
+        if ((libName == NULL) || (strncmp(libName, "libOMX", 6) != 0)) {
             /* not a component name line. skip */
             continue;
         }
+        SEC_OSAL_Log(SEC_LOG_TRACE, "libName : %s", libName);
+
+        componentName = strtok_r(NULL, REGISTRY_DELIMITER, &savePtr);
+        if (componentName != NULL) {
+            roles = strtok_r(NULL, REGISTRY_DELIMITER, &savePtr);
+            if (SEC_OMX_Registry_AddManifestEntry(&componentList[totalCompNum], libName, componentName, roles) == OMX_ErrorNone)
+                totalCompNum++;
+            else
+                SEC_OSAL_Log(SEC_LOG_WARNING, "bad registry entry: %s %s", libName, componentName);
+        } else {
+            totalCompNum = SEC_OMX_Registry_AddLibrary(componentList, totalCompNum, libName);
+        }
     }
 
-    SEC_OSAL_Free(libName);
+    if (line != NULL)
+        free(line);
     fclose(omxregistryfp);
 
+    SEC_OMX_Registry_BuildHash(componentList, totalCompNum);
+
     *compList = componentList;
     *compNum = totalCompNum;
 
@@ -147,6 +248,9 @@ OMX_ERRORTYPE SEC_OMX_Component_Unregister(SEC_OMX_COMPONENT_REGLIST *componentL
 {
     OMX_ERRORTYPE ret = OMX_ErrorNone;
 
+    SEC_OSAL_Memset(gNameHash, 0, sizeof(gNameHash));
+    SEC_OSAL_Memset(gRoleHash, 0, sizeof(gRoleHash));
+
     SEC_OSAL_Memset(componentList, 0, sizeof(SEC_OMX_COMPONENT_REGLIST) * MAX_OMX_COMPONENT_NUM);
     SEC_OSAL_Free(componentList);
 
@@ -154,6 +258,48 @@ EXIT:
     return ret;
 }
 
+OMX_S32 SEC_OMX_Component_FindName(SEC_OMX_COMPONENT_REGLIST *componentList, OMX_STRING componentName)
+{
+    OMX_U32 slot = 0;
+
+    if ((componentList == NULL) || (componentName == NULL))
+        return -1;
+
+    slot = SEC_OMX_Registry_Hash(componentName) & (REGISTRY_NAME_HASH_SIZE - 1);
+    while (gNameHash[slot] != 0) {
+        if (SEC_OSAL_Strcmp(componentList[gNameHash[slot] - 1].component.componentName, componentName) == 0)
+            return (OMX_S32)(gNameHash[slot] - 1);
+        slot = (slot + 1) & (REGISTRY_NAME_HASH_SIZE - 1);
+    }
+
+    return -1;
+}
+
+OMX_U32 SEC_OMX_Component_FindRole(SEC_OMX_COMPONENT_REGLIST *componentList, OMX_STRING role, OMX_U32 *pCompIndex, OMX_U32 maxNum)
+{
+    OMX_U32 slot = 0, found = 0;
+    OMX_U32 compIndex = 0, roleIndex = 0, i = 0;
+
+    if ((componentList == NULL) || (role == NULL))
+        return 0;
+
+    slot = SEC_OMX_Registry_Hash(role) & (REGISTRY_ROLE_HASH_SIZE - 1);
+    while ((gRoleHash[slot] != 0) && (found < maxNum)) {
+        compIndex = (gRoleHash[slot] - 1) >> 8;
+        roleIndex = (gRoleHash[slot] - 1) & 0xFF;
+        if (SEC_OSAL_Strcmp(componentList[compIndex].component.roles[roleIndex], role) == 0) {
+            /* keep registry order, callers pick the first match */
+            for (i = found; (i > 0) && (pCompIndex[i - 1] > compIndex); i--)
+                pCompIndex[i] = pCompIndex[i - 1];
+            pCompIndex[i] = compIndex;
+            found++;
+        }
+        slot = (slot + 1) & (REGISTRY_ROLE_HASH_SIZE - 1);
+    }
+
+    return found;
+}
+
 OMX_ERRORTYPE SEC_OMX_ComponentAPICheck(OMX_COMPONENTTYPE component)
 {
     OMX_ERRORTYPE ret = OMX_ErrorNone;
@@ -64,6 +64,8 @@ extern "C" {
 
 OMX_ERRORTYPE SEC_OMX_Component_Register(SEC_OMX_COMPONENT_REGLIST **compList, OMX_U32 *compNum);
 OMX_ERRORTYPE SEC_OMX_Component_Unregister(SEC_OMX_COMPONENT_REGLIST *componentList);
+OMX_S32       SEC_OMX_Component_FindName(SEC_OMX_COMPONENT_REGLIST *componentList, OMX_STRING componentName);
+OMX_U32       SEC_OMX_Component_FindRole(SEC_OMX_COMPONENT_REGLIST *componentList, OMX_STRING role, OMX_U32 *pCompIndex, OMX_U32 maxNum);
 OMX_ERRORTYPE SEC_OMX_ComponentLoad(SEC_OMX_COMPONENT *sec_component);
 OMX_ERRORTYPE SEC_OMX_ComponentUnload(SEC_OMX_COMPONENT *sec_component);
 
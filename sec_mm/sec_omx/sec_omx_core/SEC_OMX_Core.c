@@ -48,9 +48,35 @@ static int gInitialized = 0;
 static OMX_U32 gComponentNum = 0;
 
 static SEC_OMX_COMPONENT_REGLIST *gComponentList = NULL;
-static SEC_OMX_COMPONENT *gLoadComponentList = NULL;
 static pthread_mutex_t ghLoadComponentListMutex = PTHREAD_MUTEX_INITIALIZER;
 
+/*
+ * Live handles are spread over stripes by handle address, so GetHandle and
+ * FreeHandle from different media server threads rarely share a lock.
+ * The registry itself is read only between Init and Deinit.
+ */
+#define LOAD_COMPONENT_STRIPE_NUM 8
+
+typedef struct _SEC_OMX_LOAD_STRIPE
+{
+    pthread_mutex_t    mutex;
+    SEC_OMX_COMPONENT *list;
+} SEC_OMX_LOAD_STRIPE;
+
+static SEC_OMX_LOAD_STRIPE gLoadComponentStripe[LOAD_COMPONENT_STRIPE_NUM] = {
+    { PTHREAD_MUTEX_INITIALIZER, NULL }, { PTHREAD_MUTEX_INITIALIZER, NULL },
+    { PTHREAD_MUTEX_INITIALIZER, NULL }, { PTHREAD_MUTEX_INITIALIZER, NULL },
+    { PTHREAD_MUTEX_INITIALIZER, NULL }, { PTHREAD_MUTEX_INITIALIZER, NULL },
+    { PTHREAD_MUTEX_INITIALIZER, NULL }, { PTHREAD_MUTEX_INITIALIZER, NULL },
+};
+
+static inline SEC_OMX_LOAD_STRIPE *SEC_OMX_GetLoadStripe(OMX_HANDLETYPE hComponent)
+{
+    unsigned long key = (unsigned long)hComponent;
+
+    return &gLoadComponentStripe[((key >> 4) ^ (key >> 12)) & (LOAD_COMPONENT_STRIPE_NUM - 1)];
+}
+
 
 OMX_API OMX_ERRORTYPE OMX_APIENTRY SEC_OMX_Init(void)
 {
@@ -140,9 +166,9 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY SEC_OMX_GetHandle(
     OMX_IN  OMX_PTR pAppData,
     OMX_IN  OMX_CALLBACKTYPE *pCallBacks)
 {
-    OMX_ERRORTYPE      ret = OMX_ErrorNone;
-    SEC_OMX_COMPONENT *loadComponent;
-    SEC_OMX_COMPONENT *currentComponent;
+    OMX_ERRORTYPE        ret = OMX_ErrorNone;
+    SEC_OMX_COMPONENT   *loadComponent;
+    SEC_OMX_LOAD_STRIPE *stripe;
 
     FunctionIn();
 
@@ -157,49 +183,41 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY SEC_OMX_GetHandle(
     }
     SEC_OSAL_Log(SEC_LOG_TRACE, "ComponentName : %s", cComponentName);
 
-    OMX_U32 i = 0;
-    for (i = 0; i < gComponentNum; i++) {
-        if (SEC_OSAL_Strcmp(cComponentName, gComponentList[i].component.componentName) == 0) {
-            loadComponent = SEC_OSAL_Malloc(sizeof(SEC_OMX_COMPONENT));
-            SEC_OSAL_Memset(loadComponent, 0, sizeof(SEC_OMX_COMPONENT));
-
-            SEC_OSAL_Strcpy(loadComponent->libName, gComponentList[i].libName);
-            SEC_OSAL_Strcpy(loadComponent->componentName, gComponentList[i].component.componentName);
-            ret = SEC_OMX_ComponentLoad(loadComponent);
-            if (ret != OMX_ErrorNone) {
-                SEC_OSAL_Free(loadComponent);
-                SEC_OSAL_Log(SEC_LOG_ERROR, "OMX_Error, Line:%d", __LINE__);
-                goto EXIT;
-            }
-
-            ret = loadComponent->pOMXComponent->SetCallbacks(loadComponent->pOMXComponent, pCallBacks, pAppData);
-            if (ret != OMX_ErrorNone) {
-                SEC_OMX_ComponentUnload(loadComponent);
-                SEC_OSAL_Free(loadComponent);
-                SEC_OSAL_Log(SEC_LOG_ERROR, "OMX_Error, Line:%d", __LINE__);
-                goto EXIT;
-            }
-
-            SEC_OSAL_MutexLock(&ghLoadComponentListMutex);
-            if (gLoadComponentList == NULL) {
-                gLoadComponentList = loadComponent;
-            } else {
-                currentComponent = gLoadComponentList;
-                while (currentComponent->nextOMXComp != NULL) {
-                    currentComponent = currentComponent->nextOMXComp;
-                }
-                currentComponent->nextOMXComp = loadComponent;
-            }
-            SEC_OSAL_MutexUnlock(&ghLoadComponentListMutex);
-
-            *pHandle = loadComponent->pOMXComponent;
-            ret = OMX_ErrorNone;
-            SEC_OSAL_Log(SEC_LOG_TRACE, "SEC_OMX_GetHandle : %s", "OMX_ErrorNone");
-            goto EXIT;
-        }
+    OMX_S32 i = SEC_OMX_Component_FindName(gComponentList, cComponentName);
+    if (i < 0) {
+        ret = OMX_ErrorComponentNotFound;
+        goto EXIT;
+    }
+
+    loadComponent = SEC_OSAL_Malloc(sizeof(SEC_OMX_COMPONENT));
+    SEC_OSAL_Memset(loadComponent, 0, sizeof(SEC_OMX_COMPONENT));
+
+    SEC_OSAL_Strcpy(loadComponent->libName, gComponentList[i].libName);
+    SEC_OSAL_Strcpy(loadComponent->componentName, gComponentList[i].component.componentName);
+    ret = SEC_OMX_ComponentLoad(loadComponent);
+    if (ret != OMX_ErrorNone) {
+        SEC_OSAL_Free(loadComponent);
+        SEC_OSAL_Log(SEC_LOG_ERROR, "OMX_Error, Line:%d", __LINE__);
+        goto EXIT;
+    }
+
+    ret = loadComponent->pOMXComponent->SetCallbacks(loadComponent->pOMXComponent, pCallBacks, pAppData);
+    if (ret != OMX_ErrorNone) {
+        SEC_OMX_ComponentUnload(loadComponent);
+        SEC_OSAL_Free(loadComponent);
+        SEC_OSAL_Log(SEC_LOG_ERROR, "OMX_Error, Line:%d", __LINE__);
+        goto EXIT;
     }
 
-    ret = OMX_ErrorComponentNotFound;
+    stripe = SEC_OMX_GetLoadStripe(loadComponent->pOMXComponent);
+    SEC_OSAL_MutexLock(&stripe->mutex);
+    loadComponent->nextOMXComp = (struct SEC_OMX_COMPONENT *)stripe->list;
+    stripe->list = loadComponent;
+    SEC_OSAL_MutexUnlock(&stripe->mutex);
+
+    *pHandle = loadComponent->pOMXComponent;
+    ret = OMX_ErrorNone;
+    SEC_OSAL_Log(SEC_LOG_TRACE, "SEC_OMX_GetHandle : %s", "OMX_ErrorNone");
 
 EXIT:
     FunctionOut();
@@ -209,9 +227,10 @@ EXIT:
 
 OMX_API OMX_ERRORTYPE OMX_APIENTRY SEC_OMX_FreeHandle(OMX_IN OMX_HANDLETYPE hComponent)
 {
-    OMX_ERRORTYPE      ret = OMX_ErrorNone;
-    SEC_OMX_COMPONENT *currentComponent;
-    SEC_OMX_COMPONENT *deleteComponent;
+    OMX_ERRORTYPE        ret = OMX_ErrorNone;
+    SEC_OMX_COMPONENT  **ppComponent;
+    SEC_OMX_COMPONENT   *deleteComponent = NULL;
+    SEC_OMX_LOAD_STRIPE *stripe;
 
     FunctionIn();
 
@@ -225,29 +244,28 @@ OMX_API OMX_ERRORTYPE OMX_APIENTRY SEC_OMX_FreeHandle(OMX_IN OMX_HANDLETYPE hCom
         goto EXIT;
     }
 
-    SEC_OSAL_MutexLock(&ghLoadComponentListMutex);
-    currentComponent = gLoadComponentList;
-    if (gLoadComponentList->pOMXComponent == hComponent) {
-        deleteComponent = gLoadComponentList;
-        gLoadComponentList = gLoadComponentList->nextOMXComp;
-    } else {
-        while ((currentComponent != NULL) && (((SEC_OMX_COMPONENT *)(currentComponent->nextOMXComp))->pOMXComponent != hComponent))
-            currentComponent = currentComponent->nextOMXComp;
-
-        if (((SEC_OMX_COMPONENT *)(currentComponent->nextOMXComp))->pOMXComponent == hComponent) {
-            deleteComponent = currentComponent->nextOMXComp;
-            currentComponent->nextOMXComp = deleteComponent->nextOMXComp;
-        } else if (currentComponent == NULL) {
-            ret = OMX_ErrorComponentNotFound;
-            goto EXIT;
+    stripe = SEC_OMX_GetLoadStripe(hComponent);
+    SEC_OSAL_MutexLock(&stripe->mutex);
+    for (ppComponent = &stripe->list; *ppComponent != NULL;
+         ppComponent = (SEC_OMX_COMPONENT **)&(*ppComponent)->nextOMXComp) {
+        if ((*ppComponent)->pOMXComponent == hComponent) {
+            deleteComponent = *ppComponent;
+            *ppComponent = (SEC_OMX_COMPONENT *)deleteComponent->nextOMXComp;
+            break;
         }
     }
+    SEC_OSAL_MutexUnlock(&stripe->mutex);
 
+    if (deleteComponent == NULL) {
+        ret = OMX_ErrorComponentNotFound;
+        goto EXIT;
+    }
+
+    /* the component deinit and dlclose run without holding any core lock */
     SEC_OMX_ComponentUnload(deleteComponent);
     SEC_OSAL_Free(deleteComponent);
 
 EXIT:
-    SEC_OSAL_MutexUnlock(&ghLoadComponentListMutex);
     FunctionOut();
 
     return ret;
@@ -281,9 +299,8 @@ OMX_API OMX_ERRORTYPE SEC_OMX_GetComponentsOfRole (
     OMX_INOUT OMX_U8  **compNames)
 {
     OMX_ERRORTYPE ret = OMX_ErrorNone;
-    int           max_role_num = 0;
-    OMX_STRING    RoleString[MAX_OMX_COMPONENT_ROLE_SIZE];
-    int i = 0, j = 0;
+    OMX_U32       compIndex[MAX_OMX_COMPONENT_NUM];
+    int i = 0;
 
     FunctionIn();
 
@@ -292,19 +309,11 @@ OMX_API OMX_ERRORTYPE SEC_OMX_GetComponentsOfRole (
         goto EXIT;
     }
 
-    *pNumComps = 0;
-
-    for (i = 0; i < MAX_OMX_COMPONENT_NUM; i++) {
-        max_role_num = gComponentList[i].component.totalRoleNum;
+    *pNumComps = SEC_OMX_Component_FindRole(gComponentList, role, compIndex, MAX_OMX_COMPONENT_NUM);
 
-        for (j = 0; j < max_role_num; j++) {
-            if (SEC_OSAL_Strcmp(gComponentList[i].component.roles[j], role) == 0) {
-                if (compNames != NULL) {
-                    SEC_OSAL_Strcpy((OMX_STRING)compNames[*pNumComps], gComponentList[i].component.componentName);
-                }
-                *pNumComps = (*pNumComps + 1);
-            }
-        }
+    if (compNames != NULL) {
+        for (i = 0; i < (int)*pNumComps; i++)
+            SEC_OSAL_Strcpy((OMX_STRING)compNames[i], gComponentList[compIndex[i]].component.componentName);
     }
 
 EXIT:
@@ -330,18 +339,15 @@ OMX_API OMX_ERRORTYPE SEC_OMX_GetRolesOfComponent (
         goto EXIT;
     }
 
-    for (i = 0; i < MAX_OMX_COMPONENT_NUM; i++) {
-        if (gComponentList != NULL) {
-            if (SEC_OSAL_Strcmp(gComponentList[i].component.componentName, compName) == 0) {
-                *pNumRoles = totalRoleNum = gComponentList[i].component.totalRoleNum;
-                compNum = i;
-                detectComp = OMX_TRUE;
-                break;
-            }
-        } else {
-            ret = OMX_ErrorUndefined;
-            goto EXIT;
-        }
+    if (gComponentList == NULL) {
+        ret = OMX_ErrorUndefined;
+        goto EXIT;
+    }
+
+    compNum = SEC_OMX_Component_FindName(gComponentList, compName);
+    if (compNum >= 0) {
+        *pNumRoles = totalRoleNum = gComponentList[compNum].component.totalRoleNum;
+        detectComp = OMX_TRUE;
     }
 
     if (detectComp == OMX_FALSE) {
@@ -0,0 +1,31 @@
+#!/bin/sh
+#
+# Writes secomxregistry to stdout from the component register headers.
+#
+# usage: gen_secomxregistry.sh <library>:<library_register.h> ...
+#
+# Each SEC_OMX_COMPONENT_<X> "<name>" define in a header becomes a line
+#   <library>.so <name> <role>
+# with the role taken from SEC_OMX_COMPONENT_<X>_ROLE.
+
+echo "# generated from the component library_register.h headers, do not edit"
+echo "# <library> <component name> <role>[,<role>...]"
+
+for entry in "$@"; do
+    lib=${entry%%:*}
+    header=${entry#*:}
+    defines=$(sed -n 's/^#define[ \t]*SEC_OMX_COMPONENT_\([A-Z0-9_]*\)[ \t]*"\(.*\)".*$/\1 \2/p' "$header")
+    echo "$defines" | while read id name; do
+        case $id in
+        *_ROLE|"")
+            continue
+            ;;
+        esac
+        role=$(echo "$defines" | sed -n "s/^${id}_ROLE //p")
+        if [ -z "$role" ]; then
+            echo "$header: no role for $name" >&2
+            exit 1
+        fi
+        echo "$lib.so $name $role"
+    done || exit 1
+done
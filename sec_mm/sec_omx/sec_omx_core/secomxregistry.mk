@@ -0,0 +1,19 @@
+# secomxregistry, generated from the library_register.h of every component
+# that added itself to SEC_OMX_REGISTRY_LIBS
+include $(CLEAR_VARS)
+
+LOCAL_MODULE := secomxregistry
+LOCAL_MODULE_TAGS := optional
+LOCAL_MODULE_CLASS := ETC
+LOCAL_MODULE_PATH := $(TARGET_OUT_ETC)
+
+include $(BUILD_SYSTEM)/base_rules.mk
+
+SEC_OMX_REGISTRY_GEN := $(SEC_OMX_TOP)/sec_omx_core/gen_secomxregistry.sh
+
+$(LOCAL_BUILT_MODULE): PRIVATE_LIBS := $(SEC_OMX_REGISTRY_LIBS)
+$(LOCAL_BUILT_MODULE): PRIVATE_GEN := $(SEC_OMX_REGISTRY_GEN)
+$(LOCAL_BUILT_MODULE): $(SEC_OMX_REGISTRY_GEN) $(foreach lib,$(SEC_OMX_REGISTRY_LIBS),$(word 2,$(subst :, ,$(lib))))
+	@echo "Generate: $@"
+	@mkdir -p $(dir $@)
+	$(hide) sh $(PRIVATE_GEN) $(PRIVATE_LIBS) > $@
@@ -67,6 +67,14 @@ typedef enum _SEC_OMX_INDEXTYPE
 {
 #define SEC_INDEX_PARAM_ENABLE_THUMBNAIL "OMX.SEC.index.ThumbnailMode"
     OMX_IndexVendorThumbnailMode        = 0x7F000001,
+#define SEC_INDEX_CONFIG_THUMBNAIL_SCALE "OMX.SEC.index.ThumbnailScale"
+    OMX_IndexVendorThumbnailScale       = 0x7F000002,
+#define SEC_INDEX_CONFIG_LOW_LATENCY "OMX.SEC.index.LowLatencyMode"
+    OMX_IndexVendorLowLatencyMode       = 0x7F000003,
+#define SEC_INDEX_CONFIG_PERF_STATS "OMX.SEC.index.PerfStats"
+    OMX_IndexVendorPerfStats            = 0x7F000004,
+#define SEC_INDEX_PARAM_SLICE_OUTPUT "OMX.SEC.index.SliceOutput"
+    OMX_IndexVendorSliceOutput          = 0x7F000005,
 
     /* for Android Native Window */
 #define SEC_INDEX_PARAM_ENABLE_ANB "OMX.google.android.index.enableAndroidNativeBuffers"
@@ -78,6 +86,9 @@ typedef enum _SEC_OMX_INDEXTYPE
     /* for Android Store Metadata Inbuffer */
 #define SEC_INDEX_PARAM_STORE_METADATA_BUFFER "OMX.google.android.index.storeMetaDataInBuffers"
     OMX_IndexParamStoreMetaDataBuffer     = 0x7F000014,
+    /* for Android adaptive playback */
+#define SEC_INDEX_PARAM_PREPARE_ADAPTIVE_PLAYBACK "OMX.google.android.index.prepareForAdaptivePlayback"
+    OMX_IndexParamPrepareForAdaptivePlayback = 0x7F000015,
 
     /* for Android PV OpenCore*/
     OMX_COMPONENT_CAPABILITY_TYPE_INDEX = 0xFF7A347
@@ -95,7 +106,8 @@ typedef enum _SEC_OMX_COMMANDTYPE
 {
     SEC_OMX_CommandComponentDeInit = 0x7F000001,
     SEC_OMX_CommandEmptyBuffer,
-    SEC_OMX_CommandFillBuffer
+    SEC_OMX_CommandFillBuffer,
+    SEC_OMX_CommandPerfPublish
 } SEC_OMX_COMMANDTYPE;
 
 typedef enum _SEC_OMX_TRANS_STATETYPE {
@@ -115,6 +127,129 @@ typedef enum _SEC_OMX_COLOR_FORMATTYPE {
     OMX_COLOR_FormatAndroidOpaque = 0x7F000789
 }SEC_OMX_COLOR_FORMATTYPE;
 
+/* for OMX_IndexVendorPerfStats */
+#define SEC_OMX_PERF_HISTOGRAM_BINS 16
+#define SEC_OMX_PERF_HISTOGRAM_BASE 64 /* us, bin n holds samples below (BASE << n) */
+
+typedef enum _SEC_OMX_PERF_TIMERTYPE
+{
+    SEC_OMX_PERF_TIMER_CODEC = 0,   /* SsbSipMfcDecExe, SsbSipMfcEncExe */
+    SEC_OMX_PERF_TIMER_CSC,         /* tiled <-> linear conversion */
+    SEC_OMX_PERF_TIMER_CALLBACK,    /* buffer return until the client callback is done */
+    SEC_OMX_PERF_TIMER_NUM
+} SEC_OMX_PERF_TIMERTYPE;
+
+typedef struct _SEC_OMX_PERF_HISTOGRAMTYPE
+{
+    OMX_U32 nCount;
+    OMX_U32 nMaxUs;
+    OMX_U64 nTotalUs;
+    OMX_U32 nBin[SEC_OMX_PERF_HISTOGRAM_BINS];
+} SEC_OMX_PERF_HISTOGRAMTYPE;
+
+typedef struct _SEC_OMX_CONFIG_PERFSTATSTYPE
+{
+    OMX_U32                    nSize;
+    OMX_VERSIONTYPE            nVersion;
+    OMX_U32                    nFramesIn;
+    OMX_U32                    nFramesOut;
+    OMX_U32                    nFramesDropped;
+    OMX_U32                    nFramesLate;     /* codec time longer than the input frame interval */
+    OMX_U32                    nQueueDepth[2];  /* buffers waiting on each port */
+    OMX_U32                    nQueueDepthMax[2];
+    SEC_OMX_PERF_HISTOGRAMTYPE timer[SEC_OMX_PERF_TIMER_NUM];
+} SEC_OMX_CONFIG_PERFSTATSTYPE;
+
+/* published to <debug.sec.omx.perf.dir>/secomx-<pid>-<instance>.perf, read by sec_omx_perfstat */
+#define SEC_OMX_PERF_DIR_PROPERTY "debug.sec.omx.perf.dir"
+
+typedef struct _SEC_OMX_PERF_SNAPSHOTTYPE
+{
+    char                         componentName[MAX_OMX_COMPONENT_NAME_SIZE];
+    SEC_OMX_CONFIG_PERFSTATSTYPE stats;
+} SEC_OMX_PERF_SNAPSHOTTYPE;
+
+/*
+ * Buffer traffic recording, written to <debug.sec.omx.record.dir>/secomx-<pid>-<instance>-<session>.rec
+ * for every Loaded->Idle->Loaded session and replayed by sec_omx_replay.
+ * The file is one SEC_OMX_RECORD_HEADERTYPE followed by SEC_OMX_RECORD_ENTRYTYPE
+ * records. An EmptyThisBuffer record is followed by nFilledLen payload bytes,
+ * none when the input port is marked SEC_OMX_RECORD_PAYLOAD_NONE.
+ */
+#define SEC_OMX_RECORD_DIR_PROPERTY "debug.sec.omx.record.dir"
+#define SEC_OMX_RECORD_MAGIC        0x52584F53 /* "SOXR" */
+#define SEC_OMX_RECORD_VERSION      2
+
+typedef enum _SEC_OMX_RECORD_EVENTTYPE
+{
+    SEC_OMX_RECORD_EMPTY_BUFFER = 0,
+    SEC_OMX_RECORD_FILL_BUFFER
+} SEC_OMX_RECORD_EVENTTYPE;
+
+/* what the buffers of a port carry; only frame data can be replayed */
+typedef enum _SEC_OMX_RECORD_PAYLOADTYPE
+{
+    SEC_OMX_RECORD_PAYLOAD_DATA = 0,
+    SEC_OMX_RECORD_PAYLOAD_NONE     /* metadata or physical addresses, not recorded */
+} SEC_OMX_RECORD_PAYLOADTYPE;
+
+typedef struct _SEC_OMX_RECORD_PORTTYPE
+{
+    OMX_U32 nBufferCountActual;
+    OMX_U32 nBufferSize;
+    OMX_U32 nFrameWidth;
+    OMX_U32 nFrameHeight;
+    OMX_U32 nBitrate;
+    OMX_U32 xFramerate;
+    OMX_U32 eCompressionFormat;
+    OMX_U32 eColorFormat;
+    OMX_U32 ePayload;       /* SEC_OMX_RECORD_PAYLOADTYPE */
+} SEC_OMX_RECORD_PORTTYPE;
+
+typedef struct _SEC_OMX_RECORD_HEADERTYPE
+{
+    OMX_U32                 nMagic;
+    OMX_U32                 nVersion;
+    char                    componentName[MAX_OMX_COMPONENT_NAME_SIZE];
+    SEC_OMX_RECORD_PORTTYPE port[2];
+} SEC_OMX_RECORD_HEADERTYPE;
+
+typedef struct _SEC_OMX_RECORD_ENTRYTYPE
+{
+    OMX_U32   eEvent;       /* SEC_OMX_RECORD_EVENTTYPE */
+    OMX_U32   nFilledLen;
+    OMX_U32   nAllocLen;
+    OMX_U32   nFlags;
+    OMX_TICKS nTimeStamp;
+    OMX_U64   nCallUs;      /* time of the call since the session started */
+} SEC_OMX_RECORD_ENTRYTYPE;
+
+/* H.264 encoder multi-slice mode, each slice goes out in its own buffer */
+typedef struct _SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE
+{
+    OMX_U32         nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32         nPortIndex;
+    OMX_BOOL        bEnable;
+    OMX_U32         nSliceMBs;      /* macroblocks per slice, 0 to split by nSliceBytes */
+    OMX_U32         nSliceBytes;    /* maximum slice size in bytes */
+} SEC_OMX_VIDEO_PARAM_SLICEOUTPUTTYPE;
+
+/*
+ * Decoder adaptive playback, laid out like Android's PrepareForAdaptivePlaybackParams.
+ * Output buffers are sized for the maximum frame, so resolution changes up to
+ * it only update the port geometry and crop instead of reallocating buffers.
+ */
+typedef struct _SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE
+{
+    OMX_U32         nSize;
+    OMX_VERSIONTYPE nVersion;
+    OMX_U32         nPortIndex;
+    OMX_BOOL        bEnable;
+    OMX_U32         nMaxFrameWidth;
+    OMX_U32         nMaxFrameHeight;
+} SEC_OMX_VIDEO_PARAM_ADAPTIVEPLAYBACKTYPE;
+
 typedef enum _SEC_OMX_SUPPORTFORMAT_TYPE
 {
     supportFormat_0 = 0x00,
@@ -0,0 +1,18 @@
+LOCAL_PATH := $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SRC_FILES := \
+	SEC_OMX_PerfStat.c
+
+LOCAL_MODULE := sec_omx_perfstat
+
+LOCAL_CFLAGS :=
+
+LOCAL_SHARED_LIBRARIES := libc libcutils
+
+LOCAL_C_INCLUDES := $(SEC_OMX_INC)/khronos \
+	$(SEC_OMX_INC)/sec
+
+include $(BUILD_EXECUTABLE)
@@ -0,0 +1,149 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    SEC_OMX_PerfStat.c
+ * @brief   Dumps the performance snapshots published by SEC OMX components.
+ *          Set debug.sec.omx.perf.dir to a directory writable by the media
+ *          server before the codec is created, then run
+ *          sec_omx_perfstat [-c] [dir]
+ *          -c removes the snapshots after printing them.
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <cutils/properties.h>
+
+#include "OMX_Types.h"
+#include "OMX_Core.h"
+#include "SEC_OMX_Def.h"
+
+static const char *timerName[SEC_OMX_PERF_TIMER_NUM] = {
+    "codec",
+    "csc",
+    "cb",
+};
+
+static void print_histogram(const char *name, SEC_OMX_PERF_HISTOGRAMTYPE *pHistogram)
+{
+    int i;
+
+    if (pHistogram->nCount == 0) {
+        printf("  %-6s no samples\n", name);
+        return;
+    }
+
+    printf("  %-6s count %u, avg %llu us, max %u us\n", name,
+           pHistogram->nCount, pHistogram->nTotalUs / pHistogram->nCount, pHistogram->nMaxUs);
+    for (i = 0; i < SEC_OMX_PERF_HISTOGRAM_BINS; i++) {
+        if (pHistogram->nBin[i] == 0)
+            continue;
+        if (i == (SEC_OMX_PERF_HISTOGRAM_BINS - 1))
+            printf("         >= %7u us : %u\n", SEC_OMX_PERF_HISTOGRAM_BASE << (i - 1), pHistogram->nBin[i]);
+        else
+            printf("         <  %7u us : %u\n", SEC_OMX_PERF_HISTOGRAM_BASE << i, pHistogram->nBin[i]);
+    }
+}
+
+static int print_snapshot(const char *path)
+{
+    SEC_OMX_PERF_SNAPSHOTTYPE snapshot;
+    SEC_OMX_CONFIG_PERFSTATSTYPE *pStats = &snapshot.stats;
+    int fd, i;
+
+    fd = open(path, O_RDONLY);
+    if (fd < 0)
+        return -1;
+    if (read(fd, &snapshot, sizeof(snapshot)) != sizeof(snapshot)) {
+        close(fd);
+        return -1;
+    }
+    close(fd);
+
+    if (pStats->nSize != sizeof(SEC_OMX_CONFIG_PERFSTATSTYPE))
+        return -1;
+
+    snapshot.componentName[MAX_OMX_COMPONENT_NAME_SIZE - 1] = '\0';
+    printf("%s (%s)\n", snapshot.componentName, path);
+    printf("  frames in %u, out %u, dropped %u, late %u\n",
+           pStats->nFramesIn, pStats->nFramesOut, pStats->nFramesDropped, pStats->nFramesLate);
+    printf("  queue  input %u (max %u), output %u (max %u)\n",
+           pStats->nQueueDepth[0], pStats->nQueueDepthMax[0],
+           pStats->nQueueDepth[1], pStats->nQueueDepthMax[1]);
+    for (i = 0; i < SEC_OMX_PERF_TIMER_NUM; i++)
+        print_histogram(timerName[i], &pStats->timer[i]);
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    char dirName[PROPERTY_VALUE_MAX];
+    char path[PROPERTY_VALUE_MAX + 256];
+    struct dirent *entry;
+    DIR *dir;
+    int clean = 0, found = 0;
+    int opt;
+
+    while ((opt = getopt(argc, argv, "c")) != -1) {
+        switch (opt) {
+        case 'c':
+            clean = 1;
+            break;
+        default:
+            fprintf(stderr, "usage: %s [-c] [dir]\n", argv[0]);
+            return 1;
+        }
+    }
+
+    if (optind < argc) {
+        strncpy(dirName, argv[optind], sizeof(dirName) - 1);
+        dirName[sizeof(dirName) - 1] = '\0';
+    } else if (property_get(SEC_OMX_PERF_DIR_PROPERTY, dirName, NULL) <= 0) {
+        fprintf(stderr, "%s is not set and no directory given\n", SEC_OMX_PERF_DIR_PROPERTY);
+        return 1;
+    }
+
+    dir = opendir(dirName);
+    if (dir == NULL) {
+        fprintf(stderr, "cannot open %s\n", dirName);
+        return 1;
+    }
+
+    while ((entry = readdir(dir)) != NULL) {
+        size_t len = strlen(entry->d_name);
+
+        if ((strncmp(entry->d_name, "secomx-", 7) != 0) ||
+            (len < 5) || (strcmp(entry->d_name + len - 5, ".perf") != 0))
+            continue;
+
+        snprintf(path, sizeof(path), "%s/%s", dirName, entry->d_name);
+        if (print_snapshot(path) == 0) {
+            found++;
+            if (clean)
+                unlink(path);
+        }
+    }
+    closedir(dir);
+
+    if (found == 0)
+        printf("no snapshots in %s\n", dirName);
+
+    return 0;
+}
@@ -0,0 +1,19 @@
+LOCAL_PATH := $(call my-dir)
+include $(CLEAR_VARS)
+
+LOCAL_MODULE_TAGS := optional
+
+LOCAL_SRC_FILES := \
+	SEC_OMX_Replay.c
+
+LOCAL_MODULE := sec_omx_replay
+
+LOCAL_CFLAGS :=
+
+LOCAL_SHARED_LIBRARIES := libc libSEC_OMX_Core.aries
+
+LOCAL_C_INCLUDES := $(SEC_OMX_INC)/khronos \
+	$(SEC_OMX_INC)/sec \
+	$(SEC_OMX_TOP)/sec_omx_core
+
+include $(BUILD_EXECUTABLE)
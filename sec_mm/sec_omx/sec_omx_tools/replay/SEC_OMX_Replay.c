@@ -0,0 +1,617 @@
+/*
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+/*
+ * @file    SEC_OMX_Replay.c
+ * @brief   Replays a buffer traffic recording against a SEC OMX component.
+ *          Set debug.sec.omx.record.dir to a directory writable by the media
+ *          server, reproduce the problem, then run
+ *          sec_omx_replay [-r] [-f] [-d] [-c component] file.rec
+ *          -r paces EmptyThisBuffer and FillThisBuffer calls as recorded,
+ *             the default is maximum speed
+ *          -f hands output buffers back as soon as they are returned, so
+ *             the numbers measure the component, not the original client.
+ *             By default they go back in the order the client recycled them.
+ *          -d prints the recording instead of replaying it
+ *          -c replays against another component than the recorded one
+ *          Recordings whose input held metadata or physical addresses
+ *          cannot be replayed, only dumped.
+ * @version 1.0
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <errno.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "OMX_Types.h"
+#include "OMX_Core.h"
+#include "OMX_Component.h"
+#include "SEC_OMX_Def.h"
+#include "SEC_OMX_Core.h"
+
+#define REPLAY_PORT_NUM         2
+#define REPLAY_INPUT_PORT       0
+#define REPLAY_OUTPUT_PORT      1
+#define REPLAY_MAX_BUFFER_NUM   20
+#define REPLAY_PENDING_NUM      64
+#define REPLAY_WAIT_SEC         10
+
+typedef struct _REPLAY_PENDING
+{
+    OMX_TICKS nTimeStamp;
+    OMX_U64   nQueuedUs;
+    int       bValid;
+} REPLAY_PENDING;
+
+typedef struct _REPLAY_CONTEXT
+{
+    pthread_mutex_t       lock;
+    pthread_cond_t        cond;
+
+    OMX_HANDLETYPE        hComponent;
+    OMX_STATETYPE         state;
+    OMX_ERRORTYPE         error;
+    int                   bRunning;
+    int                   bEOS;
+    int                   bEncoder;     /* a frame may span several output buffers */
+    int                   bOutputAsRecorded;
+
+    OMX_BUFFERHEADERTYPE *buffer[REPLAY_PORT_NUM][REPLAY_MAX_BUFFER_NUM];
+    OMX_U32               bufferNum[REPLAY_PORT_NUM];
+    OMX_BUFFERHEADERTYPE *inputFree[REPLAY_MAX_BUFFER_NUM];
+    OMX_U32               inputFreeNum;
+    OMX_BUFFERHEADERTYPE *outputFree[REPLAY_MAX_BUFFER_NUM];
+    OMX_U32               outputFreeNum;
+    OMX_U32               outputCredit; /* recorded FillThisBuffer calls no buffer was free for */
+
+    REPLAY_PENDING        pending[REPLAY_PENDING_NUM];
+    OMX_U32               pendingNext;
+
+    OMX_U32               framesIn;
+    OMX_U32               framesOut;
+    OMX_U64               bytesIn;
+    OMX_U64               bytesOut;
+    OMX_U64               lastOutputUs;
+    OMX_U32              *latencyUs;
+    OMX_U32               latencyNum;
+    OMX_U32               latencyMax;
+} REPLAY_CONTEXT;
+
+static OMX_U64 now_us(void)
+{
+    struct timespec ts;
+
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return ((OMX_U64)ts.tv_sec * 1000000) + (ts.tv_nsec / 1000);
+}
+
+static void add_latency(REPLAY_CONTEXT *pCtx, OMX_U32 latencyUs)
+{
+    OMX_U32 *pGrown = NULL;
+
+    if (pCtx->latencyNum == pCtx->latencyMax) {
+        pGrown = realloc(pCtx->latencyUs, sizeof(OMX_U32) * (pCtx->latencyMax + 1024));
+        if (pGrown == NULL)
+            return;
+        pCtx->latencyUs = pGrown;
+        pCtx->latencyMax += 1024;
+    }
+    pCtx->latencyUs[pCtx->latencyNum++] = latencyUs;
+}
+
+static OMX_ERRORTYPE event_handler(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_EVENTTYPE eEvent,
+                                   OMX_U32 nData1, OMX_U32 nData2, OMX_PTR pEventData)
+{
+    REPLAY_CONTEXT *pCtx = (REPLAY_CONTEXT *)pAppData;
+
+    pthread_mutex_lock(&pCtx->lock);
+    if ((eEvent == OMX_EventCmdComplete) && (nData1 == OMX_CommandStateSet)) {
+        pCtx->state = (OMX_STATETYPE)nData2;
+    } else if (eEvent == OMX_EventError) {
+        fprintf(stderr, "component error 0x%x\n", (unsigned int)nData1);
+        pCtx->error = (OMX_ERRORTYPE)nData1;
+    }
+    pthread_cond_broadcast(&pCtx->cond);
+    pthread_mutex_unlock(&pCtx->lock);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE empty_buffer_done(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE *pBuffer)
+{
+    REPLAY_CONTEXT *pCtx = (REPLAY_CONTEXT *)pAppData;
+
+    pthread_mutex_lock(&pCtx->lock);
+    if (pCtx->inputFreeNum < REPLAY_MAX_BUFFER_NUM)
+        pCtx->inputFree[pCtx->inputFreeNum++] = pBuffer;
+    pthread_cond_broadcast(&pCtx->cond);
+    pthread_mutex_unlock(&pCtx->lock);
+
+    return OMX_ErrorNone;
+}
+
+static OMX_ERRORTYPE fill_buffer_done(OMX_HANDLETYPE hComponent, OMX_PTR pAppData, OMX_BUFFERHEADERTYPE *pBuffer)
+{
+    REPLAY_CONTEXT *pCtx = (REPLAY_CONTEXT *)pAppData;
+    OMX_U64 doneUs = now_us();
+    int refill = 0;
+    int i;
+
+    pthread_mutex_lock(&pCtx->lock);
+    if (pBuffer->nFilledLen > 0)
+        pCtx->bytesOut += pBuffer->nFilledLen;
+    if ((pBuffer->nFilledLen > 0) && !(pBuffer->nFlags & OMX_BUFFERFLAG_CODECCONFIG) &&
+        (!pCtx->bEncoder || (pBuffer->nFlags & OMX_BUFFERFLAG_ENDOFFRAME))) {
+        pCtx->framesOut++;
+        pCtx->lastOutputUs = doneUs;
+        for (i = 0; i < REPLAY_PENDING_NUM; i++) {
+            if (pCtx->pending[i].bValid && (pCtx->pending[i].nTimeStamp == pBuffer->nTimeStamp)) {
+                add_latency(pCtx, (OMX_U32)(doneUs - pCtx->pending[i].nQueuedUs));
+                pCtx->pending[i].bValid = 0;
+                break;
+            }
+        }
+    }
+    if (pBuffer->nFlags & OMX_BUFFERFLAG_EOS) {
+        pCtx->bEOS = 1;
+        pthread_cond_broadcast(&pCtx->cond);
+    } else if (pCtx->bRunning && (!pCtx->bOutputAsRecorded || (pCtx->outputCredit > 0))) {
+        if (pCtx->bOutputAsRecorded)
+            pCtx->outputCredit--;
+        refill = 1;
+    } else if (pCtx->bRunning && (pCtx->outputFreeNum < REPLAY_MAX_BUFFER_NUM)) {
+        /* waits for the next recorded FillThisBuffer */
+        pCtx->outputFree[pCtx->outputFreeNum++] = pBuffer;
+    }
+    pthread_mutex_unlock(&pCtx->lock);
+
+    if (refill) {
+        pBuffer->nFilledLen = 0;
+        pBuffer->nFlags = 0;
+        OMX_FillThisBuffer(hComponent, pBuffer);
+    }
+
+    return OMX_ErrorNone;
+}
+
+static OMX_CALLBACKTYPE replayCallbacks = {
+    event_handler,
+    empty_buffer_done,
+    fill_buffer_done
+};
+
+static int wait_state(REPLAY_CONTEXT *pCtx, OMX_STATETYPE state)
+{
+    struct timespec deadline;
+    int ret = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += REPLAY_WAIT_SEC;
+
+    pthread_mutex_lock(&pCtx->lock);
+    while ((pCtx->state != state) && (pCtx->error == OMX_ErrorNone) && (ret != ETIMEDOUT))
+        ret = pthread_cond_timedwait(&pCtx->cond, &pCtx->lock, &deadline);
+    ret = (pCtx->state == state) ? 0 : -1;
+    pthread_mutex_unlock(&pCtx->lock);
+
+    if (ret != 0)
+        fprintf(stderr, "component did not reach state %d\n", state);
+    return ret;
+}
+
+static OMX_BUFFERHEADERTYPE *get_free_buffer(REPLAY_CONTEXT *pCtx, OMX_BUFFERHEADERTYPE **ppFree, OMX_U32 *pFreeNum)
+{
+    OMX_BUFFERHEADERTYPE *pBuffer = NULL;
+    struct timespec deadline;
+    int ret = 0;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += REPLAY_WAIT_SEC;
+
+    pthread_mutex_lock(&pCtx->lock);
+    while ((*pFreeNum == 0) && (pCtx->error == OMX_ErrorNone) && (ret != ETIMEDOUT))
+        ret = pthread_cond_timedwait(&pCtx->cond, &pCtx->lock, &deadline);
+    if (*pFreeNum > 0)
+        pBuffer = ppFree[--(*pFreeNum)];
+    pthread_mutex_unlock(&pCtx->lock);
+
+    return pBuffer;
+}
+
+static void pace(OMX_U64 startUs, OMX_U64 callUs)
+{
+    OMX_U64 nowUs = now_us();
+
+    if (startUs + callUs > nowUs)
+        usleep((useconds_t)(startUs + callUs - nowUs));
+}
+
+static int cmp_u32(const void *a, const void *b)
+{
+    OMX_U32 x = *(const OMX_U32 *)a;
+    OMX_U32 y = *(const OMX_U32 *)b;
+
+    return (x > y) - (x < y);
+}
+
+static OMX_U32 percentile(OMX_U32 *pSorted, OMX_U32 num, OMX_U32 pct)
+{
+    OMX_U32 idx = (num * pct) / 100;
+
+    if (idx >= num)
+        idx = num - 1;
+    return pSorted[idx];
+}
+
+static int dump_recording(int fd, SEC_OMX_RECORD_HEADERTYPE *pHeader)
+{
+    SEC_OMX_RECORD_ENTRYTYPE entry;
+    int i;
+
+    printf("%s\n", pHeader->componentName);
+    for (i = 0; i < REPLAY_PORT_NUM; i++) {
+        printf("  port %d: %ux%u, %u buffers of %u, compression %u, color 0x%x, bitrate %u%s\n", i,
+               pHeader->port[i].nFrameWidth, pHeader->port[i].nFrameHeight,
+               pHeader->port[i].nBufferCountActual, pHeader->port[i].nBufferSize,
+               pHeader->port[i].eCompressionFormat, pHeader->port[i].eColorFormat,
+               pHeader->port[i].nBitrate,
+               (pHeader->port[i].ePayload == SEC_OMX_RECORD_PAYLOAD_NONE) ? ", payload not recorded" : "");
+    }
+
+    while (read(fd, &entry, sizeof(entry)) == sizeof(entry)) {
+        printf("%10llu us %s len %7u alloc %7u flags 0x%08x ts %lld\n",
+               entry.nCallUs, (entry.eEvent == SEC_OMX_RECORD_EMPTY_BUFFER) ? "ETB" : "FTB",
+               entry.nFilledLen, entry.nAllocLen, entry.nFlags, entry.nTimeStamp);
+        if ((entry.nFilledLen > 0) && (lseek(fd, entry.nFilledLen, SEEK_CUR) < 0))
+            return -1;
+    }
+
+    return 0;
+}
+
+static int configure_ports(REPLAY_CONTEXT *pCtx, SEC_OMX_RECORD_HEADERTYPE *pHeader)
+{
+    OMX_PARAM_PORTDEFINITIONTYPE portDefinition;
+    SEC_OMX_RECORD_PORTTYPE *pPort = NULL;
+    int i;
+
+    for (i = 0; i < REPLAY_PORT_NUM; i++) {
+        pPort = &pHeader->port[i];
+
+        memset(&portDefinition, 0, sizeof(portDefinition));
+        portDefinition.nSize = sizeof(portDefinition);
+        portDefinition.nVersion.s.nVersionMajor = VERSIONMAJOR_NUMBER;
+        portDefinition.nVersion.s.nVersionMinor = VERSIONMINOR_NUMBER;
+        portDefinition.nPortIndex = i;
+        if (OMX_GetParameter(pCtx->hComponent, OMX_IndexParamPortDefinition, &portDefinition) != OMX_ErrorNone)
+            return -1;
+
+        if (pPort->nBufferCountActual > portDefinition.nBufferCountMin)
+            portDefinition.nBufferCountActual = pPort->nBufferCountActual;
+        if (portDefinition.nBufferCountActual > REPLAY_MAX_BUFFER_NUM)
+            portDefinition.nBufferCountActual = REPLAY_MAX_BUFFER_NUM;
+        if (pPort->nBufferSize > portDefinition.nBufferSize)
+            portDefinition.nBufferSize = pPort->nBufferSize;
+        portDefinition.format.video.nFrameWidth        = pPort->nFrameWidth;
+        portDefinition.format.video.nFrameHeight       = pPort->nFrameHeight;
+        portDefinition.format.video.nBitrate           = pPort->nBitrate;
+        portDefinition.format.video.xFramerate         = pPort->xFramerate;
+        portDefinition.format.video.eCompressionFormat = (OMX_VIDEO_CODINGTYPE)pPort->eCompressionFormat;
+        portDefinition.format.video.eColorFormat       = (OMX_COLOR_FORMATTYPE)pPort->eColorFormat;
+        if (OMX_SetParameter(pCtx->hComponent, OMX_IndexParamPortDefinition, &portDefinition) != OMX_ErrorNone)
+            return -1;
+
+        /* the component may have rounded sizes up */
+        if (OMX_GetParameter(pCtx->hComponent, OMX_IndexParamPortDefinition, &portDefinition) != OMX_ErrorNone)
+            return -1;
+        pCtx->bufferNum[i] = portDefinition.nBufferCountActual;
+        if (pCtx->bufferNum[i] > REPLAY_MAX_BUFFER_NUM)
+            return -1;
+        pPort->nBufferSize = portDefinition.nBufferSize;
+    }
+
+    return 0;
+}
+
+static int allocate_buffers(REPLAY_CONTEXT *pCtx, SEC_OMX_RECORD_HEADERTYPE *pHeader)
+{
+    OMX_U32 i, j;
+
+    for (i = 0; i < REPLAY_PORT_NUM; i++) {
+        for (j = 0; j < pCtx->bufferNum[i]; j++) {
+            if (OMX_AllocateBuffer(pCtx->hComponent, &pCtx->buffer[i][j], i, pCtx,
+                                   pHeader->port[i].nBufferSize) != OMX_ErrorNone) {
+                fprintf(stderr, "AllocateBuffer failed, port %u\n", i);
+                return -1;
+            }
+            if (i == REPLAY_INPUT_PORT)
+                pCtx->inputFree[pCtx->inputFreeNum++] = pCtx->buffer[i][j];
+        }
+    }
+
+    return 0;
+}
+
+static void free_buffers(REPLAY_CONTEXT *pCtx)
+{
+    OMX_U32 i, j;
+
+    for (i = 0; i < REPLAY_PORT_NUM; i++) {
+        for (j = 0; j < pCtx->bufferNum[i]; j++) {
+            if (pCtx->buffer[i][j] != NULL)
+                OMX_FreeBuffer(pCtx->hComponent, i, pCtx->buffer[i][j]);
+            pCtx->buffer[i][j] = NULL;
+        }
+    }
+}
+
+static int replay(int fd, REPLAY_CONTEXT *pCtx, SEC_OMX_RECORD_HEADERTYPE *pHeader, int bRealTime)
+{
+    SEC_OMX_RECORD_ENTRYTYPE entry;
+    OMX_BUFFERHEADERTYPE *pBuffer = NULL;
+    OMX_BUFFERHEADERTYPE *pDrain[REPLAY_MAX_BUFFER_NUM];
+    OMX_U64 startUs = 0;
+    OMX_U32 copyLen = 0;
+    OMX_U32 primeNum = pHeader->port[REPLAY_OUTPUT_PORT].nBufferCountActual;
+    OMX_U32 drainNum = 0;
+    struct timespec deadline;
+    int bSentEOS = 0;
+    int ret = 0;
+    OMX_U32 i;
+
+    pthread_mutex_lock(&pCtx->lock);
+    pCtx->bRunning = 1;
+    pthread_mutex_unlock(&pCtx->lock);
+    for (i = 0; i < pCtx->bufferNum[REPLAY_OUTPUT_PORT]; i++)
+        OMX_FillThisBuffer(pCtx->hComponent, pCtx->buffer[REPLAY_OUTPUT_PORT][i]);
+
+    startUs = now_us();
+    while (read(fd, &entry, sizeof(entry)) == sizeof(entry)) {
+        if (entry.eEvent == SEC_OMX_RECORD_FILL_BUFFER) {
+            /* the client's first round only primed the port, done above */
+            if (primeNum > 0) {
+                primeNum--;
+                continue;
+            }
+            if (!pCtx->bOutputAsRecorded)
+                continue;
+
+            if (bRealTime)
+                pace(startUs, entry.nCallUs);
+            /* the replay may run ahead of the recording, the buffer then goes back when it returns */
+            pBuffer = NULL;
+            pthread_mutex_lock(&pCtx->lock);
+            if (pCtx->outputFreeNum > 0)
+                pBuffer = pCtx->outputFree[--pCtx->outputFreeNum];
+            else
+                pCtx->outputCredit++;
+            pthread_mutex_unlock(&pCtx->lock);
+            if (pBuffer != NULL) {
+                pBuffer->nFilledLen = 0;
+                pBuffer->nFlags = 0;
+                OMX_FillThisBuffer(pCtx->hComponent, pBuffer);
+            }
+            continue;
+        }
+
+        pBuffer = get_free_buffer(pCtx, pCtx->inputFree, &pCtx->inputFreeNum);
+        if (pBuffer == NULL) {
+            fprintf(stderr, "no input buffer came back\n");
+            return -1;
+        }
+
+        copyLen = entry.nFilledLen;
+        if (copyLen > pBuffer->nAllocLen) {
+            fprintf(stderr, "payload of %u truncated to %u\n", copyLen, (unsigned int)pBuffer->nAllocLen);
+            copyLen = pBuffer->nAllocLen;
+        }
+        if ((copyLen > 0) && (read(fd, pBuffer->pBuffer, copyLen) != (ssize_t)copyLen))
+            return -1;
+        if ((entry.nFilledLen > copyLen) && (lseek(fd, entry.nFilledLen - copyLen, SEEK_CUR) < 0))
+            return -1;
+
+        pBuffer->nOffset    = 0;
+        pBuffer->nFilledLen = copyLen;
+        pBuffer->nFlags     = entry.nFlags;
+        pBuffer->nTimeStamp = entry.nTimeStamp;
+
+        if (bRealTime)
+            pace(startUs, entry.nCallUs);
+
+        pthread_mutex_lock(&pCtx->lock);
+        if ((copyLen > 0) && !(entry.nFlags & OMX_BUFFERFLAG_CODECCONFIG)) {
+            pCtx->framesIn++;
+            pCtx->pending[pCtx->pendingNext].nTimeStamp = entry.nTimeStamp;
+            pCtx->pending[pCtx->pendingNext].nQueuedUs = now_us();
+            pCtx->pending[pCtx->pendingNext].bValid = 1;
+            pCtx->pendingNext = (pCtx->pendingNext + 1) % REPLAY_PENDING_NUM;
+        }
+        pCtx->bytesIn += copyLen;
+        pthread_mutex_unlock(&pCtx->lock);
+
+        if (entry.nFlags & OMX_BUFFERFLAG_EOS)
+            bSentEOS = 1;
+        OMX_EmptyThisBuffer(pCtx->hComponent, pBuffer);
+        if (bSentEOS)
+            break;
+    }
+
+    /* the recording is used up, let the output drain freely */
+    pthread_mutex_lock(&pCtx->lock);
+    pCtx->bOutputAsRecorded = 0;
+    while (pCtx->outputFreeNum > 0)
+        pDrain[drainNum++] = pCtx->outputFree[--pCtx->outputFreeNum];
+    pthread_mutex_unlock(&pCtx->lock);
+    for (i = 0; i < drainNum; i++) {
+        pDrain[i]->nFilledLen = 0;
+        pDrain[i]->nFlags = 0;
+        OMX_FillThisBuffer(pCtx->hComponent, pDrain[i]);
+    }
+
+    if (!bSentEOS) {
+        /* the recording stopped mid-stream, close it so the output drains */
+        pBuffer = get_free_buffer(pCtx, pCtx->inputFree, &pCtx->inputFreeNum);
+        if (pBuffer != NULL) {
+            pBuffer->nOffset = 0;
+            pBuffer->nFilledLen = 0;
+            pBuffer->nFlags = OMX_BUFFERFLAG_EOS;
+            OMX_EmptyThisBuffer(pCtx->hComponent, pBuffer);
+        }
+    }
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += REPLAY_WAIT_SEC;
+    pthread_mutex_lock(&pCtx->lock);
+    while (!pCtx->bEOS && (pCtx->error == OMX_ErrorNone) && (ret != ETIMEDOUT))
+        ret = pthread_cond_timedwait(&pCtx->cond, &pCtx->lock, &deadline);
+    if (!pCtx->bEOS)
+        fprintf(stderr, "no EOS on the output\n");
+    pCtx->bRunning = 0;
+    if (pCtx->lastOutputUs == 0)
+        pCtx->lastOutputUs = now_us();
+    pthread_mutex_unlock(&pCtx->lock);
+
+    printf("frames in %u, out %u\n", pCtx->framesIn, pCtx->framesOut);
+    printf("bytes in %llu, out %llu\n", pCtx->bytesIn, pCtx->bytesOut);
+    if (pCtx->lastOutputUs > startUs) {
+        OMX_U64 elapsedUs = pCtx->lastOutputUs - startUs;
+        printf("elapsed %llu us, %.2f frames/s\n", elapsedUs,
+               ((double)pCtx->framesOut * 1000000) / (double)elapsedUs);
+    }
+    if (pCtx->latencyNum > 0) {
+        qsort(pCtx->latencyUs, pCtx->latencyNum, sizeof(OMX_U32), cmp_u32);
+        printf("latency us: p50 %u, p90 %u, p99 %u, max %u (%u samples)\n",
+               percentile(pCtx->latencyUs, pCtx->latencyNum, 50),
+               percentile(pCtx->latencyUs, pCtx->latencyNum, 90),
+               percentile(pCtx->latencyUs, pCtx->latencyNum, 99),
+               pCtx->latencyUs[pCtx->latencyNum - 1], pCtx->latencyNum);
+    }
+
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    SEC_OMX_RECORD_HEADERTYPE header;
+    REPLAY_CONTEXT ctx;
+    char *componentName = NULL;
+    int bRealTime = 0, bDump = 0, bFreeOutput = 0;
+    int fd = -1, opt, ret = 1;
+
+    while ((opt = getopt(argc, argv, "rfdc:")) != -1) {
+        switch (opt) {
+        case 'r':
+            bRealTime = 1;
+            break;
+        case 'f':
+            bFreeOutput = 1;
+            break;
+        case 'd':
+            bDump = 1;
+            break;
+        case 'c':
+            componentName = optarg;
+            break;
+        default:
+            optind = argc;
+            break;
+        }
+    }
+    if (optind != (argc - 1)) {
+        fprintf(stderr, "usage: %s [-r] [-f] [-d] [-c component] file.rec\n", argv[0]);
+        return 1;
+    }
+
+    fd = open(argv[optind], O_RDONLY);
+    if (fd < 0) {
+        fprintf(stderr, "cannot open %s\n", argv[optind]);
+        return 1;
+    }
+    if ((read(fd, &header, sizeof(header)) != sizeof(header)) ||
+        (header.nMagic != SEC_OMX_RECORD_MAGIC) || (header.nVersion != SEC_OMX_RECORD_VERSION)) {
+        fprintf(stderr, "%s is not a recording of this version\n", argv[optind]);
+        close(fd);
+        return 1;
+    }
+    header.componentName[MAX_OMX_COMPONENT_NAME_SIZE - 1] = '\0';
+    if (componentName == NULL)
+        componentName = header.componentName;
+
+    if (bDump) {
+        ret = dump_recording(fd, &header);
+        close(fd);
+        return (ret == 0) ? 0 : 1;
+    }
+    if (header.port[REPLAY_INPUT_PORT].ePayload != SEC_OMX_RECORD_PAYLOAD_DATA) {
+        fprintf(stderr, "%s holds no input frames, the input carried metadata or physical addresses\n", argv[optind]);
+        close(fd);
+        return 1;
+    }
+
+    memset(&ctx, 0, sizeof(ctx));
+    pthread_mutex_init(&ctx.lock, NULL);
+    pthread_cond_init(&ctx.cond, NULL);
+    ctx.state = OMX_StateLoaded;
+    ctx.bEncoder = (header.port[REPLAY_INPUT_PORT].eCompressionFormat == OMX_VIDEO_CodingUnused);
+    ctx.bOutputAsRecorded = !bFreeOutput;
+
+    if (SEC_OMX_Init() != OMX_ErrorNone) {
+        fprintf(stderr, "OMX core init failed\n");
+        goto EXIT_FILE;
+    }
+    if (SEC_OMX_GetHandle(&ctx.hComponent, componentName, &ctx, &replayCallbacks) != OMX_ErrorNone) {
+        fprintf(stderr, "cannot get %s\n", componentName);
+        goto EXIT_CORE;
+    }
+    if (configure_ports(&ctx, &header) != 0) {
+        fprintf(stderr, "cannot configure %s as recorded\n", componentName);
+        goto EXIT_HANDLE;
+    }
+
+    OMX_SendCommand(ctx.hComponent, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    if ((allocate_buffers(&ctx, &header) != 0) || (wait_state(&ctx, OMX_StateIdle) != 0))
+        goto EXIT_BUFFERS;
+    OMX_SendCommand(ctx.hComponent, OMX_CommandStateSet, OMX_StateExecuting, NULL);
+    if (wait_state(&ctx, OMX_StateExecuting) != 0)
+        goto EXIT_IDLE;
+
+    printf("%s, %s, output %s\n", componentName, bRealTime ? "recorded pace" : "maximum speed",
+           bFreeOutput ? "returned at once" : "returned as recorded");
+    if (replay(fd, &ctx, &header, bRealTime) == 0)
+        ret = 0;
+
+    OMX_SendCommand(ctx.hComponent, OMX_CommandStateSet, OMX_StateIdle, NULL);
+    wait_state(&ctx, OMX_StateIdle);
+EXIT_IDLE:
+    OMX_SendCommand(ctx.hComponent, OMX_CommandStateSet, OMX_StateLoaded, NULL);
+EXIT_BUFFERS:
+    free_buffers(&ctx);
+    wait_state(&ctx, OMX_StateLoaded);
+EXIT_HANDLE:
+    SEC_OMX_FreeHandle(ctx.hComponent);
+EXIT_CORE:
+    SEC_OMX_Deinit();
+EXIT_FILE:
+    close(fd);
+    free(ctx.latencyUs);
+    pthread_cond_destroy(&ctx.cond);
+    pthread_mutex_destroy(&ctx.lock);
+
+    return ret;
+}
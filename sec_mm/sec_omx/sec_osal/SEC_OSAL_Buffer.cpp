@@ -108,16 +108,86 @@ OMX_U32 getMetadataBufferType(const uint8_t *ptr)
     return type;
 }
 
-OMX_U32 getVADDRfromANB(OMX_PTR pUnreadableBuffer, OMX_U32 Width, OMX_U32 Height, void *pVirAddrs[])
+static SEC_OMX_ANB_MAP *findANBMap(SEC_OMX_BASEPORT *pSECPort, OMX_PTR pUnreadableBuffer)
+{
+    int i;
+
+    if (pUnreadableBuffer == NULL)
+        return NULL;
+
+    for (i = 0; i < MAX_BUFFER_NUM; i++) {
+        if (pSECPort->anbMap[i].pANB == pUnreadableBuffer)
+            return &pSECPort->anbMap[i];
+    }
+
+    return NULL;
+}
+
+static void mapANB(SEC_OMX_ANB_MAP *pMap, OMX_PTR pUnreadableBuffer)
+{
+    android_native_buffer_t *buf = (android_native_buffer_t *)pUnreadableBuffer;
+    GraphicBufferMapper &mapper = GraphicBufferMapper::get();
+    Rect bounds(buf->width, buf->height);
+    void *pVirAddrs[3] = { NULL, NULL, NULL };
+    int err = 0;
+
+    FunctionIn();
+
+    SEC_OSAL_Memset(pMap, 0, sizeof(SEC_OMX_ANB_MAP));
+
+    err = mapper.lock(buf->handle, GRALLOC_USAGE_SW_WRITE_OFTEN, bounds, pVirAddrs);
+    if (err != 0) {
+        /* not fatal, the buffer is then locked for every frame */
+        SEC_OSAL_Log(SEC_LOG_WARNING, "mapper.lock Error, Error code:%d", err);
+        goto EXIT;
+    }
+
+    pMap->pANB = pUnreadableBuffer;
+    pMap->pVirAddrs[0] = pVirAddrs[0];
+    pMap->pVirAddrs[1] = pVirAddrs[1];
+    SEC_OSAL_Log(SEC_LOG_TRACE, "mapped ANB:0x%x, Y:0x%x, CbCr:0x%x",
+                                pUnreadableBuffer, pVirAddrs[0], pVirAddrs[1]);
+
+EXIT:
+    FunctionOut();
+
+    return;
+}
+
+static void unmapANB(SEC_OMX_ANB_MAP *pMap)
+{
+    android_native_buffer_t *buf = (android_native_buffer_t *)pMap->pANB;
+    GraphicBufferMapper &mapper = GraphicBufferMapper::get();
+
+    FunctionIn();
+
+    mapper.unlock(buf->handle);
+    SEC_OSAL_Memset(pMap, 0, sizeof(SEC_OMX_ANB_MAP));
+
+    FunctionOut();
+
+    return;
+}
+
+OMX_U32 getVADDRfromANB(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer, OMX_U32 Width, OMX_U32 Height, void *pVirAddrs[])
 {
     OMX_U32 ret = 0;
+    SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_OMX_ANB_MAP *pMap = NULL;
     android_native_buffer_t *buf;
-    void *readableBuffer;
     GraphicBufferMapper &mapper = GraphicBufferMapper::get();
     Rect bounds(Width, Height);
 
     FunctionIn();
 
+    pSECComponent = (SEC_OMX_BASECOMPONENT *)((OMX_COMPONENTTYPE *)hComponent)->pComponentPrivate;
+    pMap = findANBMap(&pSECComponent->pSECPort[nPortIndex], pUnreadableBuffer);
+    if (pMap != NULL) {
+        pVirAddrs[0] = pMap->pVirAddrs[0];
+        pVirAddrs[1] = pMap->pVirAddrs[1];
+        goto EXIT;
+    }
+
     buf = (android_native_buffer_t *)pUnreadableBuffer;
     SEC_OSAL_Log(SEC_LOG_TRACE, "pUnreadableBuffer:0x%x, buf:0x%x, buf->handle:0x%x",
                                 pUnreadableBuffer, buf, buf->handle);
@@ -126,20 +196,28 @@ OMX_U32 getVADDRfromANB(OMX_PTR pUnreadableBuffer, OMX_U32 Width, OMX_U32 Height
     if (ret != 0) {
         SEC_OSAL_Log(SEC_LOG_ERROR, "mapper.lock Error, Error code:%d", ret);
     }
+
+EXIT:
     FunctionOut();
 
     return ret;
 }
 
-OMX_U32 putVADDRtoANB(OMX_PTR pUnreadableBuffer)
+OMX_U32 putVADDRtoANB(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer)
 {
+    SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
     android_native_buffer_t *buf;
-    void *readableBuffer;
-    int ret = 0;
     GraphicBufferMapper &mapper = GraphicBufferMapper::get();
 
     FunctionIn();
 
+    pSECComponent = (SEC_OMX_BASECOMPONENT *)((OMX_COMPONENTTYPE *)hComponent)->pComponentPrivate;
+    if (findANBMap(&pSECComponent->pSECPort[nPortIndex], pUnreadableBuffer) != NULL) {
+        /* stays locked until freeAndroidNativeBuffer */
+        FunctionOut();
+        return 0;
+    }
+
     buf = (android_native_buffer_t *)pUnreadableBuffer;
 
     FunctionOut();
@@ -147,6 +225,40 @@ OMX_U32 putVADDRtoANB(OMX_PTR pUnreadableBuffer)
     return mapper.unlock(buf->handle);
 }
 
+OMX_ERRORTYPE freeAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer)
+{
+    OMX_ERRORTYPE          ret = OMX_ErrorNone;
+    OMX_COMPONENTTYPE     *pOMXComponent = NULL;
+    SEC_OMX_BASECOMPONENT *pSECComponent = NULL;
+    SEC_OMX_ANB_MAP       *pMap = NULL;
+
+    FunctionIn();
+
+    if (hComponent == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+    pOMXComponent = (OMX_COMPONENTTYPE *)hComponent;
+    if (pOMXComponent->pComponentPrivate == NULL) {
+        ret = OMX_ErrorBadParameter;
+        goto EXIT;
+    }
+    pSECComponent = (SEC_OMX_BASECOMPONENT *)pOMXComponent->pComponentPrivate;
+    if (nPortIndex >= pSECComponent->portParam.nPorts) {
+        ret = OMX_ErrorBadPortIndex;
+        goto EXIT;
+    }
+
+    pMap = findANBMap(&pSECComponent->pSECPort[nPortIndex], pUnreadableBuffer);
+    if (pMap != NULL)
+        unmapANB(pMap);
+
+EXIT:
+    FunctionOut();
+
+    return ret;
+}
+
 OMX_ERRORTYPE enableAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_PTR ComponentParameterStructure)
 {
     OMX_ERRORTYPE          ret = OMX_ErrorNone;
@@ -274,6 +386,8 @@ OMX_ERRORTYPE UseBufferANB(
             else
                 temp_bufferHeader->nOutputPortIndex = OUTPUT_PORT_INDEX;
 
+            mapANB(&pSECPort->anbMap[i], pBuffer);
+
             pSECPort->assignedBufferNum++;
             if (pSECPort->assignedBufferNum == pSECPort->portDefinition.nBufferCountActual) {
                 pSECPort->portDefinition.bPopulated = OMX_TRUE;
@@ -32,6 +32,7 @@
 extern "C" {
 #endif
 
+#include <stdint.h>
 #include "OMX_Types.h"
 
 typedef struct {
@@ -50,8 +51,9 @@ OMX_U32 getMetadataBufferType(const uint8_t *ptr);
 OMX_ERRORTYPE enableAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_PTR ComponentParameterStructure);
 OMX_ERRORTYPE getAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_PTR ComponentParameterStructure);
 OMX_ERRORTYPE useAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_PTR ComponentParameterStructure);
-OMX_U32 getVADDRfromANB(OMX_PTR pUnreadableBuffer, OMX_U32 Width, OMX_U32 Height, void *vaddress[]);
-OMX_U32 putVADDRtoANB(OMX_PTR pUnreadableBuffer);
+OMX_ERRORTYPE freeAndroidNativeBuffer(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer);
+OMX_U32 getVADDRfromANB(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer, OMX_U32 Width, OMX_U32 Height, void *vaddress[]);
+OMX_U32 putVADDRtoANB(OMX_HANDLETYPE hComponent, OMX_U32 nPortIndex, OMX_PTR pUnreadableBuffer);
 OMX_ERRORTYPE enableStoreMetaDataInBuffers(OMX_HANDLETYPE hComponent, OMX_PTR ComponentParameterStructure);
 OMX_BOOL isMetadataBufferTypeGrallocSource(OMX_BYTE pInputDataBuffer);
 OMX_ERRORTYPE preprocessMetaDataInBuffers(OMX_HANDLETYPE hComponent, OMX_BYTE pInputDataBuffer, BUFFER_ADDRESS_INFO *pInputInfo);